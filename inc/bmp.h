@@ -132,6 +132,13 @@
 #define BMP_FB0ENDTILEINDEX     (BMP_FB0TILEINDEX + (BMP_CELLWIDTH * BMP_CELLHEIGHT))
 #define BMP_FB1ENDTILEINDEX     (BMP_FB1TILEINDEX + (BMP_CELLWIDTH * BMP_CELLHEIGHT))
 
+/**
+ *  \brief
+ *          Maximum number of covered span per scanline for the span buffer (see #BMP_initSpanBuffer(..)).<br>
+ *          When a scanline has no more room, a new span is merged with the closest one so pixels in between are considered as covered.
+ */
+#define BMP_SB_MAXSPAN          16
+
 #define BMP_BASETILE            (BMP_BASETILEINDEX * 32)
 #define BMP_FB0TILE             (BMP_FB0TILEINDEX * 32)
 #define BMP_FB1TILE             (BMP_FB1TILEINDEX * 32)
@@ -155,6 +162,9 @@
  *      Palette data.
  *  \param image
  *      Image data, array size = (w * h / 2).
+ *
+ *      The compression field also contains the image data layout (see #BITMAP_TILED), use #BITMAP_COMPRESSION_MASK
+ *      to get the compression type.
  */
 typedef struct
 {
@@ -165,6 +175,18 @@ typedef struct
     const u8 *image;
 } Bitmap;
 
+/**
+ *  \brief
+ *      Bitmap compression field flag: image data is stored in 8x8 tiles order (see rescomp BITMAP TILED option)
+ *      and is uploaded as it is in VRAM by VDP_drawBitmap(..), BMP_xxx methods require linear pixel rows.
+ */
+#define BITMAP_TILED                0x8000
+/**
+ *  \brief
+ *      Bitmap compression field mask to get the compression type.
+ */
+#define BITMAP_COMPRESSION_MASK     0x00FF
+
 /**
  *  \brief
  *          Pixel definition.
@@ -254,9 +276,12 @@ extern u8 *bmp_buffer_write;
  *      0 = low priority (default).<br>
  *      1 = high priority.
  *
+ *  \return
+ *      FALSE if extended blank is enabled (both modes use H-Int processing so they are exclusive, see VDP_setExtendedVBlank(..)).
+ *
  * Requires ~41 KB of memory which is dynamically allocated.
  */
-void BMP_init(u16 double_buffer, VDPPlan plan, u16 palette, u16 priority);
+u16 BMP_init(u16 double_buffer, VDPPlan plan, u16 palette, u16 priority);
 /**
  *  \brief
  *      End the software bitmap engine.
@@ -283,6 +308,21 @@ void BMP_reset();
  * By default buffer copy is disabled for obvious performance reason.
  */
 void BMP_setBufferCopy(u16 value);
+/**
+ *  \brief
+ *      Enable DMA transfer mode for bitmap buffer.
+ *
+ * By default the bitmap buffer is sent to video memory by the CPU (through VDP data port) during the extended blank period.<br>
+ * When DMA transfer is enabled the bitmap buffer is converted to tile order at flip time then sent through the DMA queue,
+ * queue is flushed at bottom border (display disabled) and the number of tile rows queued per frame is computed from
+ * available blank time (minus the pending DMA queue size).<br>
+ * DMA is much faster than CPU so the bitmap can be refreshed more often (up to 30 FPS in NTSC and 50 FPS in PAL) and the
+ * write buffer is always preserved (as with buffer copy enabled) but the read buffer is stored in tile order
+ * (see #BMP_getReadPointer(..)).<br>
+ * Conversion is done by BMP_flip(..) itself (never in interrupt) so in this mode BMP_flip(..) first waits for the
+ * previous flip to complete, async flag only avoids waiting for the new one.
+ */
+void BMP_setDMATransfer(u16 value);
 /**
  *  \brief
  *      Flip bitmap buffer to screen.
@@ -338,7 +378,8 @@ u8*  BMP_getWritePointer(u16 x, u16 y);
  *      Y pixel coordinate.
  *
  * As coordinates are expressed for 4bpp pixel BMP_getReadPointer(0,0)
- * and BMP_getReadPointer(1,0) actually returns the same address.
+ * and BMP_getReadPointer(1,0) actually returns the same address.<br>
+ * Note that read buffer is stored in tile order when DMA transfer mode is enabled (see #BMP_setDMATransfer(..)).
  */
 u8*  BMP_getReadPointer(u16 x, u16 y);
 
@@ -559,6 +600,58 @@ u16 BMP_isPolygonCulled(const Vect2D_s16 *pts, u16 num);
  */
 u16 BMP_drawPolygon(const Vect2D_s16 *pts, u16 num, u8 col);
 
+/**
+ *  \brief
+ *      Initialize the span buffer polygon renderer.<br>
+ *      The span buffer keeps trace of covered pixels on each scanline so polygons submitted with
+ *      #BMP_submitPolygon(..) are drawn from front to back and only visible pixels are written (no overdraw).
+ *
+ *  \param maxPolygon
+ *      Maximum number of polygon which can be submitted before calling #BMP_flushPolygons().
+ *  \return
+ *      FALSE if there is not enough memory to allocate span buffer.
+ *
+ * Requires about 5 KB of memory (plus 26 bytes per polygon) which is dynamically allocated.<br>
+ * Span buffer is automatically released on #BMP_end().
+ */
+u16 BMP_initSpanBuffer(u16 maxPolygon);
+/**
+ *  \brief
+ *      Release the span buffer polygon renderer.
+ */
+void BMP_endSpanBuffer();
+/**
+ *  \brief
+ *      Submit a polygon to the span buffer.<br>
+ *      The polygon points should be defined in clockwise order.<br>
+ *      Polygon points are copied so the buffer can be reused immediately.<br>
+ *      Use the BMP_isPolygonCulled(..) method to test if polygon should be submitted or not.
+ *
+ *  \param pts
+ *      Polygon points buffer.
+ *  \param num
+ *      number of point (lenght of points buffer).
+ *  \param col
+ *      fill color.
+ *  \param z
+ *      polygon depth, lower value means closer polygon (drawn first).
+ *  \return
+ *      FALSE if the span buffer is full (polygon is ignored).
+ *  \see BMP_flushPolygons()
+ */
+u16 BMP_submitPolygon(const Vect2D_s16 *pts, u16 num, u8 col, s16 z);
+/**
+ *  \brief
+ *      Draw all submitted polygons from front to back in the current write buffer.<br>
+ *      Each polygon is clipped per scanline against already covered spans so only visible pixels are written.<br>
+ *      Polygon list and coverage are reset after the operation.
+ *
+ *  \return
+ *      number of polygon which had at least one visible pixel.
+ *  \see BMP_submitPolygon(..)
+ */
+u16 BMP_flushPolygons();
+
 /**
  *  \brief
  *      Draw the specified 4BPP bitmap data.
@@ -597,7 +690,8 @@ void BMP_drawBitmapData(const u8 *data, u16 x, u16 y, u16 w, u16 h, u32 pitch);
  *  \param loadpal
  *      Load the bitmap palette information when non zero.
  *  \return
- *      FALSE if there is not enough memory to unpack the specified Bitmap (only if compression was enabled).
+ *      FALSE if there is not enough memory to unpack the specified Bitmap (only if compression was enabled)
+ *      or if the Bitmap uses the tiled layout.
  *
  * X coordinate is aligned to even value for performance reason.<br>
  * So BMP_drawBitmap(bitmap,0,0,TRUE) will produce same result as BMP_drawBitmap(bitmap,1,0,TRUE)
@@ -625,7 +719,8 @@ u16 BMP_drawBitmap(const Bitmap *bitmap, u16 x, u16 y, u16 loadpal);
  *  \param loadpal
  *      Load the bitmap palette information when non zero.
  *  \return
- *      FALSE if there is not enough memory to unpack the specified Bitmap (only if compression was enabled).
+ *      FALSE if there is not enough memory to unpack the specified Bitmap (only if compression was enabled)
+ *      or if the Bitmap uses the tiled layout.
  *
  * X coordinate as width are aligned to even values for performance reason.<br>
  * So BMP_drawBitmapScaled(bitmap,0,0,w,h,pal) will produce same result as BMP_drawBitmapScaled(bitmap,1,0,w,h,pal)
@@ -43,6 +43,28 @@
  */
 #define FAT16_SUPPORT       0
 
+/**
+ *  \brief
+ *      Set it to 1 to use the segregated fit VRAM allocator for the sprite engine VRAM region (see VRAM_createRegionEx(..)).<br>
+ *      Sprite VRAM allocation and release are done in constant time and fragment less, this cost 4 bytes of RAM per tile
+ *      of the sprite VRAM region (1.5 KB for the default 384 tiles).
+ */
+#define SPR_FAST_VRAM_ALLOC 0
+
+/**
+ *  \brief
+ *      Set it to 1 to enable the zone profiler (see PROF_begin() / PROF_end() in prof.h).<br>
+ *      When set to 0 the profiling macros (including the ones used inside the library) compile to nothing.
+ */
+#define ENABLE_PROFILER     0
+
+/**
+ *  \brief
+ *      Set it to 1 to enable Z80 BUS request statistics (see Z80_getBusStats(..) in z80_ctrl.h).<br>
+ *      It adds a bit of overhead (H/V counter read) on each Z80 BUS request / release.
+ */
+#define Z80_BUS_STATS       0
+
 /**
  *  \brief
  *      Set it to 1 if you want to have the kit intro logo
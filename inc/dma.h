@@ -50,15 +50,15 @@ typedef enum
 typedef struct
 {
     u32 regLen;         // ((len | (len << 8)) & 0xFF00FF) | 0x94009300;
-    u32 regAddrMStep;   // (((addr << 7) & 0xFF0000) | 0x96008F00) + step;
-    u32 regAddrHAddrL;  // ((addr >> 1) & 0x7F00FF) | 0x97009500;
+    u32 regAddrMStep;   // (((addr << 7) & 0xFF0000) | 0x96008F00) + step;  (fill: (value << 16) | 0x8F00 | step)
+    u32 regAddrHAddrL;  // ((addr >> 1) & 0x7F00FF) | 0x97009500;  (fill: 0x97809500, copy: 0x97C09500 | (from & 0xFF))
     u32 regCtrlWrite;   // GFX_DMA_VRAMCOPY_ADDR(to)
 } DMAOpInfo;
 
 
 /**
  *  \brief
- *      DMA queue structure
+ *      DMA queue structure (ring buffer, operations are sent by DMA_flushQueue() once committed by the last queue unlock)
  */
 extern DMAOpInfo *dmaQueues;
 
@@ -155,6 +155,46 @@ void DMA_clearQueue();
  */
 void DMA_flushQueue();
 
+/**
+ *  \brief
+ *      Lock the DMA queue so operations added from now can't be processed by DMA_flushQueue() (calls can be nested).
+ *
+ *      The DMA queue is a ring buffer: new operations are added after the ones not yet sent and committed when the queue
+ *      is unlocked by publishing the last operation identifier, DMA_flushQueue() only sends committed operations.<br>
+ *      Use the lock when several operations have to be sent at the same VBlank (sprite table and sprite tiles for instance):
+ *      if VBlank happens while the queue is locked, only operations added since the lock are postponed to next DMA_flushQueue() call.<br>
+ *      Adding or committing operations never masks interrupts (single writer on each side of the ring buffer) so it doesn't add
+ *      interrupt latency like SYS_disableInts() does.<br>
+ *      DMA_queueDma(..) uses it internally so you don't need to lock the queue to add a single operation.
+ *
+ *  \see DMA_unlockQueue()
+ */
+void DMA_lockQueue();
+/**
+ *  \brief
+ *      Unlock the DMA queue (see DMA_lockQueue()), operations added while it was locked are committed on last unlock.
+ */
+void DMA_unlockQueue();
+/**
+ *  \brief
+ *      Returns TRUE if the DMA queue is currently locked (see DMA_lockQueue()).
+ */
+u16 DMA_isQueueLocked();
+/**
+ *  \brief
+ *      Returns the identifier of the last operation added to the DMA queue (wraps around).
+ *
+ *  \see DMA_isOpDone()
+ */
+u16 DMA_getQueueOpId();
+/**
+ *  \brief
+ *      Returns TRUE if the DMA queue operation with the given identifier (see DMA_getQueueOpId()) and all operations added
+ *      before it have been sent (or dropped, see DMA_setIgnoreOverCapacity() and DMA_clearQueue()).<br>
+ *      Operations postponed because of the transfer capacity limit are not done so source buffer should be kept until then.
+ */
+u16 DMA_isOpDone(u16 id);
+
 /**
  *  \brief
  *      Returns the number of transfer currently pending in the DMA queue.
@@ -194,6 +234,48 @@ u32 DMA_getQueueTransferSize();
  *  \see DMA_do(..)
  */
 u16 DMA_queueDma(u8 location, u32 from, u16 to, u16 len, u16 step);
+/**
+ *  \brief
+ *      Queues a VRAM DMA fill operation in the DMA queue.<br>
+ *      Operations are processed in queue order by DMA_flushQueue() which only waits for fill completion
+ *      when another operation follows it.
+ *
+ *  \param to
+ *      Destination address.
+ *  \param len
+ *      Number of byte to fill (minimum is 2 for even addr destination and 3 for odd addr destination).<br>
+ *      A value of 0 mean 0x10000.
+ *  \param value
+ *      Fill value (byte).
+ *  \param step
+ *      VRAM address increment step after each write.<br>
+ *      should be 1 for a classic fill operation but you can use different value for specific operation.
+ *  \return
+ *      FALSE if the operation failed (queue is full)
+ *  \see DMA_doVRamFill(..)
+ */
+u16 DMA_queueVRamFill(u16 to, u16 len, u8 value, u16 step);
+/**
+ *  \brief
+ *      Queues a VRAM DMA copy operation in the DMA queue.<br>
+ *      Operations are processed in queue order by DMA_flushQueue() which only waits for copy completion
+ *      when another operation follows it.<br>
+ *      As a copy is about twice slower than a normal transfer, it counts for 2 * <i>len</i> in the queue transfer size.
+ *
+ *  \param from
+ *      Source address.
+ *  \param to
+ *      Destination address.
+ *  \param len
+ *      Number of byte to copy.
+ *  \param step
+ *      VRAM address increment step after each write.<br>
+ *      should be 1 for a classic copy operation but you can use different value for specific operation.
+ *  \return
+ *      FALSE if the operation failed (queue is full)
+ *  \see DMA_doVRamCopy(..)
+ */
+u16 DMA_queueVRamCopy(u16 from, u16 to, u16 len, u16 step);
 /**
  *  \brief
  *      Do DMA transfer operation immediately
@@ -86,6 +86,11 @@ u8 evd_mmcInit();
 u8 evd_mmcRdBlock(u32 mmc_addr, u8 *stor);
 
 
+//read num contiguous blocks (num * 512b) from SD/MMC card with a single multi-block read command. mmc_addr should be multiple to 512
+//will return 0 success
+u8 evd_mmcRdBlocks(u32 mmc_addr, u8 *stor, u16 num);
+
+
 //write block (512b) to SD/MMC card. mmc_addr should be multiple to 512
 //will return 0 success
 u8 evd_mmcWrBlock(u32 mmc_addr, u8 *data_ptr);
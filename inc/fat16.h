@@ -56,6 +56,12 @@ typedef struct {
     volatile u16 size;
 } Fat16Dir;
 
+//run of contiguous clusters in a file cluster chain
+typedef struct {
+    u16 cluster;
+    u16 num;
+} Fat16Extent;
+
 typedef struct {
     Fat16Record *record;
     u8 sectror_buff[512];
@@ -63,6 +69,9 @@ typedef struct {
     u32 pos;
     u32 addr_buff;
     u8 sector;
+    Fat16Extent *extents;
+    u16 extent_num;
+    u16 extent_idx;
 } Fat16File;
 
 
@@ -77,6 +86,23 @@ u8 fat16WriteNextSector(Fat16File *file);
 u8 fat16DeleteRecord(Fat16Record *rec);
 u8 fat16CreateRecord(Fat16Record *rec, Fat16Dir *dir);
 u8 fat16SkipSectors(Fat16File *file, u16 num);
+
+//build in-RAM cache of the file cluster chain (run-length extents) in the given buffer.
+//sequential reads then never read the FAT table and seek becomes O(extents).
+//buffer should stay valid while the file is used, will return 3 if more than max extents are needed (cache not used)
+//will return 0 success
+u8 fat16BuildExtents(Fat16File *file, Fat16Extent *extents, u16 max);
+
+//set file position, pos is rounded down to sector (512 bytes) boundary
+//uses the extents cache when built, otherwise follows the cluster chain
+//will return 0 success
+u8 fat16Seek(Fat16File *file, u32 pos);
+
+//read up to num sectors from current file position into dest (num * 512 bytes).
+//contiguous sectors are read with a single multi-block MMC read (whole extent when cache is built).
+//read receive the number of sectors actually read (less than num at end of file).
+//will return 0 success
+u8 fat16ReadSectors(Fat16File *file, u8 *dest, u16 num, u16 *read);
 
 #endif  /* FAT16_SUPPORT */
 
@@ -32,6 +32,9 @@
 #include "bmp.h"
 #include "tile_cache.h"
 #include "sprite_eng.h"
+#include "loader.h"
+#include "task.h"
+#include "prof.h"
 
 #include "sound.h"
 #include "xgm.h"
@@ -0,0 +1,143 @@
+/**
+ *  \file loader.h
+ *  \brief Time sliced resource loader
+ *
+ * Resource loader which spreads unpacking and VRAM upload of TileSet, Map and Image resources over several frames.<br>
+ * Each call to LOADER_update() only queues DMA transfers up to the frame budget (see LOADER_setBudget(..)) so
+ * a level or a new screen can be loaded while a transition effect or an animation is still running.<br>
+ * Resources are processed in the order they were added and a callback can be attached to each of them to know
+ * when the data is actually in VRAM.
+ */
+
+#ifndef _LOADER_H_
+#define _LOADER_H_
+
+
+#include "vdp.h"
+#include "vdp_tile.h"
+#include "vdp_bg.h"
+
+
+/**
+ *  \brief
+ *      Maximum number of resource which can be waiting in the loader queue.
+ */
+#define LOADER_MAX_JOB          16
+/**
+ *  \brief
+ *      Default upload budget in byte per frame.
+ */
+#define LOADER_DEFAULT_BUDGET   4096
+
+
+/**
+ *  \brief
+ *      Loader callback, called when the resource identified by <i>id</i> is fully uploaded in VRAM.
+ *
+ *  \param id
+ *      Job id as returned by the LOADER_loadXXX(..) method.
+ */
+typedef void LoaderCallback(u16 id);
+
+
+/**
+ *  \brief
+ *      Cancel all pending jobs and release buffers allocated by the loader.
+ *
+ * Note that DMA transfers already queued for the current frame are not cancelled.
+ */
+void LOADER_reset();
+
+/**
+ *  \brief
+ *      Set the number of byte the loader is allowed to upload per frame (default is LOADER_DEFAULT_BUDGET).
+ *
+ * The budget should leave enough VBlank DMA bandwidth for others modules (sprite engine, palette fading...).<br>
+ * A Map row is never split so at least one row is uploaded per frame whatever is the budget.
+ */
+void LOADER_setBudget(u16 value);
+/**
+ *  \brief
+ *      Return the number of byte the loader is allowed to upload per frame.
+ */
+u16 LOADER_getBudget();
+
+/**
+ *  \brief
+ *      Add a TileSet to the loader queue.
+ *
+ *  \param tileset
+ *      TileSet to load in VRAM (can be packed).
+ *  \param index
+ *      Tile index where to start tile data load in VRAM.
+ *  \param callback
+ *      Function called when the TileSet is in VRAM (can be NULL).
+ *  \return
+ *      Job id (passed to callback) or 0 if the loader queue is full.
+ */
+u16 LOADER_loadTileSet(const TileSet *tileset, u16 index, LoaderCallback *callback);
+/**
+ *  \brief
+ *      Add a Map to the loader queue.
+ *
+ *  \param plan
+ *      Plan where we want to load Map data.<br>
+ *      Accepted values are:<br>
+ *      - PLAN_A<br>
+ *      - PLAN_B<br>
+ *      - PLAN_WINDOW
+ *  \param map
+ *      Map to load (can be packed).
+ *  \param basetile
+ *      Base index and flag for tile attributes (see TILE_ATTR_FULL() macro), applied the same way as VDP_setMapEx(..).
+ *  \param x
+ *      Plan X destination position (in tile).
+ *  \param y
+ *      Plan Y destination position (in tile).
+ *  \param callback
+ *      Function called when the Map is in VRAM (can be NULL).
+ *  \return
+ *      Job id (passed to callback) or 0 if the loader queue is full.
+ */
+u16 LOADER_loadMap(VDPPlan plan, const Map *map, u16 basetile, u16 x, u16 y, LoaderCallback *callback);
+/**
+ *  \brief
+ *      Add an Image to the loader queue (TileSet first then Map).
+ *
+ *  \param plan
+ *      Plan where we want to load Image.
+ *  \param image
+ *      Image to load.
+ *  \param basetile
+ *      Base index and flag for tile attributes (see TILE_ATTR_FULL() macro).<br>
+ *      TileSet is loaded at tile index given by basetile.
+ *  \param x
+ *      Plan X destination position (in tile).
+ *  \param y
+ *      Plan Y destination position (in tile).
+ *  \param loadpal
+ *      Load the image palette once both tiles and tilemap are in VRAM.
+ *  \param callback
+ *      Function called when the whole Image is in VRAM (can be NULL).
+ *  \return
+ *      Job id (passed to callback) or 0 if the loader queue does not have room for 2 jobs.
+ */
+u16 LOADER_loadImage(VDPPlan plan, const Image *image, u16 basetile, u16 x, u16 y, u16 loadpal, LoaderCallback *callback);
+
+/**
+ *  \brief
+ *      Process pending jobs, should be called once per frame.
+ *
+ * Packed resources are unpacked incrementally, only what can be uploaded in the frame budget is unpacked, then DMA transfers<br>
+ * are queued so they will be done on next VBlank.<br>
+ * Callback of a job is called on the first LOADER_update() following the VBlank where its last transfer happened.
+ */
+void LOADER_update();
+/**
+ *  \brief
+ *      Return the number of jobs still pending (0 means all resources are loaded).
+ */
+u16 LOADER_getNumPending();
+
+
+#endif // _LOADER_H_
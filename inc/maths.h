@@ -15,6 +15,8 @@
 extern const fix32 sintab32[1024];
 extern const fix16 sintab16[1024];
 
+extern const u16 reciptab16[1024];
+
 #if (MATH_BIG_TABLES != 0)
 extern const fix16 log2tab16[0x10000];
 extern const fix16 log10tab16[0x10000];
@@ -343,6 +345,17 @@ typedef struct
     fix16 z;
 } Vect3D_f16;
 
+/**
+ *  \brief
+ *      3D Vector structure - s16 type.
+ */
+typedef struct
+{
+    s16 x;
+    s16 y;
+    s16 z;
+} Vect3D_s16;
+
 /**
  *  \brief
  *      3x3 Matrice structure - f16 (fix16) type.<br>
@@ -433,5 +446,143 @@ s32 getApproximatedLog2(s32 value);
 u16 getLog2Int(u32 value);
 
 
+/**
+ *  \brief
+ *      Multiply two fix32 values without intermediate overflow.<br>
+ *      #fix32Mul(..) overflows as soon as the product exceeds 32 bits (ex: fix32Mul(FIX32(1000), FIX32(1000)))
+ *      while this method uses a 64 bits intermediate result (built from 16x16 partial products).<br>
+ *      Result is the same as #fix32Mul(..) when it does not overflow.
+ *
+ *  \param val1
+ *      first fix32 value.
+ *  \param val2
+ *      second fix32 value.
+ */
+fix32 fix32MulSafe(fix32 val1, fix32 val2);
+/**
+ *  \brief
+ *      Fast fix16 division using the reciprocal table (multiplication instead of division)
+ *      when |val2| < FIX16(16), regular division is used otherwise.<br>
+ *      Result is an approximation (relative error up to ~1.5%).
+ *
+ *  \param val1
+ *      dividend.
+ *  \param val2
+ *      divisor.
+ */
+fix16 fix16DivFast(fix16 val1, fix16 val2);
+
+/**
+ *  \brief
+ *      Add 2D vectors: dest[i] = src1[i] + src2[i].
+ *
+ *  \param src1
+ *      first source vectors buffer.
+ *  \param src2
+ *      second source vectors buffer.
+ *  \param dest
+ *      destination vectors buffer (can be same as src1 or src2).
+ *  \param num
+ *      number of vectors to process.
+ */
+void vect2DAdd_f16(const Vect2D_f16 *src1, const Vect2D_f16 *src2, Vect2D_f16 *dest, u16 num);
+/**
+ *  \brief
+ *      Add 3D vectors: dest[i] = src1[i] + src2[i].
+ *
+ *  \param src1
+ *      first source vectors buffer.
+ *  \param src2
+ *      second source vectors buffer.
+ *  \param dest
+ *      destination vectors buffer (can be same as src1 or src2).
+ *  \param num
+ *      number of vectors to process.
+ */
+void vect3DAdd_f16(const Vect3D_f16 *src1, const Vect3D_f16 *src2, Vect3D_f16 *dest, u16 num);
+/**
+ *  \brief
+ *      Scale 2D vectors: dest[i] = src[i] * scale.
+ *
+ *  \param src
+ *      source vectors buffer.
+ *  \param scale
+ *      scale factor.
+ *  \param dest
+ *      destination vectors buffer (can be same as src).
+ *  \param num
+ *      number of vectors to process.
+ */
+void vect2DScale_f16(const Vect2D_f16 *src, fix16 scale, Vect2D_f16 *dest, u16 num);
+/**
+ *  \brief
+ *      Scale 3D vectors: dest[i] = src[i] * scale.
+ *
+ *  \param src
+ *      source vectors buffer.
+ *  \param scale
+ *      scale factor.
+ *  \param dest
+ *      destination vectors buffer (can be same as src).
+ *  \param num
+ *      number of vectors to process.
+ */
+void vect3DScale_f16(const Vect3D_f16 *src, fix16 scale, Vect3D_f16 *dest, u16 num);
+/**
+ *  \brief
+ *      2D vectors dot product: dest[i] = src1[i] . src2[i].
+ *
+ *  \param src1
+ *      first source vectors buffer.
+ *  \param src2
+ *      second source vectors buffer.
+ *  \param dest
+ *      destination buffer.
+ *  \param num
+ *      number of vectors to process.
+ */
+void vect2DDot_f16(const Vect2D_f16 *src1, const Vect2D_f16 *src2, fix16 *dest, u16 num);
+/**
+ *  \brief
+ *      3D vectors dot product: dest[i] = src1[i] . src2[i].
+ *
+ *  \param src1
+ *      first source vectors buffer.
+ *  \param src2
+ *      second source vectors buffer.
+ *  \param dest
+ *      destination buffer.
+ *  \param num
+ *      number of vectors to process.
+ */
+void vect3DDot_f16(const Vect3D_f16 *src1, const Vect3D_f16 *src2, fix16 *dest, u16 num);
+/**
+ *  \brief
+ *      Multiply 3D vectors by a 3x3 matrix: dest[i] = mat * src[i].
+ *
+ *  \param mat
+ *      matrix.
+ *  \param src
+ *      source vectors buffer.
+ *  \param dest
+ *      destination vectors buffer (can be same as src).
+ *  \param num
+ *      number of vectors to process.
+ */
+void mat3DMulVect3D_f16(const Mat3D_f16 *mat, const Vect3D_f16 *src, Vect3D_f16 *dest, u16 num);
+/**
+ *  \brief
+ *      Multiply two 3x3 matrices: dest = mat1 * mat2.
+ *
+ *  \param mat1
+ *      left matrix.
+ *  \param mat2
+ *      right matrix.
+ *  \param dest
+ *      destination matrix (cannot be same as mat1 or mat2).
+ */
+void mat3DMul_f16(const Mat3D_f16 *mat1, const Mat3D_f16 *mat2, Mat3D_f16 *dest);
+
+
 
 #endif // _MATHS_H_
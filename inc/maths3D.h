@@ -59,6 +59,48 @@ typedef struct
     Vect3D_f16 lightInv;
 } Transformation3D;
 
+/**
+ *  \brief
+ *      3D mesh object made of quad faces, used by #M3D_processMesh(..).
+ *
+ *  \param numVertex
+ *      Number of vertex (maximum is 5461).
+ *  \param numFace
+ *      Number of face.
+ *  \param vertices
+ *      Vertices buffer.
+ *  \param faceNormals
+ *      Face normals buffer (one normal per face), can be NULL if lighting is not used.
+ *  \param faceIndexes
+ *      Face vertex indexes buffer (4 indexes per face, same winding as expected by #BMP_isPolygonCulled(..)).
+ */
+typedef struct
+{
+    u16 numVertex;
+    u16 numFace;
+    const Vect3D_f16 *vertices;
+    const Vect3D_f16 *faceNormals;
+    const u16 *faceIndexes;
+} Mesh3D;
+
+/**
+ *  \brief
+ *      Visible face as produced by #M3D_processMesh(..).
+ *
+ *  \param pts
+ *      Projected face points (ready to use with #BMP_drawPolygon(..)).
+ *  \param z
+ *      Face depth (average distance of face vertices from camera).
+ *  \param col
+ *      Face color (with lighting applied if enabled).
+ */
+typedef struct
+{
+    Vect2D_s16 pts[4];
+    fix16 z;
+    u16 col;
+} Face3D;
+
 /**
  *  \brief
  *      Reset math 3D engine (reset matrices and transformation parameters mainly).
@@ -275,5 +317,32 @@ void M3D_project_f16(const Vect3D_f16 *src, Vect2D_f16 *dest, u16 numv);
  */
 void M3D_project_s16(const Vect3D_f16 *src, Vect2D_s16 *dest, u16 numv);
 
+/**
+ *  \brief
+ *      Process the complete 3D pipeline on the specified mesh in a single pass:<br>
+ *      transform, 2D projection (s16 version), back face culling and flat lighting.<br>
+ *      This is much faster than calling #M3D_transform(..) and #M3D_project_s16(..)
+ *      then testing each face with #BMP_isPolygonCulled(..) as each vertex is transformed
+ *      and projected at once into <code>buf</code> (no intermediate transformed vertices buffer)
+ *      then faces are culled and lit directly from it.
+ *
+ *  \param t
+ *      Transformation object containing rotation and translation parameters.
+ *  \param mesh
+ *      Source mesh.
+ *  \param buf
+ *      Temporary buffer (mesh->numVertex entries), receives projected vertices
+ *      (x, y) and their distance from camera (z).
+ *  \param dest
+ *      Destination faces buffer (mesh->numFace entries), receives visible faces only.
+ *  \param col
+ *      Base face color.<br>
+ *      If light is enabled (see #M3D_setLightEnabled(..)) and mesh defines face normals,
+ *      lighting intensity (0 to 4) is added to the base color.
+ *  \return
+ *      Number of visible faces written in <code>dest</code>.
+ */
+u16  M3D_processMesh(Transformation3D *t, const Mesh3D *mesh, Vect3D_s16 *buf, Face3D *dest, u16 col);
+
 
 #endif // _MATHS3D_H_
@@ -0,0 +1,218 @@
+/**
+ *  \file prof.h
+ *  \brief Zone profiler
+ *
+ * Hierarchical zone profiler using the VDP H/V counter for timing.<br>
+ * Surround the code to measure with PROF_begin("name") / PROF_end(), zones can be nested and the same zone can be entered
+ * several times per frame: time is accumulated per frame then min / average / max per frame statistics are computed.<br>
+ * Profiling macros compile to nothing unless ENABLE_PROFILER is set to 1 in config.h (library has to be rebuilt).<br>
+ * Some library methods are already instrumented (DMA queue flush, SPR_update(), TC_alloc(..), bitmap blit, XGM V-Int process).<br>
+ * <br>
+ * Zones measured from an interrupt handler are supported, note that time spent in interrupts is included in the time
+ * of the zone being interrupted.<br>
+ * <br>
+ * This unit also provides a sampling profiler (see PROF_startSampling(..)) which doesn't require any instrumentation
+ * and is available whatever is ENABLE_PROFILER value: the interrupted program counter (and possible return addresses found
+ * on the stack) are recorded from V-Int (and optionally H-Int) then dumped through KDebug or SRAM and mapped to functions
+ * on the host with the 'sampprof' tool using the out/symbol.txt file produced by the debug build.
+ */
+
+#ifndef _PROF_H_
+#define _PROF_H_
+
+
+/**
+ *  \brief
+ *      Maximum number of zone.
+ */
+#define PROF_MAX_ZONE           32
+/**
+ *  \brief
+ *      Maximum zone nesting level.
+ */
+#define PROF_MAX_DEPTH          16
+/**
+ *  \brief
+ *      Number of frame used for average computation (older frames have a decreasing weight).
+ */
+#define PROF_AVG_FRAME          256
+/**
+ *  \brief
+ *      Number of 68000 cycle per scanline.
+ */
+#define PROF_CYCLE_PER_LINE     488
+/**
+ *  \brief
+ *      Maximum number of return address stored per sample.
+ */
+#define PROF_MAX_SAMPLE_DEPTH   15
+/**
+ *  \brief
+ *      Number of stack word scanned to find return addresses.
+ */
+#define PROF_SAMPLE_SCAN        64
+
+
+/**
+ *  \brief
+ *      Zone id not yet requested (PROF_begin(..) cache), 0 is kept when there is no more free zone so we don't search it again.
+ */
+#define PROF_ZONE_UNSET     0xFFFF
+
+#if (ENABLE_PROFILER != 0)
+
+/**
+ *  \brief
+ *      Start a profiling zone (must be paired with PROF_end()).
+ *
+ *  \param name
+ *      Zone name (static string), zones using the same name share the same statistics.
+ */
+#define PROF_begin(name)    do { static u16 _profZone = PROF_ZONE_UNSET; if (_profZone == PROF_ZONE_UNSET) _profZone = PROF_getZone(name); PROF_beginZone(_profZone); } while(0)
+/**
+ *  \brief
+ *      End the current profiling zone.
+ */
+#define PROF_end()          PROF_endZone()
+
+#else
+
+#define PROF_begin(name)    do {} while(0)
+#define PROF_end()          do {} while(0)
+
+#endif // ENABLE_PROFILER
+
+
+/**
+ *  \brief
+ *      Reset statistics of all zones (zones stay registered).
+ */
+void PROF_reset();
+
+/**
+ *  \brief
+ *      Returns the id of the zone with the given name (zone is created if needed).
+ *
+ *  \return
+ *      Zone id or 0 if there is no more free zone (or profiler is disabled).
+ */
+u16 PROF_getZone(const char *name);
+/**
+ *  \brief
+ *      Start the specified zone, you should use PROF_begin(..) instead.
+ */
+void PROF_beginZone(u16 id);
+/**
+ *  \brief
+ *      End the current zone, you should use PROF_end() instead.
+ */
+void PROF_endZone();
+
+/**
+ *  \brief
+ *      Get zone statistics (computed on complete frames only).
+ *
+ *  \param id
+ *      Zone id (see PROF_getZone(..)).
+ *  \param min
+ *      Minimum time spent in the zone for a frame (in 68000 cycle).
+ *  \param avg
+ *      Average time spent in the zone per frame (in 68000 cycle).
+ *  \param max
+ *      Maximum time spent in the zone for a frame (in 68000 cycle).
+ *  \return
+ *      Number of time the zone was entered during the last complete frame.
+ */
+u16 PROF_getZoneStats(u16 id, u32 *min, u32 *avg, u32 *max);
+
+/**
+ *  \brief
+ *      Returns current time in 1/256 of scanline.
+ *
+ * Time is computed from V-Int frame counter and H/V counter, taking care of V counter rollback during blank and of
+ * H counter jump during horizontal blank, so it's much more accurate than getSubTick().<br>
+ * Time is only valid when V-Int is enabled and wraps every 15 minutes so only use the difference between 2 calls.
+ */
+u32 PROF_getTime();
+/**
+ *  \brief
+ *      Convert a time value (see PROF_getTime()) to 68000 cycles.
+ */
+u32 PROF_timeToCycles(u32 time);
+
+/**
+ *  \brief
+ *      Log zone statistics through KDebug (Gens KMod or compatible emulator).
+ */
+void PROF_dump();
+/**
+ *  \brief
+ *      Draw zone statistics table at given position (background plan, 40 columns width needed).
+ *
+ *  \param x
+ *      X position (in tile).
+ *  \param y
+ *      Y position (in tile), table uses 1 row for header + 1 row per zone.
+ */
+void PROF_draw(u16 x, u16 y);
+
+/**
+ *  \brief
+ *      Start the sampling profiler.
+ *
+ *  \param numSample
+ *      Size of the sample ring buffer (oldest samples are overwritten when it's full).
+ *  \param depth
+ *      Number of possible return address recorded per sample (0 to PROF_MAX_SAMPLE_DEPTH), 0 means only the interrupted PC
+ *      is recorded (flat profile only).<br>
+ *      A sample uses (depth + 1) * 4 bytes of memory.
+ *  \param hintRate
+ *      If not 0 a sample is also taken every <i>hintRate</i> scanlines from H-Int (it enables H-Int and set the H-Int counter
+ *      so it can't be used with bitmap mode, extended blank or your own H-Int counter setting).<br>
+ *      Set it to 0 to only take one sample per frame from V-Int.
+ *  \return
+ *      FALSE if the sample buffer can't be allocated, TRUE otherwise.
+ *
+ * Samples are taken by installing a small handler in front of internalVIntCB / internalHIntCB so don't modify them
+ * while sampling.<br>
+ * Return addresses are found by scanning the stack of the interrupted code (PROF_SAMPLE_SCAN words), values which
+ * aren't real return addresses are discarded by the host tool (it checks for JSR / BSR instruction using rom.bin).
+ */
+u16 PROF_startSampling(u16 numSample, u16 depth, u16 hintRate);
+/**
+ *  \brief
+ *      Stop the sampling profiler (samples stay available for PROF_dumpSamples() / PROF_saveSamples(..)).
+ */
+void PROF_stopSampling();
+/**
+ *  \brief
+ *      Release the sample buffer (stop sampling if needed).
+ */
+void PROF_releaseSamples();
+/**
+ *  \brief
+ *      Returns the number of sample in the buffer.
+ */
+u16 PROF_getNumSample();
+/**
+ *  \brief
+ *      Dump samples through KDebug log, one "PS:" line per sample (copy the log to a file for the sampprof tool).
+ *
+ * Sampling should be stopped first.
+ */
+void PROF_dumpSamples();
+/**
+ *  \brief
+ *      Save samples in SRAM (emulator save file can then be given to the sampprof tool).
+ *
+ *  \param offset
+ *      SRAM offset where to write samples.
+ *  \return
+ *      Number of byte written (12 bytes header + samples).
+ *
+ * Sampling should be stopped first.
+ */
+u32 PROF_saveSamples(u32 offset);
+
+
+#endif // _PROF_H_
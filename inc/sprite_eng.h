@@ -53,11 +53,16 @@
  *      Enable automatic upload of sprite tiles data into VRAM
  */
 #define SPR_FLAG_AUTO_TILE_UPLOAD       0x0100
+/**
+ *  \brief
+ *      Enable shared VRAM allocation (sprites displaying the same animation frame share the same VRAM tiles)
+ */
+#define SPR_FLAG_SHARED_VRAM_ALLOC      0x2000
 /**
  *  \brief
  *      Mask for sprite flags
  */
-#define SPR_FLAGS_MASK                  (SPR_FLAG_AUTO_VISIBILITY | SPR_FLAG_FAST_AUTO_VISIBILITY | SPR_FLAG_AUTO_VRAM_ALLOC | SPR_FLAG_AUTO_SPRITE_ALLOC | SPR_FLAG_AUTO_TILE_UPLOAD)
+#define SPR_FLAGS_MASK                  (SPR_FLAG_AUTO_VISIBILITY | SPR_FLAG_FAST_AUTO_VISIBILITY | SPR_FLAG_AUTO_VRAM_ALLOC | SPR_FLAG_AUTO_SPRITE_ALLOC | SPR_FLAG_AUTO_TILE_UPLOAD | SPR_FLAG_SHARED_VRAM_ALLOC)
 
 /**
  *  \brief
@@ -264,6 +269,12 @@ typedef struct
  *      Number of allocated VDP sprite is defined by definition->maxNumSprite
  *  \param frameNumSprite
  *      the number of VDP sprite used by the current frame (internal)
+ *  \param collisionGroup
+ *      collision group bits of this sprite (0 = sprite is ignored by the collision broadphase)
+ *  \param collisionMask
+ *      collision groups this sprite can collide with (see SPR_setCollisionFilter(..))
+ *  \param sharedFrame
+ *      shared VRAM frame entry used by the current frame when SPR_FLAG_SHARED_VRAM_ALLOC is set (internal)
  *  \param lastVDPSprite
  *      Pointer to last VDP sprite used by this Sprite (used internally to update link between sprite)
  *  \param data
@@ -272,6 +283,10 @@ typedef struct
  *      pointer on previous Sprite in list
  *  \param next
  *      pointer on next Sprite in list
+ *  \param updatePrev
+ *      pointer on previous Sprite in the update list (internal)
+ *  \param updateNext
+ *      pointer on next Sprite in the update list (internal)
  *
  *  Used to manage an active sprite in game condition.
  */
@@ -292,12 +307,34 @@ typedef struct _Sprite
     u16 attribut;
     u16 VDPSpriteIndex;
     u16 frameNumSprite;
+    u16 collisionGroup;
+    u16 collisionMask;
+    u16 sharedFrame;
     VDPSprite *lastVDPSprite;
     u32 data;
     struct _Sprite *prev;
     struct _Sprite *next;
+    struct _Sprite *updatePrev;
+    struct _Sprite *updateNext;
 } Sprite;
 
+/**
+ *  \brief
+ *      Sprite collision pair as reported by the collision broadphase.
+ *
+ *  \param sprite1
+ *      first sprite of the pair
+ *  \param sprite2
+ *      second sprite of the pair
+ *
+ *  \see SPR_getCollisionPairs(..)
+ */
+typedef struct
+{
+    Sprite *sprite1;
+    Sprite *sprite2;
+} SpriteCollisionPair;
+
 
 /**
  *  \brief
@@ -371,6 +408,11 @@ void SPR_reset();
  *          If you don't set this flag you will have to manually define the hardware sprite table index to reserve with the <i>spriteIndex</i> parameter or by using the #SPR_setSpriteTableIndex(..) method<br>
  *      #SPR_FLAG_AUTO_TILE_UPLOAD = Enable automatic upload of sprite tiles data into VRAM (enabled by default)<br>
  *          If you don't set this flag you will have to manually upload tiles data of sprite into the VRAM.<br>
+ *      #SPR_FLAG_SHARED_VRAM_ALLOC = Enable shared VRAM allocation (replace #SPR_FLAG_AUTO_VRAM_ALLOC, should be used with #SPR_FLAG_AUTO_TILE_UPLOAD)<br>
+ *          Instead of reserving VRAM for its biggest frame, the sprite only uses VRAM for its current animation frame and this VRAM
+ *          area is shared (reference counted) by all sprites displaying the same frame, so tiles are uploaded only once.<br>
+ *          Useful for many enemies of the same type, but the VRAM allocation happens on frame change (in SPR_update()) and can fail
+ *          if the sprite VRAM region is full (the sprite then keeps its previous frame tiles).<br>
  *      <br>
  *      It's recommended to use the following default settings:<br>
  *      SPR_FLAG_AUTO_VISIBILITY | SPR_FLAG_AUTO_VRAM_ALLOC | SPR_FLAG_AUTO_SPRITE_ALLOC | SPR_FLAG_AUTO_TILE_UPLOAD<br>
@@ -423,11 +465,43 @@ void SPR_releaseSprite(Sprite* sprite);
  *      Returns the number of active sprite (number of sprite added with SPR_addSprite(..) or SPR_addSpriteEx(..) methods).
  */
 u16 SPR_getNumActiveSprite();
+/**
+ *  \brief
+ *      Returns the number of sprite processed by SPR_update() (active sprites minus idle static sprites).
+ *
+ *  \see SPR_setStatic(..)
+ */
+u16 SPR_getNumUpdatedSprite();
 /**
  *  \brief
  *      Defragment allocated VRAM for sprites, that can help when sprite allocation fail (SPR_addSprite(..) or SPR_addSpriteEx(..) return <i>NULL</i>).
  */
 void SPR_defragVRAM();
+/**
+ *  \brief
+ *      Enable incremental VRAM defragmentation and set the maximum number of byte it can move per frame (0 = disabled, default).
+ *
+ *  \param value
+ *      Maximum number of byte copied per frame, a sprite VRAM area bigger than the budget is never moved.
+ *
+ *      When enabled, SPR_update() moves a few sprite VRAM areas per frame toward the start of the sprite VRAM region,
+ *      starting from the highest ones, so free VRAM stays in one large block and SPR_defragVRAM() is no more required.<br>
+ *      Tiles are moved using queued VRAM to VRAM copy DMA (no re-unpacking) and the sprite tile index is updated in the same SPR_update()
+ *      so the VDP sprite table refers the new location at the VBlank where the copy happens.<br>
+ *      Only sprites with both automatic VRAM allocation and automatic tile upload (and shared VRAM frames) are moved.<br>
+ *      Note that a VRAM copy is about twice slower than a normal DMA transfer (see DMA_queueVRamCopy(..)).
+ *
+ *  \see SPR_defragVRAM()
+ *  \see VRAM_getFragmentation(..)
+ */
+void SPR_setDefragBudget(u16 value);
+/**
+ *  \brief
+ *      Returns the number of byte the incremental VRAM defragmentation can move per frame (0 = disabled).
+ *
+ *  \see SPR_setDefragBudget(..)
+ */
+u16 SPR_getDefragBudget();
 
 /**
  *  \brief
@@ -567,7 +641,7 @@ void SPR_nextFrame(Sprite *sprite);
  *      Sprite to set the VRAM tile position for
  *  \param value
  *      the tile position in VRAM where we will upload the sprite tiles data.<br>
- *      Use <b>-1</b> for auto allocation.<br>
+ *      Use <b>-1</b> for auto allocation (shared VRAM allocation is kept if enabled).<br>
  *  \return FALSE if auto allocation failed (can happen only if sprite is currently active), TRUE otherwise
  *
  *  By default the Sprite Engine auto allocate VRAM for sprites tiles but you can force
@@ -603,6 +677,25 @@ u16 SPR_setSpriteTableIndex(Sprite *sprite, s16 value);
  *      FALSE to disable it (mean you have to handle that on your own).<br>
  */
 void SPR_setAutoTileUpload(Sprite *sprite, u16 value);
+/**
+ *  \brief
+ *      Set the static state of the sprite.
+ *
+ *  \param sprite
+ *      Sprite we want to set the static state for
+ *  \param value
+ *      TRUE to set the sprite as static, FALSE otherwise (default).
+ *
+ *  A static sprite which is not animated (or whose animation frame has a timer of 0) leaves the internal update list
+ *  once SPR_update() processed its pending changes so it does not cost anything anymore to SPR_update().<br>
+ *  Its VDP sprite table entries and its position in the depth sorted list are kept so it is still displayed.<br>
+ *  Calling a setter changing the sprite display (position, flip, palette, animation, frame, visibility, definition,
+ *  VRAM or VDP sprite index) automatically puts it back in the update list until the change is processed.<br>
+ *  Useful for HUD icons or decor sprites which rarely change.
+ *
+ *  \see SPR_getNumUpdatedSprite()
+ */
+void SPR_setStatic(Sprite *sprite, u16 value);
 /**
  *  \brief
  *      Set the <i>visibility</i> state for this sprite.
@@ -641,18 +734,133 @@ void SPR_setNeverVisible(Sprite *sprite, u16 value);
  */
 u16 SPR_computeVisibility(Sprite *sprite);
 
-// /**
-// *  \brief
-// *      Test if specified sprites are in collision.
-// *
-// *  \param sprite1
-// *      first sprite.
-// *  \param sprite2
-// *      second sprite.
-// *  \return
-// *      TRUE if sprite1 and sprite2 are in collision, FALSE otherwise.
-// */
-//u16 SPR_testCollision(Sprite *sprite1, Sprite *sprite2);
+/**
+ *  \brief
+ *      Init the sprite collision engine.
+ *
+ *  \param maxPair
+ *      Maximum number of collision pair reported by SPR_getCollisionPairs(..).<br>
+ *      If set to 0 the default value is used (64 pairs)
+ *
+ *      Once initialized, SPR_update() computes the collision pairs between all active sprites
+ *      using the collision definition (#Collision structure) of their current animation frame
+ *      in their current flip state.<br>
+ *      A uniform grid (32x32 pixels cells covering the screen area) is used as broadphase so only
+ *      sprites sharing a cell are tested together. Sprites without collision definition (NONE
+ *      collision type in rescomp) or with a collision group set to 0 are ignored.<br>
+ *      Only the first (top level) collision shape of a frame is used.<br>
+ *      The collision engine is automatically ended with SPR_end().
+ *
+ *  \return
+ *      FALSE if there is not enough memory to allocate collision data, TRUE otherwise.
+ *
+ *  \see SPR_endCollision()
+ *  \see SPR_getCollisionPairs(..)
+ */
+u16 SPR_initCollision(u16 maxPair);
+/**
+ *  \brief
+ *      End the sprite collision engine and release attached resources.
+ */
+void SPR_endCollision();
+/**
+ *  \brief
+ *      Returns TRUE if the sprite collision engine is initialized, FALSE otherwise.
+ */
+u16 SPR_isCollisionInitialized();
+/**
+ *  \brief
+ *      Set the collision filter for this sprite.
+ *
+ *  \param sprite
+ *      Sprite we want to set the collision filter for.
+ *  \param group
+ *      Collision group bit(s) of the sprite, 0 means the sprite never collides (default = 1).
+ *  \param mask
+ *      Collision groups the sprite can collide with (default = 0xFFFF).
+ *
+ *  Two sprites A and B are reported as a collision pair only if (A.group & B.mask) and (B.group & A.mask)
+ *  are both not null.<br>
+ *  For instance you can set player shots to group 2 with mask 4 and enemies to group 4 with mask 3
+ *  so shots don't collide each others.
+ */
+void SPR_setCollisionFilter(Sprite *sprite, u16 group, u16 mask);
+/**
+ *  \brief
+ *      Test if specified sprites are in collision.
+ *
+ *  \param sprite1
+ *      first sprite.
+ *  \param sprite2
+ *      second sprite.
+ *  \return
+ *      TRUE if sprite1 and sprite2 are in collision, FALSE otherwise.
+ *
+ *  Test is done using the collision shape (box or circle) of the current animation frame for both sprites
+ *  in their current flip state (collision filter is not used here).<br>
+ *  Returns FALSE if one of the sprite does not have collision definition.
+ */
+u16 SPR_testCollision(Sprite *sprite1, Sprite *sprite2);
+/**
+ *  \brief
+ *      Get the collision pairs computed by the last SPR_update() call.
+ *
+ *  \param pairs
+ *      If not NULL, receive a pointer on the collision pairs array (valid until next SPR_update() call).
+ *  \return
+ *      Number of collision pair (0 if the collision engine is not initialized).
+ *
+ *  Each pair is reported only once, when more than <i>maxPair</i> pairs are found the extra ones are dropped.
+ *
+ *  \see SPR_initCollision(..)
+ */
+u16 SPR_getCollisionPairs(SpriteCollisionPair **pairs);
+
+/**
+ *  \brief
+ *      Init sprite multiplexing.
+ *
+ *      Once initialized, SPR_update() computes the number of VDP sprite and the sprite pixel width on each
+ *      scanline (see SPR_getScanlineSpriteLoad() and SPR_getScanlinePixelLoad()).<br>
+ *      When a scanline goes over the VDP limit (20 sprites / 320 pixels in H40 mode, 16 sprites / 256 pixels in H32 mode)
+ *      the VDP drops the sprites coming last in the link chain, which are always the same with a pure depth order.<br>
+ *      Multiplexing rotates, on each frame, the link order of the sprites having at least one VDP sprite on an overflowing
+ *      scanline so the dropped sprites change every frame (flicker) instead of disappearing.<br>
+ *      Rotated sprites keep the link slots given by the depth order so others sprites are not affected, sprites set
+ *      to SPR_MIN_DEPTH (always on top) are never rotated.<br>
+ *      Note that rotated sprites may exchange their display priority when they overlap.<br>
+ *      Multiplexing is automatically ended with SPR_end().
+ *
+ *  \see SPR_endMultiplexing()
+ */
+void SPR_initMultiplexing();
+/**
+ *  \brief
+ *      End sprite multiplexing (release its memory), sprites are then linked in pure depth order again.
+ */
+void SPR_endMultiplexing();
+/**
+ *  \brief
+ *      Returns TRUE if sprite multiplexing is initialized.
+ */
+u16 SPR_isMultiplexingInitialized();
+/**
+ *  \brief
+ *      Returns the number of displayed VDP sprite on each scanline computed by the last SPR_update()
+ *      (screen height entries) or NULL if multiplexing is not initialized.
+ */
+const u8* SPR_getScanlineSpriteLoad();
+/**
+ *  \brief
+ *      Returns the sprite pixel width on each scanline computed by the last SPR_update()
+ *      (screen height entries) or NULL if multiplexing is not initialized.
+ */
+const u16* SPR_getScanlinePixelLoad();
+/**
+ *  \brief
+ *      Returns the number of scanline going over the VDP sprite limits on the last SPR_update().
+ */
+u16 SPR_getNumOverflowScanline();
 
 /**
  *  \brief
@@ -672,6 +880,14 @@ void SPR_clear();
  *  \see #SPR_addSprite(..)
  */
 void SPR_update();
+/**
+ *  \brief
+ *      Returns the size (in bytes) of VDP sprite table data sent by the last SPR_update() call.
+ *
+ *  Only the modified VDP sprites are sent to the VDP (in a few contiguous DMA transfers)
+ *  so this is 0 when nothing changed and at most (number of used VDP sprite * 8).
+ */
+u16 SPR_getSpriteTableTransferSize();
 
 /**
  *  \brief
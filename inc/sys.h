@@ -16,6 +16,8 @@
 #define PROCESS_TILECACHE_TASK      (1 << 2)
 #define PROCESS_DMA_TASK            (1 << 3)
 #define PROCESS_XGM_TASK            (1 << 4)
+#define PROCESS_EXTVBLANK_TASK      (1 << 5)
+#define PROCESS_PLANSHADOW_TASK     (1 << 6)
 
 
 /**
@@ -0,0 +1,157 @@
+/**
+ *  \file task.h
+ *  \brief Cooperative task scheduler
+ *
+ * Simple cooperative scheduler to spread long processing (AI, path finding, unpacking...) over several frames.<br>
+ * A task is a callback which does a small piece of work each time it's called and keeps its progress in its own data
+ * structure, it's called again and again until it returns TASK_DONE, its own frame budget or the scheduler frame budget
+ * is spent.<br>
+ * Tasks are processed by priority order (highest first) from TASK_update() and from VDP_waitVSync() which use the idle
+ * time before VBlank to run the background tasks.<br>
+ * Time is measured with getSubTick() so this unit requires V-Int to be enabled.
+ */
+
+#ifndef _TASK_H_
+#define _TASK_H_
+
+
+/**
+ *  \brief
+ *      Maximum number of task.
+ */
+#define TASK_MAX                16
+/**
+ *  \brief
+ *      Default scheduler frame budget for TASK_update() (in subtick, about 1/4 of a NTSC frame).
+ */
+#define TASK_DEFAULT_BUDGET     320
+/**
+ *  \brief
+ *      Number of scanline kept free before VBlank when tasks are processed from VDP_waitVSync().
+ */
+#define TASK_VSYNC_MARGIN       8
+
+/**
+ *  \brief
+ *      Task callback return value: call the task again as soon as possible (same frame if budget allows it).
+ */
+#define TASK_CONTINUE           0
+/**
+ *  \brief
+ *      Task callback return value: nothing more to do for this frame, call the task again on next frame.
+ */
+#define TASK_YIELD              1
+/**
+ *  \brief
+ *      Task callback return value: task is completed and is removed from the scheduler.
+ */
+#define TASK_DONE               2
+
+/**
+ *  \brief
+ *      Task flag: task is processed from TASK_update() only (not in VDP_waitVSync() idle time).
+ */
+#define TASK_FOREGROUND         0
+/**
+ *  \brief
+ *      Task flag: task is also processed in VDP_waitVSync() idle time.
+ */
+#define TASK_BACKGROUND         1
+
+
+/**
+ *  \brief
+ *      Task callback.
+ *
+ *  \param data
+ *      Task data as given to TASK_add(..), used to store the task state so it can resume where it stopped.
+ *  \return
+ *      TASK_CONTINUE, TASK_YIELD or TASK_DONE.
+ *
+ * The callback should do a short piece of work (ideally less than a few scanlines) then return, long loops should test
+ * TASK_shouldYield() to stop when the budget is spent.
+ */
+typedef u16 TaskCallback(void *data);
+
+
+/**
+ *  \brief
+ *      Remove all tasks and restore default scheduler budget.
+ */
+void TASK_reset();
+
+/**
+ *  \brief
+ *      Add a task to the scheduler.
+ *
+ *  \param callback
+ *      Task callback.
+ *  \param data
+ *      Task data (passed to callback).
+ *  \param priority
+ *      Task priority, tasks with higher priority are processed first (tasks with same priority are processed in the order they were added).
+ *  \param taskBudget
+ *      Maximum time (in subtick) the task can use per frame, 0 means no limit (only the scheduler budget applies).<br>
+ *      A task with a budget let the lower priority tasks get some time.
+ *  \param flags
+ *      TASK_FOREGROUND or TASK_BACKGROUND.
+ *  \return
+ *      Task id (used by TASK_remove(..) and TASK_isAlive(..)) or 0 if there is no more free task slot.
+ */
+u16 TASK_add(TaskCallback *callback, void *data, u16 priority, u16 taskBudget, u16 flags);
+/**
+ *  \brief
+ *      Remove the specified task from the scheduler (can be called from a task callback).
+ */
+void TASK_remove(u16 id);
+/**
+ *  \brief
+ *      Returns TRUE if the specified task is still in the scheduler.
+ */
+u16 TASK_isAlive(u16 id);
+/**
+ *  \brief
+ *      Returns the number of task in the scheduler.
+ */
+u16 TASK_getNumTask();
+
+/**
+ *  \brief
+ *      Set the time (in subtick) TASK_update() can use per call (default is TASK_DEFAULT_BUDGET).
+ */
+void TASK_setBudget(u16 value);
+/**
+ *  \brief
+ *      Returns the time (in subtick) TASK_update() can use per call.
+ */
+u16 TASK_getBudget();
+
+/**
+ *  \brief
+ *      Process tasks until the scheduler budget is spent or all tasks have yielded, should be called once per frame.
+ *
+ *  \return
+ *      Number of task still in the scheduler.
+ */
+u16 TASK_update();
+/**
+ *  \brief
+ *      Process background tasks until we are TASK_VSYNC_MARGIN scanlines before VBlank (or before extended VBlank when
+ *      enabled, see VDP_setExtendedVBlank(..)).
+ *
+ * This method is automatically called by VDP_waitVSync() (when there is at least one task) so you don't need to call it.
+ *
+ *  \return
+ *      Number of task still in the scheduler.
+ */
+u16 TASK_updateUntilVSync();
+/**
+ *  \brief
+ *      Returns TRUE if the current task should return now (task or scheduler budget spent).
+ *
+ * To use from a task callback doing long loops so it can return TASK_CONTINUE or TASK_YIELD when it's time to stop.
+ */
+u16 TASK_shouldYield();
+
+
+#endif // _TASK_H_
@@ -44,6 +44,29 @@
  */
 typedef s16 _comparatorCallback(void* o1, void* o2);
 
+/**
+ *  \brief
+ *      Incremental unpacker state.
+ *
+ * Allow to unpack APLIB or LZ4W data in several steps (see unpackStreamInit(..) and unpackStream(..)) so
+ * unpacking cost can be bounded per frame. All fields are internal and should not be modified directly.
+ */
+typedef struct
+{
+    u16 compression;
+    u16 state;
+    const u8 *src;
+    u8 *dest;
+    u32 mask;
+    u32 pos;
+    u32 len;
+    u32 offset;
+    u32 lastOffset;
+    u16 lit;
+    u16 lwm;
+    u16 bits;
+} UnpackStream;
+
 
 /**
  *  \brief
@@ -323,6 +346,71 @@ u32 aplib_unpack(u8 *src, u8 *dest);
  *      Unpacked size.
  */
 u32 lz4w_unpack(const u8 *src, u8 *dest);
+/**
+ *  \brief
+ *      Unpack (LZ4W) the specified source data buffer directly in VRAM (no memory buffer required).
+ *
+ * Literals are directly written to the VDP data port while match are done through VDP reads (short match)
+ * or VRAM copy DMA (long match). It is usually slower than lz4w_unpack(..) followed by a DMA transfer when
+ * done during VBlank but it doesn't require any memory so it's meant for uploads outside VBlank (display disabled
+ * or loading screen) when memory is tight.<br>
+ * VDP auto increment is set to 2 on return.
+ *
+ *  \param src
+ *      Source data buffer containing the packed data (LZ4W packed) to unpack.
+ *  \param dest
+ *      VRAM destination address.
+ *  \return
+ *      Unpacked size (computed from 16 bits VRAM address so it wraps on 64 KB).
+ */
+u32 lz4w_unpackToVRam(const u8 *src, u16 dest);
+
+/**
+ *  \brief
+ *      Initialize an incremental unpacker.
+ *
+ *  \param us
+ *      Unpacker state to initialize.
+ *  \param compression
+ *      compression type, accepted values:<br>
+ *      <b>COMPRESSION_APLIB</b><br>
+ *      <b>COMPRESSION_LZ4W</b><br>
+ *  \param src
+ *      Source data buffer containing the packed data to unpack.
+ *  \param dest
+ *      Destination buffer where to store unpacked data (should be word aligned for LZ4W).
+ *  \param windowSize
+ *      0 to unpack in a linear buffer (<i>dest</i> should then be large enough to store the whole unpacked data).<br>
+ *      Otherwise <i>dest</i> is used as a ring window of <i>windowSize</i> bytes (power of 2).<br>
+ *      In that case data should have been packed with match offsets not exceeding the window size and the
+ *      caller has to consume data before it is overwritten (see unpackStream(..)).
+ *  \see unpackStream(..)
+ */
+void unpackStreamInit(UnpackStream *us, u16 compression, const u8 *src, u8 *dest, u16 windowSize);
+/**
+ *  \brief
+ *      Unpack up to <i>size</i> bytes then return, next call resumes where it stopped.
+ *
+ *  \param us
+ *      Unpacker state (see unpackStreamInit(..)).
+ *  \param size
+ *      Maximum number of byte to unpack (should be even for LZ4W).<br>
+ *      When a ring window is used the written bytes start at <i>dest</i> + (unpackStreamGetPos(us) & (windowSize - 1))
+ *      taken before the call, so size should never exceed the window size minus the match offset bound.
+ *  \return
+ *      Number of byte actually unpacked, a value lower than <i>size</i> means the end of packed data is reached.
+ */
+u16 unpackStream(UnpackStream *us, u16 size);
+/**
+ *  \brief
+ *      Return the total number of byte unpacked so far by the incremental unpacker.
+ */
+u32 unpackStreamGetPos(UnpackStream *us);
+/**
+ *  \brief
+ *      Return TRUE if the incremental unpacker reached the end of packed data.
+ */
+u16 unpackStreamIsDone(UnpackStream *us);
 
 /**
  *  \brief
@@ -784,6 +784,56 @@ void VDP_setWindowHPos(u16 right, u16 pos);
  */
 void VDP_setWindowVPos(u16 down, u16 pos);
 
+/**
+ *  \brief
+ *      Enable extended vertical blank (display disabled on top and bottom border) to get more DMA bandwidth.
+ *
+ *  \param top
+ *      Number of scanline to blank at top of the screen (limited to half of the remaining active area).
+ *  \param bottom
+ *      Number of scanline to blank at bottom of the screen (limited to half of screen height).
+ *
+ *  \return
+ *      FALSE if the bitmap mode is enabled (both modes use H-Int processing so they are exclusive).
+ *
+ *  Set both values to 0 to disable extended blank (default).<br>
+ *  Display is disabled from H-Int at the start of bottom border up to the end of top border and the DMA queue is flushed
+ *  at the start of bottom border (at VBlank if there is no bottom border) so it can use all the extended blank period.<br>
+ *  As H-Int happens during active display, the bottom border process is only done when main code is waiting in VDP_waitVSync()
+ *  so it can't break a VDP or Z80 access in progress, otherwise the bottom border is not blanked for this frame and the DMA
+ *  queue is flushed at VBlank (so better to call VDP_waitVSync() before the bottom border starts).<br>
+ *  The end of the top border re-enables the display from H-Int: as for V-Int, VDP accesses done by main code at this time
+ *  should be protected with SYS_disableInts().<br>
+ *  The DMA queue capacity (see DMA_setMaxTransferSize(..)) is automatically set from the extended blank size, the video system
+ *  (PAL / NTSC) and the screen width, previous capacity is restored when extended blank is disabled.<br>
+ *  When the bottom border isn't blanked for a frame, the capacity is reduced to VBlank and top border for the VBlank flush.<br>
+ *  It uses H-Int (so it can't be used at same time than bitmap mode or with your own H-Int counter setting) and needs to be set again
+ *  after screen resolution change.<br>
+ *  Note that VDP_waitVSync() returns at the start of bottom border as VDP reports blank as soon display is disabled.
+ *
+ *  \see VDP_getVBlankDMACapacity()
+ */
+u16 VDP_setExtendedVBlank(u16 top, u16 bottom);
+/**
+ *  \brief
+ *      Returns the number of blanked scanline at top of the screen (see VDP_setExtendedVBlank(..)).
+ */
+u16 VDP_getExtendedVBlankTop();
+/**
+ *  \brief
+ *      Returns the number of blanked scanline at bottom of the screen (see VDP_setExtendedVBlank(..)).
+ */
+u16 VDP_getExtendedVBlankBottom();
+/**
+ *  \brief
+ *      Returns the estimated number of byte the DMA can transfer during the (extended) vertical blank.
+ *
+ *  Computed from the number of blanked scanline, the video system (PAL / NTSC) and the screen width.
+ *
+ *  \see VDP_setExtendedVBlank(..)
+ */
+u16 VDP_getVBlankDMACapacity();
+
 /**
  *  \brief
  *      Wait for DMA operation to complete.
@@ -800,7 +850,8 @@ void VDP_waitFIFOEmpty();
  *  \brief
  *      Wait for Vertical Synchro.
  *
- *  The method actually wait for the next start of Vertical blanking.
+ *  The method actually wait for the next start of Vertical blanking.<br>
+ *  Background tasks (see TASK_add(..)) are processed while waiting.
  */
 void VDP_waitVSync();
 
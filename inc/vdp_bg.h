@@ -435,7 +435,9 @@ void VDP_clearTextLine(u16 y);
  *
  *  This function does "on the fly" 4bpp bitmap conversion to tile data and transfert them to VRAM.<br>
  *  It's very helpful when you use bitmap images but the conversion eats sometime so you should use it only for static screen only.<br>
- *  For "in-game" condition you should use VDP_loadTileData() method with prepared tile data.
+ *  For "in-game" condition you should use VDP_loadTileData() method with prepared tile data.<br>
+ *  Bitmap using the tiled layout (rescomp BITMAP TILED option) skip the conversion: tile data is directly
+ *  uploaded by DMA before the tilemap is written.
  *
  *  \see VDP_loadBMPTileData()
  */
@@ -467,6 +469,8 @@ u16 VDP_drawBitmap(VDPPlan plan, const Bitmap *bitmap, u16 x, u16 y);
  *  This function does "on the fly" 4bpp bitmap conversion to tile data and transfert them to VRAM.<br>
  *  It's very helpful when you use bitmap images but the conversion eats sometime so you should use it only for static screen only.<br>
  *  For "in-game" condition you should use VDP_loadTileData() method with prepared tile data.<br>
+ *  Bitmap using the tiled layout (rescomp BITMAP TILED option) skip the conversion: tile data is directly
+ *  uploaded by DMA before the tilemap is written.
  *
  *  \see VDP_loadBMPTileData()
  */
@@ -8,6 +8,7 @@
  * - upload tiles to VDP memory<br>
  * - upload tiles to VDP memory from bitmap data<br>
  * - clear / fill / set tile map data<br>
+ * - optional RAM shadow of plan tilemap sent through the DMA queue<br>
  */
 
 #ifndef _VDP_TILE_H_
@@ -170,7 +171,9 @@ void VDP_loadTileData(const u32 *data, u16 index, u16 num, TransferMethod tm);
  *
  *  \param tileset
  *      Pointer to TileSet structure.<br>
- *      The TileSet is unpacked "on-the-fly" if needed (require some memory)
+ *      The TileSet is unpacked "on-the-fly" if needed (require some memory).<br>
+ *      LZ4W packed TileSet is directly unpacked in VRAM (no memory required) when CPU transfer method is used
+ *      or when there is not enough memory to unpack it (see lz4w_unpackToVRam(..)).
  *  \param index
  *      Tile index where start tile data load (use TILE_USERINDEX as base user index).
  *  \param tm
@@ -180,7 +183,7 @@ void VDP_loadTileData(const u32 *data, u16 index, u16 num, TransferMethod tm);
  *      - DMA<br>
  *      - DMA_QUEUE
  *  \return
- *      FALSE if there is not enough memory to unpack the specified TileSet (only if compression was enabled).
+ *      FALSE if there is not enough memory to unpack the specified TileSet (only if APLIB compression was enabled).
  *
  *  Transfert rate:<br>
  *  ~90 bytes per scanline in software (during blanking)<br>
@@ -688,5 +691,66 @@ u16 VDP_setMap(VDPPlan plan, const Map *map, u16 basetile, u16 x, u16 y);
  */
 u16 VDP_setMapEx(VDPPlan plan, const Map *map, u16 basetile, u16 x, u16 y, u16 xm, u16 ym, u16 wm, u16 hm);
 
+/**
+ *  \brief
+ *      Enable the RAM shadow of the specified plan tilemap.
+ *
+ *  \param plan
+ *      Plan we want to shadow.<br>
+ *      Accepted values are:<br>
+ *      - PLAN_A<br>
+ *      - PLAN_B<br>
+ *      - PLAN_WINDOW<br>
+ *  \return
+ *      FALSE if there is not enough memory to allocate the shadow buffer (plan width * plan height * 2 bytes + 2 bytes per row).
+ *
+ *  When the shadow is enabled, all XY / rectangle based tilemap methods of the plan (VDP_setTileMapXY(), VDP_fillTileMapRect(),
+ *  VDP_setTileMapDataRectEx(), VDP_setMap(), text drawing...) only modify the RAM copy and record modified span of each row.<br>
+ *  Modified spans are queued at VBlank (V-Int processing, just before the DMA queue flush) with as few DMA transfers as possible
+ *  so many small tilemap updates are cheap. VDP_flushPlanShadow() can be used to queue them earlier.<br>
+ *  Index based methods (VDP_setTileMap(), VDP_fillTileMap(), VDP_clearTileMap(), VDP_setTileMapData()...) still write VRAM directly and
+ *  also update the RAM copy.<br>
+ *  Current plan tilemap is read back from VRAM when the shadow is enabled. The shadow has to be disabled and enabled again after
+ *  a change of plan size (VDP_setPlanSize()) or screen width (window plan).
+ *
+ *  \see VDP_flushPlanShadow()
+ *  \see VDP_disablePlanShadow()
+ */
+u16 VDP_enablePlanShadow(VDPPlan plan);
+/**
+ *  \brief
+ *      Disable the RAM shadow of the specified plan tilemap and release its buffer.
+ *
+ *  \param plan
+ *      Plan we want to stop shadowing.
+ *
+ *  Modifications not yet sent (at VBlank or with VDP_flushPlanShadow()) are lost.<br>
+ *  Don't disable the shadow while its DMA transfers are still pending in the DMA queue (see DMA_isOpDone()).
+ */
+void VDP_disablePlanShadow(VDPPlan plan);
+/**
+ *  \brief
+ *      Returns TRUE if the RAM shadow of the specified plan tilemap is enabled.
+ */
+u16 VDP_isPlanShadowEnabled(VDPPlan plan);
+/**
+ *  \brief
+ *      Queue DMA transfers of the modified parts of all shadowed plans.
+ *
+ *  \return
+ *      Number of DMA operation queued.
+ *
+ *  Modified spans are automatically queued at VBlank (V-Int processing, or bottom border H-Int with extended blank) just
+ *  before the DMA queue flush so calling this method is optional, in both cases they follow the DMA queue transfer limit
+ *  (see DMA_setMaxTransferSize()). When used it should be called once per frame, after all tilemap modifications
+ *  and before VBlank (VDP_waitVSync()).<br>
+ *  Spans are kept for next frame when the DMA queue is locked at VBlank (see DMA_lockQueue()).<br>
+ *  Modified spans of consecutive rows are merged in a single DMA operation when they are close enough.<br>
+ *  If the DMA queue is full, remaining modifications are kept for next flush.
+ *
+ *  \see VDP_enablePlanShadow()
+ */
+u16 VDP_flushPlanShadow();
+
 
 #endif // _VDP_TILE_H_
@@ -139,12 +139,40 @@
  *  1000            | 0                      |
  *                  +------------------------+
  *</pre>
+ *
+ * A VRAM region can also use the segregated fit allocator (see VRAM_createRegionEx(..)).<br>
+ * It uses the same block layout but the last entry of each block repeats the block header (boundary tag)
+ * so adjacent free blocks are merged immediately on release, and free blocks are kept in doubly linked lists
+ * by power of 2 size classes so allocation and release don't need to parse the block list anymore.
  */
 
 #ifndef _VRAM_H_
 #define _VRAM_H_
 
 
+/**
+ *  \brief
+ *      Default VRAM region allocator: first fit on the block list, adjacent free blocks are merged (packed)
+ *      only when an allocation fails.
+ */
+#define VRAM_ALLOC_PACK         0
+/**
+ *  \brief
+ *      Segregated fit VRAM region allocator: free blocks are merged on release and stored in size classes
+ *      (it uses 4 more bytes of memory per tile) so release and the common allocation case (a non empty larger size class)
+ *      are done in constant time.<br>
+ *      When only the request size class has free blocks the allocation falls back to a linear walk of that class list,
+ *      VRAM_getLargestFreeBlock(..) also walks the highest non empty class list.
+ */
+#define VRAM_ALLOC_SEGREGATED   1
+
+/**
+ *  \brief
+ *      Number of free block size class (power of 2) for the segregated fit allocator.
+ */
+#define VRAM_NUM_CLASS          15
+
+
 /**
  *  \brief
  *      VRAM region structure.
@@ -157,6 +185,18 @@
  *      position of next free area
  *  \param vram
  *      allocation buffer
+ *  \param allocator
+ *      allocator used for this region (VRAM_ALLOC_PACK or VRAM_ALLOC_SEGREGATED)
+ *  \param numFreeTile
+ *      number of free tile (segregated fit allocator only)
+ *  \param numFreeBlock
+ *      number of free block (segregated fit allocator only)
+ *  \param classMask
+ *      non empty size classes bit mask (segregated fit allocator only)
+ *  \param classHead
+ *      first free block of each size class (segregated fit allocator only)
+ *  \param links
+ *      free block next / previous links (segregated fit allocator only)
  *
  * Define cache information for a VRAM region dedicated to tile storage.
  */
@@ -166,6 +206,12 @@ typedef struct
     u16 endIndex;
     u16 *free;
     u16 *vram;
+    u16 allocator;
+    u16 numFreeTile;
+    u16 numFreeBlock;
+    u16 classMask;
+    u16 classHead[VRAM_NUM_CLASS];
+    u16 *links;
 } VRAMRegion;
 
 
@@ -180,12 +226,32 @@ typedef struct
  *  \param size
  *      Size in tile of the region.
  *
- * Set parameters and allocate memory for the VRAM region structure.
+ * Set parameters and allocate memory for the VRAM region structure (default VRAM_ALLOC_PACK allocator).
  *
+ * \see VRAM_createRegionEx(..)
  * \see VRAM_releaseRegion(..)
  *
  */
 void VRAM_createRegion(VRAMRegion *region, u16 startIndex, u16 size);
+/**
+ *  \brief
+ *      Initialize a new VRAM region structure using the specified allocator.
+ *
+ *  \param region
+ *      Region to initialize.
+ *  \param startIndex
+ *      Tile start index in VRAM.
+ *  \param size
+ *      Size in tile of the region.
+ *  \param allocator
+ *      Allocator to use:<br>
+ *      VRAM_ALLOC_PACK = default allocator, small memory footprint but allocation can be slow and fragment the region.<br>
+ *      VRAM_ALLOC_SEGREGATED = constant time release and allocation in common case (linear fallback on the request size
+ *      class list), free blocks are merged immediately.
+ *
+ * \see VRAM_releaseRegion(..)
+ */
+void VRAM_createRegionEx(VRAMRegion *region, u16 startIndex, u16 size, u16 allocator);
 /**
  *  \brief
  *      Release the VRAM region structure.
@@ -237,6 +303,27 @@ u16 VRAM_getAllocated(VRAMRegion *region);
  *      the largest free block index in the specified VRAM region.
  */
 u16 VRAM_getLargestFreeBlock(VRAMRegion *region);
+/**
+ *  \brief
+ *      Return the number of free block (adjacent free blocks count as a single one) in the specified VRAM region.
+ *
+ *  \param region
+ *      VRAM region
+ *  \return
+ *      the number of free block in the specified VRAM region.
+ */
+u16 VRAM_getNumFreeBlock(VRAMRegion *region);
+/**
+ *  \brief
+ *      Return the fragmentation level of the specified VRAM region.
+ *
+ *  \param region
+ *      VRAM region
+ *  \return
+ *      the percentage (0-100) of free tiles which are not part of the largest free block.<br>
+ *      0 means all free tiles can be allocated in a single block.
+ */
+u16 VRAM_getFragmentation(VRAMRegion *region);
 
 /**
  *  \brief
@@ -253,6 +340,26 @@ u16 VRAM_getLargestFreeBlock(VRAMRegion *region);
  *  \see VRAM_free(..)
  */
 s16 VRAM_alloc(VRAMRegion *region, u16 size);
+/**
+ *  \brief
+ *      Try to allocate the specified number of tile in the lowest free area of the given VRAM region,
+ *      the allocated block has to end before the specified index.
+ *
+ *  \param region
+ *      VRAM region
+ *  \param size
+ *      Number of tile we want to allocate in VRAM (need to be > 0).
+ *  \param index
+ *      The allocated block should end before this tile index.
+ *  \return
+ *      the index in VRAM where we allocated the bloc of tile.<br>
+ *      -1 if there is no free area large enough before index.
+ *
+ *  Used to compact a region: an allocated block can be moved to the returned index then released.
+ *
+ *  \see VRAM_alloc(..)
+ */
+s16 VRAM_allocBelow(VRAMRegion *region, u16 size, u16 index);
 /**
  *  \brief
  *      Release the previously allocated VRAM block at specified index in the given VRAM region.<br>
@@ -24,6 +24,9 @@
 /**
  * \brief
  *      Returns play music state (XGM music player driver).
+ *
+ * Driver status is cached and refreshed on each XGM frame process (V-Int or XGM_nextFrame() in manual sync mode)
+ * so this method doesn't need to request the Z80 BUS.
  */
 u8 XGM_isPlaying();
 /**
@@ -79,6 +82,10 @@ void XGM_resumePlay();
  *
  *  \return
  *      Return non zero if specified channel(s) is(are) playing.
+ *
+ * Driver status is cached and refreshed on each XGM frame process (V-Int or XGM_nextFrame() in manual sync mode),
+ * pending PCM commands are taken into account so a sample is reported as playing as soon as XGM_startPlayPCM(..)
+ * is called (until the driver says otherwise).
  */
 u8 XGM_isPlayingPCM(const u16 channel_mask);
 /**
@@ -135,6 +142,10 @@ void XGM_setPCMFast(const u8 id, const u8 *sample, const u32 len);
  *      #SOUND_PCM_CH2    = channel 2<br>
  *      #SOUND_PCM_CH3    = channel 3<br>
  *      #SOUND_PCM_CH4    = channel 4<br>
+ *
+ * The command is queued in RAM and sent to the driver on next XGM frame process (V-Int or XGM_nextFrame() in
+ * manual sync mode) so several SFX started in the same frame cost a single Z80 BUS request.<br>
+ * If a command is already pending for this channel then the one with highest priority is kept.
  */
 void XGM_startPlayPCM(const u8 id, const u8 priority, const u16 channel);
 /**
@@ -148,6 +159,8 @@ void XGM_startPlayPCM(const u8 id, const u8 priority, const u16 channel);
  *      #SOUND_PCM_CH2    = channel 2<br>
  *      #SOUND_PCM_CH3    = channel 3<br>
  *      #SOUND_PCM_CH4    = channel 4<br>
+ *
+ * As XGM_startPlayPCM(..) the command is queued and sent on next XGM frame process.
  */
 void XGM_stopPlayPCM(const u16 channel);
 
@@ -198,6 +211,9 @@ u16 XGM_getManualSync();
  *  \brief
  *      Set manual sync mode of XGM driver (by default auto sync is used).
  *
+ *  In manual sync mode, queued PCM commands (see XGM_startPlayPCM(..) and XGM_stopPlayPCM(..)) are only sent to the driver
+ *  and the cached driver status (XGM_isPlaying(), XGM_isPlayingPCM(..)...) only refreshed when XGM_nextFrame() is called.
+ *
  *  \param value TRUE or FALSE
  *  \see XGM_getManualSync()
  *  \see XGM_nextFrame()
@@ -288,6 +304,31 @@ void XGM_setForceDelayDMA(u16 value);
  *      and incorrect PCM operations.
  */
 u32 XGM_getCPULoad();
+/**
+ *  \brief
+ *      Returns the number of PCM underrun sample since driver load or last XGM_resetPCMUnderrun() call.<br>
+ *      An underrun happens when the XGM driver outputs samples from a PCM buffer it couldn't fill in time because
+ *      the 68K BUS protection (see #XGM_set68KBUSProtection) lasted too long, that usually means audible glitch.<br>
+ *      Driver counter is read on each XGM frame process (V-Int or XGM_nextFrame() in manual sync).
+ *
+ *  \see XGM_getFramePCMUnderrun()
+ *  \see Z80_getBusStats(..)
+ */
+u32 XGM_getPCMUnderrun();
+/**
+ *  \brief
+ *      Returns the number of PCM underrun sample detected on last XGM frame process.
+ *
+ *  \see XGM_getPCMUnderrun()
+ */
+u16 XGM_getFramePCMUnderrun();
+/**
+ *  \brief
+ *      Reset the PCM underrun counter.
+ *
+ *  \see XGM_getPCMUnderrun()
+ */
+void XGM_resetPCMUnderrun();
 
 
 #endif // _XGM_H_
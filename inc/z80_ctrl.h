@@ -10,6 +10,7 @@
  * - upload / download data to / from Z80 memory<br>
  * - set Z80 external Bank<br>
  * - Z80 driver handling<br>
+ * - Z80 BUS request statistics (when Z80_BUS_STATS is enabled in config.h)<br>
  */
 
 #ifndef _Z80_CTRL_H_
@@ -188,6 +189,85 @@
 
 #define Z80_DRIVER_DEFAULT              Z80_DRIVER_PCM
 
+/**
+ *  \brief
+ *      Z80 BUS requester: user code (default for Z80_requestBus(..)).
+ */
+#define Z80_BUS_USER                    0
+/**
+ *  \brief
+ *      Z80 BUS requester: sound driver methods (SND_xxx).
+ */
+#define Z80_BUS_SOUND                   1
+/**
+ *  \brief
+ *      Z80 BUS requester: XGM driver methods (XGM_xxx).
+ */
+#define Z80_BUS_XGM                     2
+/**
+ *  \brief
+ *      Z80 BUS requester: XGM frame process (V-Int or XGM_nextFrame()).
+ */
+#define Z80_BUS_XGM_FRAME               3
+/**
+ *  \brief
+ *      Z80 BUS requester: DMA queue flush (HALT_Z80_ON_DMA enabled in config.h).
+ */
+#define Z80_BUS_DMA                     4
+/**
+ *  \brief
+ *      XGM 68K BUS protection (see XGM_set68KBUSProtection(..)).<br>
+ *      The Z80 isn't halted but the XGM driver can't access ROM so hold time is the protection time.
+ */
+#define Z80_BUS_PROTECT                 5
+/**
+ *  \brief
+ *      Number of Z80 BUS requester.
+ */
+#define Z80_BUS_REQUESTER_NUM           6
+
+/**
+ *  \brief
+ *      Number of entry in Z80 BUS statistics histograms.
+ */
+#define Z80_BUS_HISTO_SIZE              8
+
+
+/**
+ *  \brief
+ *      Z80 BUS request statistics for a requester (see Z80_getBusStats(..)).
+ *
+ *  \param count
+ *      Total number of BUS request.
+ *  \param time
+ *      Total BUS hold time (in 68000 cycle, wraps after about 9 minutes of hold).
+ *  \param frameCount
+ *      Number of BUS request during last complete frame.
+ *  \param frameTime
+ *      BUS hold time during last complete frame (in 68000 cycle).
+ *  \param maxFrameCount
+ *      Maximum number of BUS request for a frame.
+ *  \param maxFrameTime
+ *      Maximum BUS hold time for a frame (in 68000 cycle).
+ *  \param countHisto
+ *      Number of frame per request count: entry 0 = no request, entry N = 2^(N-1) to 2^N - 1 requests, last entry
+ *      also contains higher values (saturate at 65535).
+ *  \param timeHisto
+ *      Number of frame per hold time: entry 0 = no hold, entry 1 = less than 1 scanline, entry N = 2^(N-2) to
+ *      2^(N-1) scanlines, last entry also contains higher values (saturate at 65535).
+ */
+typedef struct
+{
+    u32 count;
+    u32 time;
+    u16 frameCount;
+    u32 frameTime;
+    u16 maxFrameCount;
+    u32 maxFrameTime;
+    u16 countHisto[Z80_BUS_HISTO_SIZE];
+    u16 timeHisto[Z80_BUS_HISTO_SIZE];
+} Z80BusStats;
+
 
 /**
  *  \brief
@@ -209,6 +289,17 @@ u16  Z80_isBusTaken();
  *      Wait for BUS request operation to complete.
  */
 void Z80_requestBus(u16 wait);
+/**
+ *  \brief
+ *      Request Z80 BUS on behalf of the specified requester (only used by BUS statistics).
+ *  \param wait
+ *      Wait for BUS request operation to complete.
+ *  \param requester
+ *      BUS requester (Z80_BUS_USER, Z80_BUS_SOUND...).
+ *
+ *  \see Z80_getBusStats(..)
+ */
+void Z80_requestBusEx(u16 wait, u16 requester);
 /**
  *  \brief
  *      Release Z80 BUS.
@@ -352,5 +443,31 @@ void Z80_loadCustomDriver(const u8 *drv, u16 size);
  */
 u16  Z80_isDriverReady();
 
+/**
+ *  \brief
+ *      Get Z80 BUS request statistics for the specified requester.
+ *
+ *  \param requester
+ *      BUS requester (Z80_BUS_USER, Z80_BUS_SOUND, Z80_BUS_XGM, Z80_BUS_XGM_FRAME, Z80_BUS_DMA or Z80_BUS_PROTECT).
+ *  \param stats
+ *      Statistics are written here (cleared if Z80_BUS_STATS isn't enabled in config.h).
+ *
+ * Statistics are only collected when Z80_BUS_STATS is set to 1 in config.h (library has to be rebuilt), they tell how
+ * often and how long the Z80 is halted (or can't access ROM) by each requester so DMA / sound usage can be tuned
+ * against audio quality (see also XGM_getPCMUnderrun()).<br>
+ * Hold time is measured with the H/V counter (see PROF_getTime()) so V-Int has to be enabled.
+ */
+void Z80_getBusStats(u16 requester, Z80BusStats *stats);
+/**
+ *  \brief
+ *      Reset Z80 BUS request statistics.
+ */
+void Z80_resetBusStats();
+/**
+ *  \brief
+ *      Log Z80 BUS request statistics through KDebug (Gens KMod or compatible emulator).
+ */
+void Z80_dumpBusStats();
+
 
 #endif // _Z80_CTRL_H_
@@ -4,4 +4,5 @@ SPRITE haggar_sprite "haggar.png" 11 13 FAST 2
 SPRITE andor_sprite "andor.png" 11 15 FAST 2
 SPRITE flare_big "flare_32x32.png" 4 4 NONE 0
 SPRITE flare_small "flare_16x16.png" 2 2 NONE 0
+SPRITE flare_col "flare_16x16.png" 2 2 NONE 0 CIRCLE
 SPRITE donut "donut.png" 4 4 FAST 5
@@ -6,6 +6,8 @@
 
 // forward
 static u32 displayResult(u32 op, fix32 time, u16 y);
+static u16 checkUnpackStream(const TileSet *tileset, u16 ring);
+static void displayUnpackStreamCheck(const char *name, const TileSet *tileset, u16 y);
 
 
 u16 executeBGTest(u16 *scores)
@@ -235,6 +237,50 @@ u16 executeBGTest(u16 *scores)
     // wait 5 seconds
     waitMs(5000);
 
+    VDP_clearPlan(PLAN_A, TRUE);
+    VDP_drawText("128x64 tileset load (LZ4W unpack + DMA)", 1, 0);
+    i = 300;
+    start = getTimeAsFix32(FALSE);
+    while(i--) VDP_loadTileSet(logo_med_f.tileset, TILE_USERINDEX, DMA);
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult(300, end - start, 2);
+    globalScore += *score++;
+
+    // wait 5 seconds
+    waitMs(5000);
+
+    VDP_clearPlan(PLAN_A, TRUE);
+    VDP_drawText("128x64 tileset load (LZ4W direct VRAM)", 1, 0);
+    // rescomp can store the resource unpacked if LZ4W doesn't give any gain
+    if (logo_med_f.tileset->compression == COMPRESSION_LZ4W)
+    {
+        i = 300;
+        start = getTimeAsFix32(FALSE);
+        while(i--) lz4w_unpackToVRam((u8*) logo_med_f.tileset->tiles, TILE_USERINDEX * 32);
+        end = getTimeAsFix32(FALSE);
+        *score = displayResult(300, end - start, 2);
+    }
+    else
+    {
+        VDP_drawText("skipped: tileset is not LZ4W packed", 1, 2);
+        *score = 0;
+    }
+    globalScore += *score++;
+
+    // wait 5 seconds
+    waitMs(5000);
+
+    // resumable unpacker check (not scored): odd sized slices should give same result than one shot unpack
+    VDP_clearPlan(PLAN_A, TRUE);
+    VDP_drawText("Resumable unpack check (odd slices)", 1, 0);
+    displayUnpackStreamCheck("logo_med", logo_med.tileset, 2);
+    displayUnpackStreamCheck("logo_med_f", logo_med_f.tileset, 3);
+    displayUnpackStreamCheck("logo_sm", logo_sm.tileset, 4);
+    displayUnpackStreamCheck("logo_sm_f", logo_sm_f.tileset, 5);
+
+    // wait 5 seconds
+    waitMs(5000);
+
     // unpack image
     img = unpackImage(&logo_med, NULL);
     VDP_clearPlan(PLAN_A, TRUE);
@@ -522,6 +568,104 @@ u16 executeBGTest(u16 *scores)
 }
 
 
+static u16 checkUnpackStream(const TileSet *tileset, u16 ring)
+{
+    // odd slice sizes (in byte for APLIB, in word for LZ4W which requires even size)
+    static const u16 slices[8] = { 1, 3, 7, 13, 31, 61, 127, 251 };
+    const u16 compression = tileset->compression;
+    const u32 size = tileset->numTile * 32;
+    UnpackStream us;
+    u8 *ref;
+    u8 *dst;
+    u32 pos;
+    u16 windowSize;
+    u16 mask;
+    u16 ok;
+    u16 i;
+
+    // ring window has to hold all data as match offsets of existing resources aren't bounded
+    if (ring)
+    {
+        windowSize = 1;
+        while(windowSize < size) windowSize <<= 1;
+        mask = windowSize - 1;
+    }
+    else
+    {
+        windowSize = 0;
+        mask = 0xFFFF;
+    }
+
+    ref = MEM_alloc(size);
+    dst = MEM_alloc(windowSize?windowSize:size);
+
+    if (!ref || !dst)
+    {
+        if (ref) MEM_free(ref);
+        if (dst) MEM_free(dst);
+        return FALSE;
+    }
+
+    // one shot unpack for reference
+    if (compression == COMPRESSION_APLIB) aplib_unpack((u8*) tileset->tiles, ref);
+    else lz4w_unpack((u8*) tileset->tiles, ref);
+
+    unpackStreamInit(&us, compression, (u8*) tileset->tiles, dst, windowSize);
+
+    pos = 0;
+    ok = TRUE;
+    i = 0;
+    while(ok)
+    {
+        u16 len = slices[i++ & 7];
+        u16 n;
+        u16 j;
+
+        if (compression == COMPRESSION_LZ4W) len <<= 1;
+
+        n = unpackStream(&us, len);
+
+        // compare the slice (written from pos in the ring window)
+        for(j = 0; j < n; j++)
+        {
+            if (dst[(pos + j) & mask] != ref[pos + j])
+            {
+                ok = FALSE;
+                break;
+            }
+        }
+
+        pos += n;
+
+        // end of packed data
+        if (n < len) break;
+    }
+
+    MEM_free(dst);
+    MEM_free(ref);
+
+    return ok && (pos == size) && unpackStreamIsDone(&us);
+}
+
+static void displayUnpackStreamCheck(const char *name, const TileSet *tileset, u16 y)
+{
+    char str[41];
+
+    strcpy(str, name);
+
+    // rescomp can store the resource unpacked if compression doesn't give any gain
+    if ((tileset->compression != COMPRESSION_APLIB) && (tileset->compression != COMPRESSION_LZ4W))
+        strcat(str, ": skipped (not packed)");
+    else
+    {
+        strcat(str, (tileset->compression == COMPRESSION_APLIB)?" APLIB":" LZ4W");
+        strcat(str, checkUnpackStream(tileset, FALSE)?" linear OK":" linear FAIL");
+        strcat(str, checkUnpackStream(tileset, TRUE)?" ring OK":" ring FAIL");
+    }
+
+    VDP_drawText(str, 2, y);
+}
+
 static u32 displayResult(u32 op, fix32 time, u16 y)
 {
     char timeStr[32];
@@ -8,6 +8,8 @@
 #define MAX_LINE            100
 #define MAX_POLYGON         40
 #define MAX_PT_PER_POLY     6
+#define MAX_OBJECT          8
+#define MAX_FACE            (MAX_OBJECT * 6)
 
 
 typedef struct
@@ -17,11 +19,54 @@ typedef struct
     u8 col;
 } Polygone;
 
+typedef struct
+{
+    Vect2D_s16 pts[4];
+    s16 z;
+    u8 col;
+} Face;
+
+
+//    CUBE
+//
+//    6----7
+//   /|   /|
+//  2-+--4 |
+//  | |  | |
+//  | 3--+-5
+//  |/   |/
+//  0----1
+
+static const Vect3D_f16 cube_coord[8] =
+{
+    {FIX16(-5), FIX16(-5), FIX16(-5)},
+    {FIX16(5), FIX16(-5), FIX16(-5)},
+    {FIX16(-5), FIX16(5), FIX16(-5)},
+    {FIX16(-5), FIX16(-5), FIX16(5)},
+    {FIX16(5), FIX16(5), FIX16(-5)},
+    {FIX16(5), FIX16(-5), FIX16(5)},
+    {FIX16(-5), FIX16(5), FIX16(5)},
+    {FIX16(5), FIX16(5), FIX16(5)}
+};
+
+static const u16 cube_poly_ind[6 * 4] =
+{
+    6, 3, 5, 7,
+    0, 2, 4, 1,
+    2, 6, 7, 4,
+    3, 0, 1, 5,
+    1, 4, 7, 5,
+    3, 6, 2, 0
+};
+
 
 // forward
 static void initPixels(Pixel *pixels, u16 num);
 static void initLines(Line *lines, u16 num, u16 clipped);
 static void initPolys(Vect2D_s16 *pts, Polygone *polys, u16 numPts, u16 num);
+static u16 executeFlipTest(Vect2D_s16 *pts, Polygone *polys, u16 dma);
+static u16 executeSceneTest(u16 spanBuffer);
+static u16 buildScene(Face *faces, Transformation3D *transform, u16 frame);
 
 static u16 displayResult(u32 op, fix32 time, u16 y);
 static u16 displayResult2(u32 op, fix32 time, u16 y);
@@ -673,6 +718,34 @@ u16 executeBMPTest(u16 *scores)
     *score = displayResult(2 * 2 * (128-32), time, 3) * 10;
     globalScore += *score++;
 
+    VDP_drawText("Flip and draw (CPU transfer)", 2, 8);
+    waitMs(4000);
+    VDP_clearPlan(PLAN_A, TRUE);
+
+    *score = executeFlipTest(pts, polys, FALSE);
+    globalScore += *score++;
+
+    VDP_drawText("Flip and draw (DMA transfer)", 2, 8);
+    waitMs(4000);
+    VDP_clearPlan(PLAN_A, TRUE);
+
+    *score = executeFlipTest(pts, polys, TRUE);
+    globalScore += *score++;
+
+    VDP_drawText("3D scene draw (painter order)", 2, 8);
+    waitMs(4000);
+    VDP_clearPlan(PLAN_A, TRUE);
+
+    *score = executeSceneTest(FALSE);
+    globalScore += *score++;
+
+    VDP_drawText("3D scene draw (span buffer)", 2, 8);
+    waitMs(4000);
+    VDP_clearPlan(PLAN_A, TRUE);
+
+    *score = executeSceneTest(TRUE);
+    globalScore += *score++;
+
     waitMs(5000);
     VDP_clearPlan(PLAN_A, TRUE);
 
@@ -685,6 +758,188 @@ u16 executeBMPTest(u16 *scores)
 }
 
 
+static u16 executeFlipTest(Vect2D_s16 *pts, Polygone *polys, u16 dma)
+{
+    char str[64];
+    fix32 start;
+    fix32 end;
+    u32 frames;
+    u32 drawn;
+    Polygone *pol;
+    u16 j;
+
+    VDP_setPalette(PAL1, palette_grey);
+    BMP_init(TRUE, PLAN_A, PAL1, FALSE);
+    BMP_setDMATransfer(dma);
+
+    initPolys(pts, polys, 0, 25);
+
+    frames = 0;
+    drawn = 0;
+    start = getTimeAsFix32(FALSE);
+    end = start + FIX32(5);
+    while(getTimeAsFix32(FALSE) < end)
+    {
+        BMP_clear();
+
+        // fixed workload
+        pol = polys;
+        j = 10;
+        while(j--)
+        {
+            BMP_drawPolygon(pol->pts, pol->numPts, pol->col);
+            pol++;
+        }
+        drawn += 10;
+
+        // CPU time left while previous flip is still in progress
+        while(BMP_hasFlipInProgess())
+        {
+            BMP_drawPolygon(pol->pts, pol->numPts, pol->col);
+            drawn++;
+            if (++pol >= &polys[25]) pol = polys;
+        }
+
+        BMP_showFPS(FALSE);
+        BMP_flip(TRUE);
+        frames++;
+    }
+    end = getTimeAsFix32(FALSE);
+    BMP_end();
+
+    VDP_clearPlan(PLAN_A, TRUE);
+    if (dma) VDP_drawText("Flip and draw (DMA transfer)", 2, 1);
+    else VDP_drawText("Flip and draw (CPU transfer)", 2, 1);
+    sprintf(str, "Flip rate = %d FPS", (int) fix32ToRoundedInt(fix32Div(intToFix32(frames), end - start)));
+    VDP_drawText(str, 3, 3);
+
+    return displayResult(drawn, end - start, 4);
+}
+
+static u16 executeSceneTest(u16 spanBuffer)
+{
+    fix32 start;
+    fix32 end;
+    fix32 time;
+    Face *faces;
+    Translation3D translation;
+    Rotation3D rotation;
+    Transformation3D transformation;
+    u16 frame;
+
+    faces = MEM_alloc(MAX_FACE * sizeof(Face));
+
+    VDP_setPalette(PAL1, palette_grey);
+    BMP_init(TRUE, PLAN_A, PAL1, FALSE);
+    if (spanBuffer) BMP_initSpanBuffer(MAX_FACE);
+
+    M3D_reset();
+    M3D_setCamDistance(FIX16(15));
+    M3D_setTransform(&transformation, &translation, &rotation);
+
+    time = FIX32(0);
+    for(frame = 0; frame < 100; frame++)
+    {
+        u16 num = buildScene(faces, &transformation, frame);
+
+        BMP_clear();
+
+        start = getTimeAsFix32(FALSE);
+        if (spanBuffer)
+        {
+            Face *f = faces;
+            u16 j = num;
+
+            // order doesn't matter, span buffer sorts them
+            while(j--)
+            {
+                BMP_submitPolygon(f->pts, 4, f->col, f->z);
+                f++;
+            }
+
+            BMP_flushPolygons();
+        }
+        else
+        {
+            // faces are sorted from front to back --> draw them backward
+            Face *f = &faces[num];
+            u16 j = num;
+
+            while(j--)
+            {
+                f--;
+                BMP_drawPolygon(f->pts, 4, f->col);
+            }
+        }
+        end = getTimeAsFix32(FALSE);
+        time += end - start;
+
+        BMP_flip(FALSE);
+    }
+    BMP_end();
+
+    MEM_free(faces);
+
+    VDP_clearPlan(PLAN_A, TRUE);
+    if (spanBuffer) VDP_drawText("3D scene draw (span buffer)", 2, 1);
+    else VDP_drawText("3D scene draw (painter order)", 2, 1);
+
+    return displayResult(100, time, 3);
+}
+
+// build visible faces of rotating cubes, sorted from front to back
+static u16 buildScene(Face *faces, Transformation3D *transform, u16 frame)
+{
+    Vect3D_f16 pts3D[8];
+    Vect2D_s16 pts2D[8];
+    u16 num;
+    u16 o;
+
+    num = 0;
+    for(o = 0; o < MAX_OBJECT; o++)
+    {
+        const u16 *ind = cube_poly_ind;
+        u16 i;
+
+        // objects overlap on screen at different depth
+        M3D_setTranslation(transform, FIX16(((s16) (o & 3) * 6) - 9), FIX16(((s16) (o >> 2) * 8) - 4), FIX16(20 + (o * 5)));
+        M3D_setRotation(transform, frame * (o + 2), frame * 3, frame * (8 - o));
+
+        M3D_transform(transform, cube_coord, pts3D, 8);
+        M3D_project_s16(pts3D, pts2D, 8);
+
+        for(i = 0; i < 6; i++)
+        {
+            Face *f = &faces[num];
+            u16 j;
+
+            f->pts[0] = pts2D[ind[0]];
+            f->pts[1] = pts2D[ind[1]];
+            f->pts[2] = pts2D[ind[2]];
+            f->pts[3] = pts2D[ind[3]];
+            f->z = (pts3D[ind[0]].z + pts3D[ind[1]].z + pts3D[ind[2]].z + pts3D[ind[3]].z) >> 2;
+            f->col = (((o + i) & 7) + 8) * 0x11;
+            ind += 4;
+
+            if (BMP_isPolygonCulled(f->pts, 4)) continue;
+
+            // insertion sort from front to back
+            j = num;
+            while(j && (faces[j - 1].z > f->z))
+            {
+                Face tmp = faces[j - 1];
+                faces[j - 1] = faces[j];
+                faces[j] = tmp;
+                f = &faces[--j];
+            }
+
+            num++;
+        }
+    }
+
+    return num;
+}
+
 static void initPixels(Pixel *pixels, u16 num)
 {
     u16 i = num;
@@ -6,7 +6,7 @@
 #define SGDK_BENCHMARK      "SGDK benchmark v1.22"
 
 #define MAX_TEST            9
-#define MAX_SUBTEST         16
+#define MAX_SUBTEST         32
 
 
 u16 detailledScores[MAX_TEST][MAX_SUBTEST];
@@ -22,6 +22,9 @@ void bench_divs(u32 src, u16 dst, u16 len);
 // forward
 static u32 displayResult(u32 op, fix32 time, u16 y, u32 dirty);
 static u32 displayResult3D(u32 op, fix32 time, u16 y, u32 dirty);
+static void displayCyclesPerOp(u32 op, fix32 time, u16 y, const char *unit);
+static u16 checkMathsKernels(const Vect3D_f16 *src, Vect3D_f16 *dst);
+static u16 processMeshSeparate(Transformation3D *t, const Mesh3D *mesh, Vect3D_f16 *buf3D, Vect2D_s16 *buf2D, Face3D *dest, u16 col);
 
 u16 executeMathsBasicTest(u16 *scores)
 {
@@ -398,6 +401,9 @@ u16 executeMathsAdvTest(u16 *scores)
     Rotation3D rotation;
     Translation3D translation;
     Transformation3D transformation;
+    Mesh3D mesh;
+    u16 *faceInd;
+    Face3D *faces;
 
     src_3D = MEM_alloc(1024 * sizeof(Vect3D_f16));
     res_3D = MEM_alloc(1024 * sizeof(Vect3D_f16));
@@ -606,6 +612,217 @@ u16 executeMathsAdvTest(u16 *scores)
     waitMs(5000);
     VDP_clearPlan(PLAN_A, TRUE);
 
+    // 3D mesh tests
+
+    y = 0;
+    VDP_drawText("Executing 3D mesh tests...", 1, y++);
+    y++;
+
+    // 16x16 vertices grid mesh (225 faces), normals are only used for lighting cost
+    faceInd = MEM_alloc(15 * 15 * 4 * sizeof(u16));
+    faces = MEM_alloc(15 * 15 * sizeof(Face3D));
+
+    for(i = 0; i < 15 * 15; i++)
+    {
+        const u16 ind = ((i / 15) * 16) + (i % 15);
+
+        faceInd[(i * 4) + 0] = ind;
+        faceInd[(i * 4) + 1] = ind + 1;
+        faceInd[(i * 4) + 2] = ind + 17;
+        faceInd[(i * 4) + 3] = ind + 16;
+    }
+
+    mesh.numVertex = 16 * 16;
+    mesh.numFace = 15 * 15;
+    mesh.vertices = src_3D;
+    mesh.faceNormals = &src_3D[256];
+    mesh.faceIndexes = faceInd;
+
+    M3D_setLightEnabled(1);
+    M3D_setLightXYZ(FIX16(0.9), FIX16(0.9), FIX16(-0.9));
+    transformation.rebuildMat = 1;
+
+    VDP_drawText("Transform+proj+cull+light (x100)", 2, y++);
+    i = 100;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        processMeshSeparate(&transformation, &mesh, res_3D, res_2D, faces, 2);
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult3D(256 * 100, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(256 * 100, end - start, y++, "vertex");
+    y++;
+
+    VDP_drawText("Fused mesh pipeline (x100)", 2, y++);
+    i = 100;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        M3D_processMesh(&transformation, &mesh, (Vect3D_s16*) res_3D, faces, 2);
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult3D(256 * 100, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(256 * 100, end - start, y++, "vertex");
+    y++;
+
+    M3D_setLightEnabled(0);
+
+    waitMs(5000);
+    VDP_clearPlan(PLAN_A, TRUE);
+
+    // maths kernels tests
+
+    y = 0;
+    VDP_drawText("Executing maths kernels tests...", 1, y++);
+    if (checkMathsKernels(src_3D, res_3D)) VDP_drawText("Check against C reference: FAILED", 2, y++);
+    else VDP_drawText("Check against C reference: OK", 2, y++);
+    y++;
+
+    VDP_drawText("Vect3D add for 1024 vectors (x50)", 2, y++);
+    i = 50;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        vect3DAdd_f16(src_3D, res_3D, res_3D, 1024);
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult3D(1024 * 50, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(1024 * 50, end - start, y++, "vector");
+    y++;
+
+    VDP_drawText("Vect3D scale for 1024 vectors (x50)", 2, y++);
+    i = 50;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        vect3DScale_f16(src_3D, FIX16(0.75), res_3D, 1024);
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult3D(1024 * 50, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(1024 * 50, end - start, y++, "vector");
+    y++;
+
+    VDP_drawText("Vect3D dot for 1024 vectors (x50)", 2, y++);
+    i = 50;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        vect3DDot_f16(src_3D, res_3D, (fix16*) res_2D, 1024);
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult3D(1024 * 50, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(1024 * 50, end - start, y++, "vector");
+    y++;
+
+    VDP_drawText("Mat3D x Vect3D for 1024 vectors (x50)", 2, y++);
+    i = 50;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        mat3DMulVect3D_f16(&transformation.mat, src_3D, res_3D, 1024);
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult3D(1024 * 50, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(1024 * 50, end - start, y++, "vector");
+    y++;
+
+    VDP_drawText("fix32Mul for 1024 values (x20)", 2, y++);
+    i = 20;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        const fix32 *s = (fix32*) src_3D;
+        fix32 *d = (fix32*) res_3D;
+        u16 j = 1024;
+
+        while(j--)
+        {
+            *d++ = fix32Mul(s[0], s[1]);
+            s++;
+        }
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult(1024 * 20, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(1024 * 20, end - start, y++, "op");
+    y++;
+
+    VDP_drawText("fix32MulSafe for 1024 values (x20)", 2, y++);
+    i = 20;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        const fix32 *s = (fix32*) src_3D;
+        fix32 *d = (fix32*) res_3D;
+        u16 j = 1024;
+
+        while(j--)
+        {
+            *d++ = fix32MulSafe(s[0], s[1]);
+            s++;
+        }
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult(1024 * 20, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(1024 * 20, end - start, y++, "op");
+    y++;
+
+    VDP_drawText("fix16Div for 1024 values (x20)", 2, y++);
+    i = 20;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        const fix16 *s = (fix16*) src_3D;
+        fix16 *d = (fix16*) res_3D;
+        u16 j = 1024;
+
+        while(j--)
+        {
+            // keep divisor in [1..1023] range
+            *d++ = fix16Div(s[0], (s[1] & 0x3FF) | 1);
+            s++;
+        }
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult(1024 * 20, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(1024 * 20, end - start, y++, "op");
+    y++;
+
+    VDP_drawText("fix16DivFast for 1024 values (x20)", 2, y++);
+    i = 20;
+    start = getTimeAsFix32(FALSE);
+    while(i--)
+    {
+        const fix16 *s = (fix16*) src_3D;
+        fix16 *d = (fix16*) res_3D;
+        u16 j = 1024;
+
+        while(j--)
+        {
+            // keep divisor in [1..1023] range
+            *d++ = fix16DivFast(s[0], (s[1] & 0x3FF) | 1);
+            s++;
+        }
+    }
+    end = getTimeAsFix32(FALSE);
+    *score = displayResult(1024 * 20, end - start, y++, 0);
+    globalScore += *score++;
+    displayCyclesPerOp(1024 * 20, end - start, y++, "op");
+
+    waitMs(5000);
+    VDP_clearPlan(PLAN_A, TRUE);
+
+    MEM_free(faces);
+    MEM_free(faceInd);
     MEM_free(src_3D);
     MEM_free(res_3D);
     MEM_free(res_2D);
@@ -614,6 +831,144 @@ u16 executeMathsAdvTest(u16 *scores)
 }
 
 
+static u16 processMeshSeparate(Transformation3D *t, const Mesh3D *mesh, Vect3D_f16 *buf3D, Vect2D_s16 *buf2D, Face3D *dest, u16 col)
+{
+    const Vect3D_f16 *norm;
+    const u16 *ind;
+    Face3D *face;
+    u16 i;
+
+    M3D_transform(t, mesh->vertices, buf3D, mesh->numVertex);
+    M3D_project_s16(buf3D, buf2D, mesh->numVertex);
+
+    norm = mesh->faceNormals;
+    ind = mesh->faceIndexes;
+    face = dest;
+    i = mesh->numFace;
+
+    while(i--)
+    {
+        fix16 dp;
+
+        face->pts[0] = buf2D[ind[0]];
+        face->pts[1] = buf2D[ind[1]];
+        face->pts[2] = buf2D[ind[2]];
+        face->pts[3] = buf2D[ind[3]];
+
+        if (!BMP_isPolygonCulled(face->pts, 4))
+        {
+            face->z = (buf3D[ind[0]].z + buf3D[ind[1]].z + buf3D[ind[2]].z + buf3D[ind[3]].z) >> 2;
+            face->col = col;
+
+            dp = fix16Mul(t->lightInv.x, norm->x) +
+                 fix16Mul(t->lightInv.y, norm->y) +
+                 fix16Mul(t->lightInv.z, norm->z);
+
+            if (dp > 0) face->col += (dp >> (FIX16_FRAC_BITS - 2));
+
+            face++;
+        }
+
+        ind += 4;
+        norm++;
+    }
+
+    return face - dest;
+}
+
+
+// check asm maths kernels against C reference code, return number of errors
+static u16 checkMathsKernels(const Vect3D_f16 *src, Vect3D_f16 *dst)
+{
+    const Vect3D_f16 *src2 = &src[256];
+    const Mat3D_f16 mat =
+    {
+        {FIX16(0.5), FIX16(-0.25), FIX16(1)},
+        {FIX16(-1), FIX16(0.75), FIX16(0.125)},
+        {FIX16(0.25), FIX16(1.5), FIX16(-0.5)}
+    };
+    const fix16 scale = FIX16(-1.25);
+    fix16 *dots;
+    const fix32 *src32;
+    const fix16 *src16;
+    Mat3D_f16 matRes;
+    u16 err;
+    u16 i;
+
+    err = 0;
+    dots = (fix16*) &dst[256];
+
+    vect3DAdd_f16(src, src2, dst, 256);
+    for(i = 0; i < 256; i++)
+    {
+        if ((dst[i].x != (fix16) (src[i].x + src2[i].x)) ||
+            (dst[i].y != (fix16) (src[i].y + src2[i].y)) ||
+            (dst[i].z != (fix16) (src[i].z + src2[i].z))) err++;
+    }
+
+    vect3DScale_f16(src, scale, dst, 256);
+    for(i = 0; i < 256; i++)
+    {
+        if ((dst[i].x != (fix16) fix16Mul(src[i].x, scale)) ||
+            (dst[i].y != (fix16) fix16Mul(src[i].y, scale)) ||
+            (dst[i].z != (fix16) fix16Mul(src[i].z, scale))) err++;
+    }
+
+    vect2DScale_f16((Vect2D_f16*) src, scale, (Vect2D_f16*) dst, 256);
+    for(i = 0; i < 256 * 2; i++)
+    {
+        if (((fix16*) dst)[i] != (fix16) fix16Mul(((fix16*) src)[i], scale)) err++;
+    }
+
+    vect3DDot_f16(src, src2, dots, 256);
+    for(i = 0; i < 256; i++)
+    {
+        if (dots[i] != (fix16) (((src[i].x * src2[i].x) + (src[i].y * src2[i].y) + (src[i].z * src2[i].z)) >> FIX16_FRAC_BITS)) err++;
+    }
+
+    mat3DMulVect3D_f16(&mat, src, dst, 256);
+    for(i = 0; i < 256; i++)
+    {
+        if ((dst[i].x != (fix16) (((mat.a.x * src[i].x) + (mat.a.y * src[i].y) + (mat.a.z * src[i].z)) >> FIX16_FRAC_BITS)) ||
+            (dst[i].y != (fix16) (((mat.b.x * src[i].x) + (mat.b.y * src[i].y) + (mat.b.z * src[i].z)) >> FIX16_FRAC_BITS)) ||
+            (dst[i].z != (fix16) (((mat.c.x * src[i].x) + (mat.c.y * src[i].y) + (mat.c.z * src[i].z)) >> FIX16_FRAC_BITS))) err++;
+    }
+
+    mat3DMul_f16(&mat, &mat, &matRes);
+    if (matRes.a.y != (fix16) (((mat.a.x * mat.a.y) + (mat.a.y * mat.b.y) + (mat.a.z * mat.c.y)) >> FIX16_FRAC_BITS)) err++;
+    if (matRes.c.z != (fix16) (((mat.c.x * mat.a.z) + (mat.c.y * mat.b.z) + (mat.c.z * mat.c.z)) >> FIX16_FRAC_BITS)) err++;
+
+    // safe multiply should give same result when standard one does not overflow
+    src32 = (fix32*) src;
+    for(i = 0; i < 256; i++)
+    {
+        const fix32 a = src32[i] >> 16;
+        const fix32 b = src32[i + 1] >> 15;
+
+        if (fix32MulSafe(a, b) != fix32Mul(a, b)) err++;
+    }
+    // and should not overflow
+    if (fix32MulSafe(FIX32(1000), FIX32(-1000)) != FIX32(-1000000)) err++;
+
+    // fast division is an approximation (< 1/64 relative error)
+    src16 = (fix16*) src;
+    for(i = 0; i < 256; i++)
+    {
+        const fix16 a = src16[i];
+        const fix16 b = (src16[i + 1] & 0x3FF) | 1;
+        const s32 ref = fix16Div((s32) a, (s32) b);
+        s32 delta = fix16DivFast(a, b) - ref;
+
+        // ignore overflowed results
+        if ((ref > 32767) || (ref < -32768)) continue;
+
+        if (delta < 0) delta = -delta;
+        if (delta > ((abs(ref) >> 6) + 1)) err++;
+    }
+
+    return err;
+}
+
 static u32 displayResult(u32 op, fix32 time, u16 y, u32 dirty)
 {
     char timeStr[32];
@@ -665,3 +1020,25 @@ static u32 displayResult3D(u32 op, fix32 time, u16 y, u32 dirty)
 
     return fix32ToInt(speedKop);
 }
+
+static void displayCyclesPerOp(u32 op, fix32 time, u16 y, const char *unit)
+{
+    char cycleStr[16];
+    char str[64];
+    u32 cycles;
+
+    // CPU clock / 1024 (time is fix32 in second)
+    if (IS_PALSYSTEM) cycles = time * 7422;
+    else cycles = time * 7491;
+    cycles /= op;
+
+    uintToStr(cycles, cycleStr, 1);
+
+    strcpy(str, "~");
+    strcat(str, cycleStr);
+    strcat(str, " CPU cycles / ");
+    strcat(str, unit);
+
+    // display test string
+    VDP_drawText(str, 3, y);
+}
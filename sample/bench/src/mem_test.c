@@ -9,6 +9,8 @@ static u16 doAlloc(u16 num, u16 size, void **allocs, u16 verif);
 static u16 doRelease(u16 num, u16 size, void **allocs, u16 verif);
 static u16 doVRamAlloc(VRAMRegion *region, u16 num, u16 size, s16 *allocs, u16 verif);
 static u16 doVRamRelease(VRAMRegion *region, u16 num, u16 size, s16 *allocs, u16 verif);
+static u16 doVRamChurn(VRAMRegion *region, u16 num, s16 *allocs);
+static void displayFragmentation(VRAMRegion *region, u16 failed, u16 y);
 static u32 displayResult(u32 bytes, fix32 time, u16 y);
 static u32 displayResultAlloc(u32 nb, fix32 time, u16 y);
 
@@ -590,12 +592,44 @@ u16 executeVRamAllocTest(u16 *scores)
     globalScore += *score++;
     y++;
 
+    waitMs(5000);
+    VDP_clearPlan(PLAN_A, TRUE);
+    VRAM_releaseRegion(&region);
+
+    // sprite churn: random sprite frame sizes in a 384 tiles region (default sprite engine VRAM region)
+    y = 0;
+    VDP_drawText("Executing VRAM sprite churn tests...", 1, y++);
+    y++;
+
+    VRAM_createRegionEx(&region, 16, 384, VRAM_ALLOC_PACK);
+    VDP_drawText("20000 sprite alloc/release (pack)", 2, y++);
+    setRandomSeed(0x1234);
+    start = getTimeAsFix32(FALSE);
+    i = doVRamChurn(&region, 20000, allocs);
+    end = getTimeAsFix32(FALSE);
+    *score = displayResultAlloc(20000, end - start, y++);
+    globalScore += *score++;
+    displayFragmentation(&region, i, y++);
+    VRAM_releaseRegion(&region);
+    y++;
+
+    VRAM_createRegionEx(&region, 16, 384, VRAM_ALLOC_SEGREGATED);
+    VDP_drawText("20000 sprite alloc/release (segregated)", 2, y++);
+    setRandomSeed(0x1234);
+    start = getTimeAsFix32(FALSE);
+    i = doVRamChurn(&region, 20000, allocs);
+    end = getTimeAsFix32(FALSE);
+    *score = displayResultAlloc(20000, end - start, y++);
+    globalScore += *score++;
+    displayFragmentation(&region, i, y++);
+    VRAM_releaseRegion(&region);
+    y++;
+
 
     waitMs(5000);
     VDP_clearPlan(PLAN_A, TRUE);
 
     MEM_free(allocs);
-    VRAM_releaseRegion(&region);
 
     return globalScore;
 }
@@ -792,6 +826,48 @@ static u16 doVRamRelease(VRAMRegion *region, u16 num, u16 size, s16 *allocs, u16
     return TRUE;
 }
 
+static u16 doVRamChurn(VRAMRegion *region, u16 num, s16 *allocs)
+{
+    // typical sprite frame sizes (in tile)
+    static const u16 sizes[8] = { 1, 2, 4, 4, 6, 9, 12, 16 };
+    s16 *slot;
+    u16 failed;
+    u16 i;
+
+    // 64 sprites slots
+    for(i = 0; i < 64; i++) allocs[i] = -1;
+
+    failed = 0;
+    i = num;
+    while(i--)
+    {
+        slot = &allocs[random() & 63];
+
+        // release sprite frame
+        if (*slot != -1)
+        {
+            VRAM_free(region, *slot);
+            *slot = -1;
+        }
+        // allocate new sprite frame
+        else if ((*slot = VRAM_alloc(region, sizes[random() & 7])) == -1)
+            failed++;
+    }
+
+    // remaining allocations are kept to measure fragmentation (region is released after)
+    return failed;
+}
+
+static void displayFragmentation(VRAMRegion *region, u16 failed, u16 y)
+{
+    char str[64];
+
+    sprintf(str, "Failed=%d Free blocks=%d Frag=%d", failed, VRAM_getNumFreeBlock(region), VRAM_getFragmentation(region));
+    // sprintf(..) doesn't support %%
+    strcat(str, "%");
+    VDP_drawText(str, 3, y);
+}
+
 
 static u32 displayResult(u32 bytes, fix32 time, u16 y)
 {
@@ -21,6 +21,11 @@ static void initPos(u16 num);
 static void updatePos(u16 num);
 static void updateAnim(u16 num);
 static u16 execute(u16 time, u16 numSpr);
+static void updateCollision(u16 num);
+static u16 executeCollision(u16 time, u16 numSpr);
+static void initIdle(u16 numSpr, u16 numMoving, u16 staticIdle);
+static u16 executeIdle(u16 time, u16 numMoving);
+static u16 getUpdateScore(u32 time, u16 num);
 static void handleInput();
 
 
@@ -414,6 +419,86 @@ u16 executeSpritesTest(u16 *scores)
     *scores = executeDonut(20, TRUE);
     globalScore += *scores++;
 
+    SYS_disableInts();
+    // reset sprite engine (release all allocated resources)
+    SPR_reset();
+    SPR_clear();
+    VDP_clearPlan(PLAN_A, TRUE);
+    VDP_drawText("64 sprites 16x16 (collision)", 1, 2);
+    SYS_enableInts();
+
+    waitMs(5000);
+    SYS_disableInts();
+    VDP_clearPlan(PLAN_A, TRUE);
+    SYS_enableInts();
+
+    // enable collision engine
+    SPR_initCollision(128);
+
+    // initialize sprites
+    for(i = 0; i < 64; i++)
+    {
+        Sprite* spr;
+
+        spr = SPR_addSprite(&flare_col, 0, 0, TILE_ATTR(PAL1, FALSE, FALSE, FALSE));
+        sprites[i] = spr;
+
+        // associate object to sprite
+        spr->data = (u32) &objects[i];
+    }
+
+    // set palettes (PAL2 used for colliding sprites)
+    VDP_setPalette(PAL1, flare_col.palette->data);
+    VDP_setPalette(PAL2, palette_red);
+
+    // init position for 64 sprites
+    initPos(64);
+
+    // execute collision bench
+    *scores = executeCollision(15, 64);
+    globalScore += *scores++;
+
+    SYS_disableInts();
+    // reset sprite engine (release all allocated resources)
+    SPR_endCollision();
+    SPR_reset();
+    SPR_clear();
+    VDP_clearPlan(PLAN_A, TRUE);
+    VDP_drawText("80 sprites 16x16 (8 moving, 72 idle)", 1, 2);
+    SYS_enableInts();
+
+    waitMs(5000);
+    SYS_disableInts();
+    VDP_clearPlan(PLAN_A, TRUE);
+    SYS_enableInts();
+
+    // idle sprites stay in the update list
+    initIdle(80, 8, FALSE);
+
+    // execute SPR_update() bench
+    *scores = executeIdle(15, 8);
+    globalScore += *scores++;
+
+    SYS_disableInts();
+    // reset sprite engine (release all allocated resources)
+    SPR_reset();
+    SPR_clear();
+    VDP_clearPlan(PLAN_A, TRUE);
+    VDP_drawText("80 sprites 16x16 (8 moving, 72 static)", 1, 2);
+    SYS_enableInts();
+
+    waitMs(5000);
+    SYS_disableInts();
+    VDP_clearPlan(PLAN_A, TRUE);
+    SYS_enableInts();
+
+    // idle sprites set as static (SPR_update() cost should only depend on the 8 moving sprites)
+    initIdle(80, 8, TRUE);
+
+    // execute SPR_update() bench
+    *scores = executeIdle(15, 8);
+    globalScore += *scores++;
+
     SYS_disableInts();
     // reset sprite engine (release all allocated resources)
     SPR_reset();
@@ -886,6 +971,155 @@ static u16 execute(u16 time, u16 numSpr)
     return score;
 }
 
+static void updateCollision(u16 num)
+{
+    SpriteCollisionPair* pair;
+    Sprite** sprite;
+    u16 numPair;
+    u16 i;
+
+    // collision pairs computed by last SPR_update()
+    numPair = SPR_getCollisionPairs(&pair);
+
+    // colliding sprites use PAL2 (timer used as collision flag)
+    while(numPair--)
+    {
+        ((Object*) pair->sprite1->data)->timer = 1;
+        ((Object*) pair->sprite2->data)->timer = 1;
+        pair++;
+    }
+
+    i = num;
+    sprite = sprites;
+    while(i--)
+    {
+        Sprite* s = *sprite;
+        Object* o = (Object*) s->data;
+
+        SPR_setPalette(s, o->timer?PAL2:PAL1);
+        o->timer = 0;
+
+        sprite++;
+    }
+}
+
+static u16 executeCollision(u16 time, u16 numSpr)
+{
+    u32 startTime;
+    u32 endTime;
+    u32 updateTime;
+    u32 t;
+    u16 num;
+
+    startTime = getTime(TRUE);
+    endTime = startTime + (time << 8);
+    updateTime = 0;
+    num = 0;
+
+    do
+    {
+        updatePos(numSpr);
+
+        // only measure sprite update (and collisions computation) and collision pass
+        t = PROF_getTime();
+        SPR_update();
+        updateCollision(numSpr);
+        updateTime += PROF_getTime() - t;
+
+        VDP_showFPS(FALSE);
+        VDP_waitVSync();
+
+        num++;
+    } while(getTime(TRUE) < endTime);
+
+    return getUpdateScore(updateTime, num);
+}
+
+static void initIdle(u16 numSpr, u16 numMoving, u16 staticIdle)
+{
+    u16 i;
+
+    // initialize sprites
+    for(i = 0; i < numSpr; i++)
+    {
+        Sprite* spr;
+
+        spr = SPR_addSprite(&flare_small, 0, 0, TILE_ATTR(PAL1, FALSE, FALSE, FALSE));
+        sprites[i] = spr;
+
+        // associate object to sprite
+        spr->data = (u32) &objects[i];
+    }
+
+    // set palette
+    VDP_setPalette(PAL1, flare_small.palette->data);
+
+    // init positions
+    initPos(numSpr);
+    updatePos(numSpr);
+    SPR_update();
+
+    // stop animation of idle sprites
+    for(i = numMoving; i < numSpr; i++)
+    {
+        Sprite* spr = sprites[i];
+
+        spr->timer = 0;
+        if (staticIdle) SPR_setStatic(spr, TRUE);
+    }
+
+    // static sprites leave the update list here
+    SPR_update();
+    VDP_waitVSync();
+}
+
+static u16 executeIdle(u16 time, u16 numMoving)
+{
+    u32 startTime;
+    u32 endTime;
+    u32 updateTime;
+    u32 t;
+    u16 num;
+
+    startTime = getTime(TRUE);
+    endTime = startTime + (time << 8);
+    updateTime = 0;
+    num = 0;
+
+    do
+    {
+        // only moving sprites are modified
+        updatePos(numMoving);
+
+        // we measure SPR_update() cost only
+        t = PROF_getTime();
+        SPR_update();
+        updateTime += PROF_getTime() - t;
+
+        // don't wait for VBlank
+        DMA_flushQueue();
+
+        num++;
+    } while(getTime(TRUE) < endTime);
+
+    return getUpdateScore(updateTime, num);
+}
+
+// score = number of update per second from measured time (1/256 of scanline, see PROF_getTime())
+static u16 getUpdateScore(u32 time, u16 num)
+{
+    u32 avg;
+
+    if (num == 0) return 0;
+
+    avg = time / num;
+    if (avg == 0) return 0xFFFF;
+
+    // number of scanline per second
+    if (IS_PALSYSTEM) return min((256 * 313 * 50) / avg, 0xFFFF);
+    return min((256 * 262 * 60) / avg, 0xFFFF);
+}
+
 
 static void handleInput()
 {
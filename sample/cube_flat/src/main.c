@@ -7,6 +7,7 @@
 
 Vect3D_f16 pts_3D[MAX_POINTS];
 Vect2D_s16 pts_2D[MAX_POINTS];
+Vect3D_s16 pts_proj[MAX_POINTS];
 
 
 extern Mat3D_f16 MatInv;
@@ -75,7 +76,8 @@ int main()
         rotation.z += rotstep.z;
         transformation.rebuildMat = 1;
 
-        updatePointsPos();
+        // flat drawing does the whole 3D pipeline in drawPoints()
+        if (!flatDrawing) updatePointsPos();
 
         // ensure previous flip buffer request has been started
         BMP_waitWhileFlipRequestPending();
@@ -108,36 +110,18 @@ void drawPoints(u8 col)
 {
     if (flatDrawing)
     {
-        Vect2D_s16 v[4];
-        const Vect3D_f16 *norm;
-        const u16 *poly_ind;
+        Face3D faces[6];
+        Face3D *face;
         u16 i;
 
-        norm = cube_face_norm;
-        poly_ind = cube_poly_ind;
-
-        i = 6;
+        // transform, project, cull and light all faces in a single pass
+        i = M3D_processMesh(&transformation, &cube_mesh, pts_proj, faces, 2);
+        face = faces;
 
         while (i--)
         {
-            Vect2D_s16 *pt_dst = v;
-            fix16 dp;
-            u8 col = 2;
-
-            *pt_dst++ = pts_2D[*poly_ind++];
-            *pt_dst++ = pts_2D[*poly_ind++];
-            *pt_dst++ = pts_2D[*poly_ind++];
-            *pt_dst = pts_2D[*poly_ind++];
-
-            dp = fix16Mul(transformation.lightInv.x, norm->x) +
-                 fix16Mul(transformation.lightInv.y, norm->y) +
-                 fix16Mul(transformation.lightInv.z, norm->z);
-            norm++;
-
-            if (dp > 0) col += (dp >> (FIX16_FRAC_BITS - 2));
-
-            if (!BMP_isPolygonCulled(v, 4))
-                BMP_drawPolygon(v, 4, col);
+            BMP_drawPolygon(face->pts, 4, face->col);
+            face++;
         }
     }
     else
@@ -58,3 +58,11 @@ const Vect3D_f16 cube_face_norm[6] =
     {FIX16(1), FIX16(0), FIX16(0)},
     {FIX16(-1), FIX16(0), FIX16(0)}
 };
+
+const Mesh3D cube_mesh =
+{
+    8, 6,
+    cube_coord,
+    cube_face_norm,
+    cube_poly_ind
+};
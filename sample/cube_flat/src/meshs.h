@@ -6,6 +6,7 @@ extern const Vect3D_f16 cube_coord[8];
 extern const u16 cube_poly_ind[6 * 4];
 extern const u16 cube_line_ind[12 * 2];
 extern const Vect3D_f16 cube_face_norm[6];
+extern const Mesh3D cube_mesh;
 
 
 #endif // _MESHS_H_
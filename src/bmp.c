@@ -13,14 +13,19 @@
 #include "vdp_bg.h"
 
 #include "dma.h"
+#include "z80_ctrl.h"
+#include "xgm.h"
 
 #include "memory.h"
 #include "tools.h"
 #include "string.h"
+#include "kdebug.h"
+#include "prof.h"
 
 
 #define BMP_FLAG_DOUBLEBUFFER   (1 << 0)
 #define BMP_FLAG_COPYBUFFER     (1 << 1)
+#define BMP_FLAG_DMATRANSFER    (1 << 2)
 
 #define BMP_STAT_FLIPPING       (1 << 0)
 #define BMP_STAT_BLITTING       (1 << 1)
@@ -28,6 +33,7 @@
 
 #define HAS_DOUBLEBUFFER        (flag & BMP_FLAG_DOUBLEBUFFER)
 #define HAS_BUFFERCOPY          (flag & BMP_FLAG_COPYBUFFER)
+#define HAS_DMATRANSFER         (flag & BMP_FLAG_DMATRANSFER)
 
 #define READ_IS_FB0             (bmp_buffer_read == bmp_buffer_0)
 #define READ_IS_FB1             (bmp_buffer_read == bmp_buffer_1)
@@ -46,11 +52,26 @@
 #define NTSC_TILES_BW           7
 #define PAL_TILES_BW            10
 
+// number of scanline per frame
+#define NTSC_FRAME_LINES        262
+#define PAL_FRAME_LINES         313
+// DMA bandwidth (in byte per scanline) when display is disabled
+#define H40_DMA_BW              204
+#define H32_DMA_BW              166
+// blank lines we keep free for DMA queue flush and interrupt latency
+#define DMA_SAFE_LINES          16
+// size of a tile row of bitmap (in byte)
+#define BMP_TILEROW_SIZE        (BMP_CELLWIDTH * 32)
+
+// span buffer: average number of point per submitted polygon (points pool sizing)
+#define SB_AVG_PT_PER_POLY      4
+
 
 // we don't want to share them
 extern vu32 VIntProcess;
 extern vu32 HIntProcess;
 extern u16 text_basetile;
+extern s16 currentDriver;
 
 u8 *bmp_buffer_read;
 u8 *bmp_buffer_write;
@@ -61,6 +82,27 @@ static u8 *bmp_buffer_1;
 VDPPlan bmp_plan;
 u16 *bmp_plan_adr;
 
+// span buffer polygon
+typedef struct
+{
+    u16 pt;
+    u16 num;
+    s16 z;
+    u16 col;
+} SBPolygon;
+
+// span buffer data
+static u8 *sb_spans;
+static u8 *sb_numspans;
+static SBPolygon *sb_polys;
+static u16 *sb_order;
+static Vect2D_s16 *sb_pts;
+static u16 sb_maxpoly;
+static u16 sb_numpoly;
+static u16 sb_numpt;
+static s16 sb_left[BMP_HEIGHT];
+static s16 sb_right[BMP_HEIGHT];
+
 // internals
 static u16 flag;
 static u16 pal;
@@ -78,11 +120,26 @@ static void flipBuffer();
 static void initTilemap(u16 num);
 static void clearVRAMBuffer(u16 num);
 static u16 doBlit();
+static u16 getDMABlitRows(u16 remain);
+static void convertBitmapBuffer(const u8 *src, u8 *dst);
+static u16 drawPolygonSB(const Vect2D_s16 *pts, u16 num, u8 col);
+static u16 drawSpanSB(u16 y, u16 xl, u16 xr, u8 col);
+static void fillSpan(u8 *line, u16 xl, u16 xr, u8 col);
 static void drawLine_old(u16 x1, u16 y1, s16 dx, s16 dy, s16 step_x, s16 step_y, u8 col);
 
 
-void BMP_init(u16 double_buffer, VDPPlan plan, u16 palette, u16 priority)
+u16 BMP_init(u16 double_buffer, VDPPlan plan, u16 palette, u16 priority)
 {
+    // extended blank uses its own H-Int processing
+    if (HIntProcess & PROCESS_EXTVBLANK_TASK)
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("BMP_init failed: can't be used with extended blank (see VDP_setExtendedVBlank(..)) !");
+#endif
+
+        return FALSE;
+    }
+
     flag = (double_buffer) ? BMP_FLAG_DOUBLEBUFFER : 0;
     bmp_plan = plan;
     pal = palette & 3;
@@ -108,6 +165,8 @@ void BMP_init(u16 double_buffer, VDPPlan plan, u16 palette, u16 priority)
     bmp_buffer_1 = NULL;
 
     BMP_reset();
+
+    return TRUE;
 }
 
 void BMP_end()
@@ -130,6 +189,9 @@ void BMP_end()
     // reset back vertical scroll to 0
     VDP_setVerticalScroll(bmp_plan, 0);
 
+    // release span buffer
+    BMP_endSpanBuffer();
+
     // release memory
     if (bmp_buffer_0)
     {
@@ -224,6 +286,18 @@ void BMP_setBufferCopy(u16 value)
     else flag &= ~BMP_FLAG_COPYBUFFER;
 }
 
+void BMP_setDMATransfer(u16 value)
+{
+    // we don't want to change transfer mode while blitting
+    BMP_waitWhileFlipRequestPending();
+    BMP_waitFlipComplete();
+
+    // read buffer stays in tile order when we leave DMA transfer mode: it becomes the write buffer on next flip
+    // where it's either overwritten by buffer copy or not preserved anyway (no need to restore it in linear order)
+    if (value) flag |= BMP_FLAG_DMATRANSFER;
+    else flag &= ~BMP_FLAG_DMATRANSFER;
+}
+
 
 u16 BMP_hasFlipRequestPending()
 {
@@ -255,6 +329,10 @@ u16 BMP_flip(u16 async)
     // wait until pending flip is processed
     BMP_waitWhileFlipRequestPending();
 
+    // DMA transfer mode: read buffer can't be converted while it's being sent, we wait for the transfer to complete
+    // so conversion always happens here and never from the blank process (interrupt context)
+    if (HAS_DMATRANSFER) BMP_waitFlipComplete();
+
     // currently flipping ?
     if (state & BMP_STAT_FLIPPING)
     {
@@ -1065,6 +1143,115 @@ void BMP_drawLine_old(Line *l)
 //}
 
 
+u16 BMP_initSpanBuffer(u16 maxPolygon)
+{
+    // release previous allocation
+    BMP_endSpanBuffer();
+
+    sb_spans = MEM_alloc(BMP_HEIGHT * BMP_SB_MAXSPAN * 2 * sizeof(u8));
+    sb_numspans = MEM_alloc(BMP_HEIGHT * sizeof(u8));
+    sb_polys = MEM_alloc(maxPolygon * sizeof(SBPolygon));
+    sb_order = MEM_alloc(maxPolygon * sizeof(u16));
+    sb_pts = MEM_alloc(maxPolygon * SB_AVG_PT_PER_POLY * sizeof(Vect2D_s16));
+
+    // not enough memory
+    if (!sb_spans || !sb_numspans || !sb_polys || !sb_order || !sb_pts)
+    {
+        BMP_endSpanBuffer();
+        return FALSE;
+    }
+
+    sb_maxpoly = maxPolygon;
+    sb_numpoly = 0;
+    sb_numpt = 0;
+    memset(sb_numspans, 0, BMP_HEIGHT);
+
+    return TRUE;
+}
+
+void BMP_endSpanBuffer()
+{
+    if (sb_spans) MEM_free(sb_spans);
+    if (sb_numspans) MEM_free(sb_numspans);
+    if (sb_polys) MEM_free(sb_polys);
+    if (sb_order) MEM_free(sb_order);
+    if (sb_pts) MEM_free(sb_pts);
+
+    sb_spans = NULL;
+    sb_numspans = NULL;
+    sb_polys = NULL;
+    sb_order = NULL;
+    sb_pts = NULL;
+    sb_maxpoly = 0;
+    sb_numpoly = 0;
+    sb_numpt = 0;
+}
+
+u16 BMP_submitPolygon(const Vect2D_s16 *pts, u16 num, u8 col, s16 z)
+{
+    SBPolygon *poly;
+    u16 ind;
+
+    // polygon list or points pool is full
+    if ((sb_numpoly >= sb_maxpoly) || ((sb_numpt + num) > (sb_maxpoly * SB_AVG_PT_PER_POLY)))
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("BMP_submitPolygon(..) failed: span buffer is full !");
+#endif
+        return FALSE;
+    }
+
+    poly = &sb_polys[sb_numpoly];
+    poly->pt = sb_numpt;
+    poly->num = num;
+    poly->z = z;
+    poly->col = col;
+
+    // we copy points so caller can reuse its buffer
+    memcpy(&sb_pts[sb_numpt], pts, num * sizeof(Vect2D_s16));
+    sb_numpt += num;
+
+    // insertion sort on z (stable so equal z keep submission order)
+    ind = sb_numpoly;
+    while(ind && (sb_polys[sb_order[ind - 1]].z > z))
+    {
+        sb_order[ind] = sb_order[ind - 1];
+        ind--;
+    }
+    sb_order[ind] = sb_numpoly;
+
+    sb_numpoly++;
+
+    return TRUE;
+}
+
+u16 BMP_flushPolygons()
+{
+    const u16 *order;
+    u16 drawn;
+    u16 i;
+
+    drawn = 0;
+    order = sb_order;
+    i = sb_numpoly;
+
+    // draw from front to back
+    while(i--)
+    {
+        const SBPolygon *poly = &sb_polys[*order++];
+
+        if (drawPolygonSB(&sb_pts[poly->pt], poly->num, poly->col)) drawn++;
+    }
+
+    // reset polygon list and coverage
+    sb_numpoly = 0;
+    sb_numpt = 0;
+    memset(sb_numspans, 0, BMP_HEIGHT);
+
+    return drawn;
+}
+
+
 void BMP_drawBitmapData(const u8 *image, u16 x, u16 y, u16 w, u16 h, u32 pitch)
 {
     // pixel out screen ?
@@ -1098,6 +1285,16 @@ u16 BMP_drawBitmap(const Bitmap *bitmap, u16 x, u16 y, u16 loadpal)
 {
     u16 w, h;
 
+    // tiled layout not supported here
+    if (bitmap->compression & BITMAP_TILED)
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("BMP_drawBitmap failed: tiled Bitmap can only be drawn with VDP_drawBitmap(..)");
+#endif
+
+        return FALSE;
+    }
+
     // get the image width
     w = bitmap->w;
     // get the image height
@@ -1130,6 +1327,16 @@ u16 BMP_drawBitmapScaled(const Bitmap *bitmap, u16 x, u16 y, u16 w, u16 h, u16 l
 {
     u16 bmp_wb, bmp_h;
 
+    // tiled layout not supported here
+    if (bitmap->compression & BITMAP_TILED)
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("BMP_drawBitmapScaled failed: tiled Bitmap can only be drawn with VDP_drawBitmap(..)");
+#endif
+
+        return FALSE;
+    }
+
     // get the image width in byte
     bmp_wb = bitmap->w >> 1;
     // get the image height
@@ -1345,6 +1552,22 @@ static void clearVRAMBuffer(u16 num)
 
 static void flipBuffer()
 {
+    // DMA transfer mode ?
+    if (HAS_DMATRANSFER)
+    {
+        u8 *tmp;
+
+        // convert write buffer to tile ordered read buffer (so write buffer is always preserved)
+        convertBitmapBuffer(bmp_buffer_write, bmp_buffer_read);
+
+        // we swap buffer identities (not read / write pointers) so VRAM double buffer still alternate
+        tmp = bmp_buffer_0;
+        bmp_buffer_0 = bmp_buffer_1;
+        bmp_buffer_1 = tmp;
+
+        return;
+    }
+
     if (READ_IS_FB0)
     {
         bmp_buffer_read = bmp_buffer_1;
@@ -1386,7 +1609,7 @@ static void doFlip()
         // get bitmap state
         u16 s = state;
 
-        // we had a pending flip request ?
+        // we had a pending flip request ? (never in DMA transfer mode, see BMP_flip(..))
         if (s & BMP_STAT_FLIPWAITING)
         {
             // flip buffers
@@ -1426,12 +1649,15 @@ static void doFlip()
 static u16 doBlit()
 {
     static u16 pos_i;
+    static u16 blitOp;
     vu32 *plctrl;
     vu32 *pldata;
     u32 *src;
     u32 addr_tile;
     u16 i;
 
+    PROF_begin("BMP blit");
+
     VDP_setAutoInc(2);
 
     src = (u32 *) bmp_buffer_read;
@@ -1451,50 +1677,90 @@ static u16 doBlit()
         addr_tile += pos_i * BMP_CELLWIDTH * 32;
         // adjust src pointer
         src += pos_i * (BMP_YPIXPERTILE * (BMP_PITCH / 4));
-
-        // set destination address for tile
-        *plctrl = GFX_WRITE_VRAM_ADDR(addr_tile);
     }
     else
     {
         // start blit
         state |= BMP_STAT_BLITTING;
         pos_i = 0;
-
-        // set destination address for tile
-        *plctrl = GFX_WRITE_VRAM_ADDR(addr_tile);
     }
 
     const u16 remain = BMP_CELLHEIGHT - pos_i;
 
-    if (IS_PALSYSTEM)
+    // DMA transfer mode ? read buffer is already in tile order
+    if (HAS_DMATRANSFER)
     {
-        if (remain < PAL_TILES_BW) i = remain;
-        else i = PAL_TILES_BW;
+        i = getDMABlitRows(remain);
+
+        // queue can't be modified while main code is adding operations --> try again next frame
+        if (i && !DMA_isQueueLocked())
+        {
+            // queued operations are split on DMA bank limit
+            if (DMA_queueDma(DMA_VRAM, (u32) src, addr_tile, i * (BMP_TILEROW_SIZE / 2), 2))
+            {
+                blitOp = DMA_getQueueOpId();
+                // save position
+                pos_i += i;
+            }
+        }
+
+        // display is disabled from here to the end of top border --> flush DMA queue now rather than at VBlank
+        // (process cleared first so VInt doesn't flush it at same time)
+        VIntProcess &= ~PROCESS_DMA_TASK;
+
+        // DMA protection for XGM driver
+        if (currentDriver == Z80_DRIVER_XGM)
+        {
+            XGM_set68KBUSProtection(TRUE);
+            DMA_flushQueue();
+            XGM_set68KBUSProtection(FALSE);
+        }
+        else
+            DMA_flushQueue();
+
+        // last chunk can be postponed by DMA queue transfer capacity
+        if (!DMA_isOpDone(blitOp))
+        {
+            PROF_end();
+            return 0;
+        }
     }
     else
     {
-        if (remain < NTSC_TILES_BW) i = remain;
-        else i = NTSC_TILES_BW;
-    }
+        // set destination address for tile
+        *plctrl = GFX_WRITE_VRAM_ADDR(addr_tile);
 
-    // save position
-    pos_i += i;
+        if (IS_PALSYSTEM)
+        {
+            if (remain < PAL_TILES_BW) i = remain;
+            else i = PAL_TILES_BW;
+        }
+        else
+        {
+            if (remain < NTSC_TILES_BW) i = remain;
+            else i = NTSC_TILES_BW;
+        }
 
-    /* point to vdp data port */
-    pldata = (u32 *) GFX_DATA_PORT;
+        // save position
+        pos_i += i;
 
-    while(i--)
-    {
-        // send it to VRAM
-        TRANSFER8(0)
-        TRANSFER8(1)
-        TRANSFER8(2)
-        TRANSFER8(3)
+        /* point to vdp data port */
+        pldata = (u32 *) GFX_DATA_PORT;
 
-        src += (8 * BMP_PITCH) / 4;
+        while(i--)
+        {
+            // send it to VRAM
+            TRANSFER8(0)
+            TRANSFER8(1)
+            TRANSFER8(2)
+            TRANSFER8(3)
+
+            src += (8 * BMP_PITCH) / 4;
+        }
     }
 
+    PROF_end();
+
     // blit not yet done
     if (pos_i < BMP_CELLHEIGHT) return 0;
 
@@ -1504,6 +1770,335 @@ static u16 doBlit()
     return 1;
 }
 
+static u16 drawPolygonSB(const Vect2D_s16 *pts, u16 num, u8 col)
+{
+    const Vect2D_s16 *p0;
+    const Vect2D_s16 *p1;
+    s16 ymin, ymax;
+    s16 xmin, xmax;
+    s16 y;
+    u16 i;
+    u16 res;
+
+    // nothing to draw
+    if (num == 0) return 0;
+
+    // get polygon bounds
+    p0 = pts;
+    ymin = ymax = p0->y;
+    xmin = xmax = p0->x;
+    i = num - 1;
+    while(i--)
+    {
+        p0++;
+        if (p0->y < ymin) ymin = p0->y;
+        else if (p0->y > ymax) ymax = p0->y;
+        if (p0->x < xmin) xmin = p0->x;
+        else if (p0->x > xmax) xmax = p0->x;
+    }
+
+    // outside screen
+    if ((ymax < 0) || (ymin >= BMP_HEIGHT) || (xmax < 0) || (xmin >= BMP_WIDTH)) return 0;
+
+    // clip
+    if (ymin < 0) ymin = 0;
+    if (ymax >= BMP_HEIGHT) ymax = BMP_HEIGHT - 1;
+
+    // reset edges
+    for(y = ymin; y <= ymax; y++)
+    {
+        sb_left[y] = 0x7FFF;
+        sb_right[y] = -0x8000;
+    }
+
+    // compute left and right edges (convex polygon)
+    p0 = &pts[num - 1];
+    p1 = pts;
+    i = num;
+    while(i--)
+    {
+        const Vect2D_s16 *top;
+        const Vect2D_s16 *bottom;
+        s16 yt, yb;
+        s32 x, step;
+
+        if (p0->y <= p1->y)
+        {
+            top = p0;
+            bottom = p1;
+        }
+        else
+        {
+            top = p1;
+            bottom = p0;
+        }
+
+        yt = top->y;
+        yb = bottom->y;
+
+        // edge is visible ?
+        if ((yb >= ymin) && (yt <= ymax))
+        {
+            // horizontal edge
+            if (yt == yb)
+            {
+                const s16 xl = min(top->x, bottom->x);
+                const s16 xr = max(top->x, bottom->x);
+
+                if (xl < sb_left[yt]) sb_left[yt] = xl;
+                if (xr > sb_right[yt]) sb_right[yt] = xr;
+            }
+            else
+            {
+                const s32 dx = bottom->x - top->x;
+                const s32 dy = yb - yt;
+
+                x = ((s32) top->x << 16) + 0x8000;
+                // divide before shifting so large deltas can't overflow (remainder is lower than dy)
+                step = ((dx / dy) * 0x10000) + (((dx % dy) * 0x10000) / dy);
+
+                // clip top
+                if (yt < ymin)
+                {
+                    x += step * (ymin - yt);
+                    yt = ymin;
+                }
+                // clip bottom
+                if (yb > ymax) yb = ymax;
+
+                for(y = yt; y <= yb; y++)
+                {
+                    const s16 xi = x >> 16;
+
+                    if (xi < sb_left[y]) sb_left[y] = xi;
+                    if (xi > sb_right[y]) sb_right[y] = xi;
+
+                    x += step;
+                }
+            }
+        }
+
+        // next edge
+        p0 = p1++;
+    }
+
+    res = 0;
+    for(y = ymin; y <= ymax; y++)
+    {
+        s16 xl = sb_left[y];
+        s16 xr = sb_right[y];
+
+        if (xl < 0) xl = 0;
+        if (xr >= BMP_WIDTH) xr = BMP_WIDTH - 1;
+
+        if (xl <= xr) res |= drawSpanSB(y, xl, xr, col);
+    }
+
+    return res;
+}
+
+static u16 drawSpanSB(u16 y, u16 xl, u16 xr, u8 col)
+{
+    u8 *spans;
+    u8 *line;
+    u8 *s;
+    u16 n, cur, res;
+    u16 first, last;
+    u16 l, r;
+    u16 i;
+    u8 c;
+
+    spans = &sb_spans[y * (BMP_SB_MAXSPAN * 2)];
+    n = sb_numspans[y];
+
+    // line fully covered ?
+    if ((n == 1) && (spans[0] == 0) && (spans[1] == (BMP_WIDTH - 1))) return 0;
+
+    // same dithering as BMP_drawPolygon(..)
+    if (y & 1) c = col;
+    else c = (col << 4) | (col >> 4);
+
+    line = bmp_buffer_write + (y * BMP_PITCH);
+    res = 0;
+    cur = xl;
+    s = spans;
+    first = n;
+    last = n;
+
+    // draw visible parts (spans are sorted and don't overlap)
+    for(i = 0; i < n; i++, s += 2)
+    {
+        l = s[0];
+        r = s[1];
+
+        // first span touching or after the new one
+        if ((first == n) && ((r + 1) >= xl)) first = i;
+        // first span after the new one (not touching)
+        if (l > (xr + 1))
+        {
+            last = i;
+            break;
+        }
+
+        if ((r >= cur) && (l <= xr))
+        {
+            if (l > cur)
+            {
+                fillSpan(line, cur, l - 1, c);
+                res = 1;
+            }
+            cur = r + 1;
+        }
+    }
+
+    if (cur <= xr)
+    {
+        fillSpan(line, cur, xr, c);
+        res = 1;
+    }
+
+    // nothing visible --> coverage unchanged
+    if (!res) return 0;
+
+    if (first > last) first = last;
+    // no touching span and no more room --> merge with the closest span (pixels in between are considered as covered)
+    if ((first == last) && (n >= BMP_SB_MAXSPAN))
+    {
+        if ((last == n) || ((first > 0) && ((xl - spans[((first - 1) * 2) + 1]) <= (spans[last * 2] - xr)))) first--;
+        else last++;
+    }
+    // merge new span with touching / overlapping spans [first..last[
+    if (first < last)
+    {
+        if (spans[(first * 2) + 0] < xl) xl = spans[(first * 2) + 0];
+        if (spans[((last - 1) * 2) + 1] > xr) xr = spans[((last - 1) * 2) + 1];
+    }
+
+    // number of span after merge
+    i = (n - (last - first)) + 1;
+
+    // move tail spans (ranges overlap so we can't use memcpy)
+    if (i != n)
+    {
+        u8 *src = &spans[last * 2];
+        u8 *dst = &spans[(first + 1) * 2];
+        u16 j = (n - last) * 2;
+
+        if (i < n)
+        {
+            while(j--) *dst++ = *src++;
+        }
+        else
+        {
+            // insertion, move backward
+            src += j;
+            dst += j;
+
+            while(j--) *--dst = *--src;
+        }
+    }
+
+    spans[(first * 2) + 0] = xl;
+    spans[(first * 2) + 1] = xr;
+    sb_numspans[y] = i;
+
+    return res;
+}
+
+static void fillSpan(u8 *line, u16 xl, u16 xr, u8 col)
+{
+    u8 *dst = line + (xl >> 1);
+    u16 len;
+
+    // odd start pixel --> low nibble only
+    if (xl & 1)
+    {
+        *dst = (*dst & 0xF0) | (col & 0x0F);
+        dst++;
+        xl++;
+    }
+
+    if (xl > xr) return;
+
+    // full bytes
+    len = (xr - xl + 1) >> 1;
+    if (len)
+    {
+        memset(dst, col, len);
+        dst += len;
+    }
+
+    // even end pixel --> high nibble only
+    if (!(xr & 1)) *dst = (*dst & 0x0F) | (col & 0xF0);
+}
+
+static u16 getDMABlitRows(u16 remain)
+{
+    s32 budget;
+    u16 lines;
+    u16 res;
+
+    // available blank lines (extended blank + vblank) minus safety margin
+    if (IS_PALSYSTEM) lines = PAL_FRAME_LINES - BMP_HEIGHT;
+    else lines = NTSC_FRAME_LINES - BMP_HEIGHT;
+    lines -= DMA_SAFE_LINES;
+
+    if (screenWidth == 320) budget = lines * H40_DMA_BW;
+    else budget = lines * H32_DMA_BW;
+
+    // keep bandwidth for DMA queue operations not yet sent (including previous blit chunks)
+    budget -= DMA_getQueueTransferSize();
+
+    if (budget <= 0) return 0;
+
+    res = budget / BMP_TILEROW_SIZE;
+    if (res > remain) return remain;
+
+    return res;
+}
+
+#define CONVERT(x)                                      \
+    *dst++ = src[((BMP_PITCH * 0) / 4) + (x)];  \
+    *dst++ = src[((BMP_PITCH * 1) / 4) + (x)];  \
+    *dst++ = src[((BMP_PITCH * 2) / 4) + (x)];  \
+    *dst++ = src[((BMP_PITCH * 3) / 4) + (x)];  \
+    *dst++ = src[((BMP_PITCH * 4) / 4) + (x)];  \
+    *dst++ = src[((BMP_PITCH * 5) / 4) + (x)];  \
+    *dst++ = src[((BMP_PITCH * 6) / 4) + (x)];  \
+    *dst++ = src[((BMP_PITCH * 7) / 4) + (x)];
+
+#define CONVERT8(x)                 \
+    CONVERT((8 * x) + 0)    \
+    CONVERT((8 * x) + 1)    \
+    CONVERT((8 * x) + 2)    \
+    CONVERT((8 * x) + 3)    \
+    CONVERT((8 * x) + 4)    \
+    CONVERT((8 * x) + 5)    \
+    CONVERT((8 * x) + 6)    \
+    CONVERT((8 * x) + 7)
+
+// convert linear bitmap buffer to tile ordered buffer (same order as CPU blit)
+static void convertBitmapBuffer(const u8 *src_buf, u8 *dst_buf)
+{
+    const u32 *src;
+    u32 *dst;
+    u16 i;
+
+    src = (const u32 *) src_buf;
+    dst = (u32 *) dst_buf;
+    i = BMP_CELLHEIGHT;
+
+    while(i--)
+    {
+        CONVERT8(0)
+        CONVERT8(1)
+        CONVERT8(2)
+        CONVERT8(3)
+
+        src += (8 * BMP_PITCH) / 4;
+    }
+}
+
 static void drawLine_old(u16 x1, u16 y1, s16 dx, s16 dy, s16 step_x, s16 step_y, u8 col)
 {
     u8 *dst = bmp_buffer_write + (y1 * BMP_PITCH);
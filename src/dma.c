@@ -8,6 +8,7 @@
 
 #include "kdebug.h"
 #include "tools.h"
+#include "prof.h"
 
 
 //#define DMA_DEBUG
@@ -17,23 +18,51 @@
 #define DMA_AUTOFLUSH               0x1
 #define DMA_OVERCAPACITY_IGNORE     0x2
 
+// DMA mode bits of register $17 (stored in regAddrHAddrL)
+#define DMA_MODE_MASK               0x00C00000
+#define DMA_MODE_FILL               0x00800000
+#define DMA_MODE_COPY               0x00C00000
+
 
 // we don't want to share it
 extern vu32 VIntProcess;
 
-// DMA queue
+// DMA queue (ring buffer, operations are added by DMA_queueXXX() methods and sent by DMA_flushQueue() once committed)
 DMAOpInfo *dmaQueues = NULL;
+// transfer size of each operation
+static u32 *queueSizes;
+// queue lock counter (operations are committed when it goes back to 0)
+static vu16 queueLock;
 
 // DMA queue settings
 static u16 queueSize;
 static s16 maxTransferPerFrame;
 static u16 flags;
 
-// current queue index (0 = empty / queueSize = full)
+// producer side (DMA_queueXXX() methods only)
+// write index in ring buffer
 static u16 queueIndex;
-static u16 queueIndexLimit;
+// number of operation added, used as operation identifier
+static u16 queueOpCount;
+// total size of added operations
 static u32 queueTransferSize;
-static u32 queueTransferSizeLimit;
+// identifier of last added VRAM fill / copy operation
+static u16 fillCopyOpId;
+// published on last unlock (single write), DMA_flushQueue() can send operations up to this identifier
+static vu16 commitOpCount;
+
+// consumer side (DMA_flushQueue() only)
+// read index in ring buffer
+static u16 flushIndex;
+// number of operation sent (or dropped)
+static vu16 sentOpCount;
+// total size of sent (or dropped) operations
+static vu32 sentTransferSize;
+
+
+// forward
+static void commitQueueEntry(u32 size);
+static void commitQueue();
 
 
 void DMA_init(u16 size, u16 capacity)
@@ -48,8 +77,11 @@ void DMA_init(u16 size, u16 capacity)
 
     // already allocated ?
     if (dmaQueues) MEM_free(dmaQueues);
-    // allocate DMA queue
-    dmaQueues = MEM_alloc(queueSize * sizeof(DMAOpInfo));
+    // allocate DMA queue (operations followed by operations size)
+    dmaQueues = MEM_alloc(queueSize * (sizeof(DMAOpInfo) + sizeof(u32)));
+    queueSizes = (u32*) (dmaQueues + queueSize);
+    queueLock = 0;
+    queueOpCount = 0;
 
     // clear queue
     DMA_clearQueue();
@@ -65,8 +97,8 @@ void DMA_setAutoFlush(u16 value)
     if (value)
     {
         flags |= DMA_AUTOFLUSH;
-        // auto flush enabled and transfer size > 0 --> set process on VBlank
-        if (queueTransferSize > 0)
+        // auto flush enabled and committed operations pending --> set process on VBlank
+        if (commitOpCount != sentOpCount)
              VIntProcess |= PROCESS_DMA_TASK;
     }
     else flags &= ~DMA_AUTOFLUSH;
@@ -95,28 +127,94 @@ void DMA_setMaxTransferSize(s16 value)
 
 void DMA_clearQueue()
 {
+    // consumer side can be accessed from interrupt
+    const u16 level = SYS_getAndSetInterruptMaskLevel(7);
+
     queueIndex = 0;
-    queueIndexLimit = 0;
     queueTransferSize = 0;
-    queueTransferSizeLimit = 0;
+    flushIndex = 0;
+    sentTransferSize = 0;
+    // dropped operations are considered as done
+    commitOpCount = queueOpCount;
+    sentOpCount = queueOpCount;
+    fillCopyOpId = queueOpCount;
+
+    SYS_setInterruptMaskLevel(level);
+}
+
+void DMA_lockQueue()
+{
+    queueLock++;
+}
+
+void DMA_unlockQueue()
+{
+    // last unlock --> operations can be sent now
+    if (queueLock && (--queueLock == 0)) commitQueue();
+}
+
+u16 DMA_isQueueLocked()
+{
+    return queueLock?TRUE:FALSE;
+}
+
+u16 DMA_getQueueOpId()
+{
+    return queueOpCount;
+}
+
+u16 DMA_isOpDone(u16 id)
+{
+    // wrap safe comparison
+    return ((s16) (sentOpCount - id) >= 0)?TRUE:FALSE;
 }
 
 void DMA_flushQueue()
 {
     vu32 *pl;
     u32 *info;
+    u32 size;
+    u16 pending;
+    u16 num;
+    u16 index;
+    u16 remain;
+    u16 busy;
     u16 i;
 #if (HALT_Z80_ON_DMA == 1)
     u16 z80state;
 #endif
 
-    // transfer size limit ?
-    if (queueIndexLimit) i = queueIndexLimit;
-    else i = queueIndex;
-    info = (u32*) dmaQueues;
+    // committed operations not yet sent (operations added while the queue is locked are not committed yet)
+    pending = commitOpCount - sentOpCount;
+    if (pending == 0) return;
+
+    PROF_begin("DMA flush");
+
+    index = flushIndex;
+    size = 0;
+    num = 0;
+    // get number of operation we can send in this frame
+    while(num < pending)
+    {
+        const u32 opSize = queueSizes[index];
+
+        // transfer size limit reached ? (first operation is always sent)
+        if (num && maxTransferPerFrame && ((size + opSize) > (u32) maxTransferPerFrame)) break;
+
+        size += opSize;
+        num++;
+        if (++index == queueSize) index = 0;
+    }
+
+    info = (u32*) &dmaQueues[flushIndex];
+    // operations can wrap around the end of the ring buffer
+    i = queueSize - flushIndex;
+    if (i > num) i = num;
+    remain = num - i;
+    busy = FALSE;
 
 #ifdef DMA_DEBUG
-    KLog_U3("DMA_flushQueue: queueIndexLimit=", queueIndexLimit, " queueIndex=", queueIndex, " i=", i);
+    KLog_U3("DMA_flushQueue: flushIndex=", flushIndex, " pending=", pending, " num=", num);
 #endif
 
     // wait for DMA FILL / COPY operation to complete
@@ -124,79 +222,115 @@ void DMA_flushQueue()
 
 #if (HALT_Z80_ON_DMA == 1)
     z80state = Z80_isBusTaken();
-    if (!z80state) Z80_requestBus(FALSE);
+    if (!z80state) Z80_requestBusEx(FALSE, Z80_BUS_DMA);
 #endif
 
     pl = (vu32*) GFX_CTRL_PORT;
-
-    while(i--)
+
+    while(TRUE)
     {
-        // set DMA parameters and trigger it
-        *pl = *info++;  // regStepLenL = (0x8F00 | step) | ((0x9300 | (len & 0xFF)) << 16)
-        *pl = *info++;  // regLenHAddrL = (0x9400 | ((len >> 8) & 0xFF)) | ((0x9500 | ((addr >> 1) & 0xFF)) << 16)
-        *pl = *info++;  // regAddrMAddrH = (0x9600 | ((addr >> 9) & 0xFF)) | ((0x9700 | ((addr >> 17) & 0x7F)) << 16)
-        *pl = *info++;  // regCtrlWrite =  GFX_DMA_xxx_ADDR(to)
+        // VRAM fill / copy operations are running in background so we may need to wait for them
+        if ((s16) (fillCopyOpId - sentOpCount) > 0)
+        {
+            vu16 *pw = (vu16*) GFX_CTRL_PORT;
+
+            while(i--)
+            {
+                const u32 addrH = info[2];
+
+                // previous fill / copy has to complete before we can modify DMA registers
+                if (busy) VDP_waitDMACompletion();
+
+                if ((addrH & DMA_MODE_MASK) == DMA_MODE_FILL)
+                {
+                    *pl = info[0];              // length
+                    *pw = info[1];              // step (fill value is in high word)
+                    *pw = addrH >> 16;          // fill mode
+                    *pl = info[3];              // destination
+                    // write fill value to start the operation
+                    *((vu16*) GFX_DATA_PORT) = info[1] >> 16;
+                    busy = TRUE;
+                }
+                else
+                {
+                    *pl = info[0];
+                    *pl = info[1];
+                    *pl = addrH;
+                    *pl = info[3];
+                    // 68000 to VDP transfer is done when CPU resumes, only copy runs in background
+                    busy = ((addrH & DMA_MODE_MASK) == DMA_MODE_COPY);
+                }
+
+                info += 4;
+            }
+        }
+        else
+        {
+            while(i--)
+            {
+                // set DMA parameters and trigger it
+                *pl = *info++;  // regStepLenL = (0x8F00 | step) | ((0x9300 | (len & 0xFF)) << 16)
+                *pl = *info++;  // regLenHAddrL = (0x9400 | ((len >> 8) & 0xFF)) | ((0x9500 | ((addr >> 1) & 0xFF)) << 16)
+                *pl = *info++;  // regAddrMAddrH = (0x9600 | ((addr >> 9) & 0xFF)) | ((0x9700 | ((addr >> 17) & 0x7F)) << 16)
+                *pl = *info++;  // regCtrlWrite =  GFX_DMA_xxx_ADDR(to)
+            }
+        }
+
+        if (remain == 0) break;
+
+        // continue from start of ring buffer
+        info = (u32*) dmaQueues;
+        i = remain;
+        remain = 0;
     }
 
+    // auto increment register can't be modified while fill / copy is running
+    if (busy) VDP_waitDMACompletion();
+
 #if (HALT_Z80_ON_DMA == 1)
     if (!z80state) Z80_releaseBus();
 #endif
 
-    // transfer size limit ?
-    if (queueIndexLimit)
+    pending -= num;
+
+    // transfer size limit reached and we just ignore remaining operations ?
+    if (pending && (flags & DMA_OVERCAPACITY_IGNORE))
     {
-        // just ignore
-        if (flags & DMA_OVERCAPACITY_IGNORE)
-        {
 #ifdef DMA_DEBUG
-            KLog_U1("  Ignore remaining transfer starting at index: ", queueIndexLimit);
+        KLog_U1("  Ignore remaining transfer starting at index: ", index);
 #endif
 
-            queueIndex = 0;
-            queueIndexLimit = 0;
-            queueTransferSize = 0;
-            queueTransferSizeLimit = 0;
-        }
-        else
+        // ignored operations are considered as done
+        num += pending;
+        while(pending--)
         {
+            size += queueSizes[index];
+            if (++index == queueSize) index = 0;
+        }
+    }
 #ifdef DMA_DEBUG
-            KLog_U2_("  Delay remaining transfer on next frame, queue[", queueIndexLimit, "] moved to queue[0] (", queueIndex - queueIndexLimit, " elements copied)");
-            KLog_U2("    Before: queueIndex=", queueIndex, " queueTransferSize=", queueTransferSize);
+    else if (pending) KLog_U2("  Delay remaining transfer on next frame, index: ", index, " elements: ", pending);
 #endif
 
-            queueIndex -= queueIndexLimit;
-
-            // copy remaining transfer at beggining of the queue (not optimal but simpler)
-            memcpy(&dmaQueues[0], &dmaQueues[queueIndexLimit], sizeof(DMAOpInfo) * queueIndex);
-            queueTransferSize -= queueTransferSizeLimit;
-            queueIndexLimit = 0;
-            queueTransferSizeLimit = 0;
-
-#ifdef DMA_DEBUG
-            KLog_U2("    After: queueIndex=", queueIndex, " queueTransferSize=", queueTransferSize);
-#endif
-        }
-    }
-    else
-    {
-        queueIndex = 0;
-        queueIndexLimit = 0;
-        queueTransferSize = 0;
-        queueTransferSizeLimit = 0;
-    }
+    // remaining operations stay in the queue so they are sent first next time
+    flushIndex = index;
+    sentTransferSize += size;
+    sentOpCount += num;
 
     // we do that to fix cached auto inc value (instead of losing time in updating it during queue flush)
     VDP_setAutoInc(2);
+
+    PROF_end();
 }
 
 u16 DMA_getQueueSize()
 {
-    return queueIndex;
+    return queueOpCount - sentOpCount;
 }
 
 u32 DMA_getQueueTransferSize()
 {
-    return queueTransferSize;
+    return queueTransferSize - sentTransferSize;
 }
 
 u16 DMA_queueDma(u8 location, u32 from, u16 to, u16 len, u16 step)
@@ -206,13 +340,17 @@ u16 DMA_queueDma(u8 location, u32 from, u16 to, u16 len, u16 step)
     u32 banklimitw;
     DMAOpInfo *info;
 
+    // lock queue so it can't be flushed while we add the operation
+    queueLock++;
+
     // queue is full --> error
-    if (queueIndex >= queueSize)
+    if (DMA_getQueueSize() >= queueSize)
     {
 #if (LIB_DEBUG != 0)
         KDebug_Alert("DMA_queueDma(..) failed: queue is full !");
 #endif
 
+        DMA_unlockQueue();
         return FALSE;
     }
 
@@ -225,6 +363,13 @@ u16 DMA_queueDma(u8 location, u32 from, u16 to, u16 len, u16 step)
         // we first do the second bank transfer
         DMA_queueDma(location, from + banklimitb, to + banklimitb, len - banklimitw, step);
         newlen = banklimitw;
+
+        // queue may be full now (don't overwrite operations not yet sent)
+        if (DMA_getQueueSize() >= queueSize)
+        {
+            DMA_unlockQueue();
+            return FALSE;
+        }
     }
     // ok, use normal len
     else newlen = len;
@@ -264,57 +409,156 @@ u16 DMA_queueDma(u8 location, u32 from, u16 to, u16 len, u16 step)
             break;
     }
 
-    // pass to next index
-    queueIndex++;
-    // keep trace of transfered size
-    queueTransferSize += newlen << 1;
+    commitQueueEntry(newlen << 1);
+    DMA_unlockQueue();
 
-    // auto flush enabled --> set process on VBlank
-    if (flags & DMA_AUTOFLUSH) VIntProcess |= PROCESS_DMA_TASK;
+    return TRUE;
+}
 
-#ifdef DMA_DEBUG
-    KLog_U2("  Queue index=", queueIndex, " new queueTransferSize=", queueTransferSize);
+u16 DMA_queueVRamFill(u16 to, u16 len, u8 value, u16 step)
+{
+    DMAOpInfo *info;
+    u16 l;
+
+    // lock queue so it can't be flushed while we add the operation
+    queueLock++;
+
+    // queue is full --> error
+    if (DMA_getQueueSize() >= queueSize)
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("DMA_queueVRamFill(..) failed: queue is full !");
 #endif
 
-    // we have a limit defined ?
-    if (maxTransferPerFrame)
+        DMA_unlockQueue();
+        return FALSE;
+    }
+
+    // same adjustement than DMA_doVRamFill(..)
+    if (len)
     {
-        // above limit ?
-        if ((queueTransferSize > maxTransferPerFrame) && (queueIndexLimit == 0))
+        if (to & 1)
         {
+            if (len < 3) l = 1;
+            else l = len - 2;
+        }
+        else
+        {
+            if (len < 2) l = 1;
+            else l = len - 1;
+        }
+    }
+    else l = len;
+
+    info = &dmaQueues[queueIndex];
+
+    // $14:len H  $13:len L
+    info->regLen = ((l | (l << 8)) & 0xFF00FF) | 0x94009300;
+    // fill value (16 bits extended) in high word  $f:step
+    info->regAddrMStep = (((u32) (value | (value << 8))) << 16) | 0x8F00 | step;
+    // $17: VRAM fill mode
+    info->regAddrHAddrL = 0x97809500;
+    info->regCtrlWrite = GFX_DMA_VRAM_ADDR(to);
+
+#ifdef DMA_DEBUG
+    KLog_U4("DMA_queueVRamFill: to=", to, " len=", len, " value=", value, " step=", step);
+#endif
+
+    // fill runs at about the same speed than 68000 to VRAM transfer
+    commitQueueEntry(len?len:0x10000);
+    fillCopyOpId = queueOpCount;
+    DMA_unlockQueue();
+
+    return TRUE;
+}
+
+u16 DMA_queueVRamCopy(u16 from, u16 to, u16 len, u16 step)
+{
+    DMAOpInfo *info;
+
+    // lock queue so it can't be flushed while we add the operation
+    queueLock++;
+
+    // queue is full --> error
+    if (DMA_getQueueSize() >= queueSize)
+    {
 #if (LIB_DEBUG != 0)
-            KLog_S2("DMA_queueDma(..) warning: transfer size limit raised: current = ", queueTransferSize, "  max = ", maxTransferPerFrame);
+        KDebug_Alert("DMA_queueVRamCopy(..) failed: queue is full !");
 #endif
 
-            // more than 1 transfer ?
-            if (queueIndex > 1)
-            {
-                // stop on previous transfer
-                queueIndexLimit = queueIndex - 1;
-                queueTransferSizeLimit = queueTransferSize - (newlen << 1);
-            }
-            else
-            {
-                queueIndexLimit = queueIndex;
-                queueTransferSizeLimit = queueTransferSize;
-            }
+        DMA_unlockQueue();
+        return FALSE;
+    }
+
+    info = &dmaQueues[queueIndex];
+
+    // $14:len H  $13:len L
+    info->regLen = ((len | (len << 8)) & 0xFF00FF) | 0x94009300;
+    // $16:source H  $f:step
+    info->regAddrMStep = (((from << 8) & 0xFF0000) | 0x96008F00) + step;
+    // $17: VRAM copy mode  $15:source L
+    info->regAddrHAddrL = 0x97C09500 | (from & 0xFF);
+    info->regCtrlWrite = GFX_DMA_VRAMCOPY_ADDR(to);
 
 #ifdef DMA_DEBUG
-            KLog_U2("  Queue index limit set at ", queueIndexLimit, " and queueTransferSizeLimit = ", queueTransferSizeLimit);
+    KLog_U4("DMA_queueVRamCopy: from=", from, " to=", to, " len=", len, " step=", step);
 #endif
-        }
-    }
+
+    // copy needs a read and a write access per byte --> count it twice
+    commitQueueEntry(((u32) len) << 1);
+    fillCopyOpId = queueOpCount;
+    DMA_unlockQueue();
+
+    return TRUE;
+}
+
+static void commitQueueEntry(u32 size)
+{
+    // keep trace of transfered size
+    queueSizes[queueIndex] = size;
+    queueTransferSize += size;
+    // pass to next index
+    if (++queueIndex == queueSize) queueIndex = 0;
+    queueOpCount++;
+
+#ifdef DMA_DEBUG
+    KLog_U2("  Queue index=", queueIndex, " new queueTransferSize=", queueTransferSize);
+#endif
+}
+
+static void commitQueue()
+{
 #if (LIB_DEBUG != 0)
+    u32 size;
+#endif
+
+    // nothing to commit
+    if (commitOpCount == queueOpCount) return;
+
+    // publish added operations, a single write so DMA_flushQueue() always sees complete operations without masking interrupts
+    commitOpCount = queueOpCount;
+
+    // auto flush enabled --> set process on VBlank (after publishing so the process can't be cleared before operations are sent)
+    if (flags & DMA_AUTOFLUSH) VIntProcess |= PROCESS_DMA_TASK;
+
+#if (LIB_DEBUG != 0)
+    size = DMA_getQueueTransferSize();
+
+    // we have a limit defined ?
+    if (maxTransferPerFrame)
+    {
+        // above limit ?
+        if (size > maxTransferPerFrame)
+            KLog_S2("DMA_queueDma(..) warning: transfer size limit raised: current = ", size, "  max = ", maxTransferPerFrame);
+    }
     else
     {
-        if ((IS_PALSYSTEM) && (queueTransferSize > 17600))
+        if ((IS_PALSYSTEM) && (size > 17600))
             KDebug_Alert("DMA_queueDma(..) warning: transfer size is above 17600 bytes.");
-        else if (queueTransferSize > 7500)
+        else if (size > 7500)
             KDebug_Alert("DMA_queueDma(..) warning: transfer size is above 7500 bytes.");
     }
 #endif
-
-    return TRUE;
 }
 
 void DMA_waitCompletion()
@@ -368,7 +612,7 @@ void DMA_doDma(u8 location, u32 from, u16 to, u16 len, s16 step)
 
 #if (HALT_Z80_ON_DMA == 1)
     z80state = Z80_isBusTaken();
-    if (!z80state) Z80_requestBus(FALSE);
+    if (!z80state) Z80_requestBusEx(FALSE, Z80_BUS_DMA);
 #endif
 
     // Enable DMA
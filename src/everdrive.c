@@ -5,7 +5,9 @@
 /** MMC/SD card SPI mode commands **/
 #define CMD0  0x40    // software reset
 #define CMD1  0x41    // brings card out of idle state
+#define CMD12 0x4C    // stop transmission (ends multiple blocks read)
 #define CMD17 0x51    // read single block
+#define CMD18 0x52    // read multiple blocks
 #define CMD24 0x58    // writes a single block
 
 
@@ -13,6 +15,7 @@
 
 
 u8 evd_mmcCmd(u8 cmd, u32 arg);
+u8 evd_mmcStopRead();
 u16 cfg;
 u16 default_rom_bank;
 u8 is_ram_app;
@@ -207,6 +210,106 @@ u8 evd_mmcRdBlock(u32 mmc_addr, u8 *stor) {
     return 0;
 }
 
+u8 evd_mmcRdBlocks(u32 mmc_addr, u8 *stor, u16 num) {
+
+    u16 i = 0;
+    u16 *stor16 = (u16 *) stor;
+
+    if (num == 0)return 0;
+    if (num == 1)return evd_mmcRdBlock(mmc_addr, stor);
+
+
+    if (evd_mmcCmd(CMD18, mmc_addr) != 0) {
+        SS_ON;
+        for (;;) {
+
+            SPI_PORT = 0xff;
+            SPI_BUSY;
+
+
+            if ((SPI_PORT & 0xff) == 0) {
+                break;
+            }
+
+            if (i++ == 65535) {
+                SS_OFF;
+                return 1;
+            }
+        }
+    }
+
+    SS_ON;
+
+
+    while (num--) {
+
+        //each block is preceded by data token and followed by 2 bytes CRC
+        i = 0;
+
+        for (;;) {
+
+            SPI_PORT = 0xff;
+            SPI_BUSY;
+            if ((SPI_PORT & 0xff) == 0xfe)break;
+
+            if (i++ == 65535) {
+                SS_OFF;
+                evd_mmcStopRead();
+                return 2;
+            }
+        }
+
+        CFGS(_SPI16);
+
+
+        for (i = 0; i < 256; i++) {
+
+            SPI_PORT = 0xffff;
+            SPI_BUSY;
+            *stor16++ = SPI_PORT;
+        }
+
+        CFGC(_SPI16);
+
+
+        SPI_PORT = 0xff;
+        SPI_BUSY;
+        SPI_PORT = 0xff;
+        SPI_BUSY;
+    }
+
+    SS_OFF;
+
+    if (evd_mmcStopRead() != 0)return 3;
+
+    return 0;
+}
+
+u8 evd_mmcStopRead() {
+
+    u16 i = 0;
+
+    //response is not meaningful (stuff byte follows the command)
+    evd_mmcCmd(CMD12, 0);
+
+    //wait until card leaves busy state
+    SS_ON;
+    for (;;) {
+
+        SPI_PORT = 0xff;
+        SPI_BUSY;
+        if ((SPI_PORT & 0xff) == 0xff)break;
+
+        if (i++ == 65535) {
+            SS_OFF;
+            return 1;
+        }
+    }
+
+    SS_OFF;
+    return 0;
+}
+
 void evd_eprEraseBlock(u32 rom_addr) {
 
     u16 i;
@@ -13,6 +13,8 @@ u8 fat16GetDirClustersNum(u16 *num, u32 entry);
 u8 fat16GetFatTableRecord(u16 cluster, u16 *val);
 u8 fat16SetFatTableRecord(u16 cluster, u16 val);
 u8 fat16ApplyFatTableChange();
+u8 fat16NextCluster(Fat16File *file);
+u8 fat16SeekSector(Fat16File *file, u32 target);
 
 volatile u8 *sector_buff;
 
@@ -248,34 +250,30 @@ u8 fat16OpenFile(Fat16Record *rec, Fat16File *file) {
     file->cluster = rec->entry;
     file->sector = 0;
     file->addr_buff = (file->cluster - 2) * cluster_size + fat16_data_start;
+    file->extents = 0;
+    file->extent_num = 0;
+    file->extent_idx = 0;
 
     return 0;
 }
 
 u8 fat16SkipSectors(Fat16File *file, u16 num) {
 
+    u32 size = file->record->size;
+    u32 total = (size + 511) >> 9;
+    u32 target;
 
-    while (num--) {
-        if (file->pos >= file->record->size)return 1;
-        if (file->sector == fat16_pbr.sector_per_cluster) {
-            //fat16GetNextFileCluster(&file->cluster);
-            if (fat16GetFatTableRecord(file->cluster, &file->cluster) != 0)return 2;
-            file->sector = 0;
-            file->addr_buff = (file->cluster - 2) * cluster_size + fat16_data_start;
-        }
-
-
+    if (num == 0)return 0;
+    if (file->pos >= size)return 1;
 
-        file->sector++;
-        file->addr_buff += 512;
-
-        if (file->pos <= file->record->size - 512) {
-            file->pos += 512;
-        } else {
-            file->pos = file->record->size;
-        }
+    //direct seek instead of per sector walk
+    target = ((file->pos + 511) >> 9) + num;
+    if (target > total) {
+        if (fat16SeekSector(file, total) != 0)return 2;
+        return 1;
     }
 
+    if (fat16SeekSector(file, target) != 0)return 2;
 
     return 0;
 }
@@ -285,10 +283,7 @@ u8 fat16ReadNextSector(Fat16File *file) {
 
     if (file->pos >= file->record->size)return 1;
     if (file->sector == fat16_pbr.sector_per_cluster) {
-        //fat16GetNextFileCluster(&file->cluster);
-        if (fat16GetFatTableRecord(file->cluster, &file->cluster) != 0)return 2;
-        file->sector = 0;
-        file->addr_buff = (file->cluster - 2) * cluster_size + fat16_data_start;
+        if (fat16NextCluster(file) != 0)return 2;
     }
 
 
@@ -563,9 +558,7 @@ u8 fat16WriteNextSector(Fat16File *file) {
     if (file->pos >= file->record->size)return 1;
     if (file->sector == fat16_pbr.sector_per_cluster) {
 
-        if (fat16GetFatTableRecord(file->cluster, &file->cluster) != 0)return 2;
-        file->sector = 0;
-        file->addr_buff = (file->cluster - 2) * cluster_size + fat16_data_start;
+        if (fat16NextCluster(file) != 0)return 2;
     }
 
 
@@ -590,9 +583,7 @@ u8 fat16SetNextReadSector(Fat16File *file, u32 *addr) {
 
     if (file->pos >= file->record->size)return 1;
     if (file->sector == fat16_pbr.sector_per_cluster) {
-        //fat16GetNextFileCluster(&file->cluster);
-        if (fat16GetFatTableRecord(file->cluster, &file->cluster) != 0)return 2;
-        file->sector = 0;
+        if (fat16NextCluster(file) != 0)return 2;
     }
 
     *addr = (file->cluster - 2) * cluster_size + fat16_data_start + (file->sector << 9);
@@ -606,5 +597,204 @@ u8 fat16SetNextReadSector(Fat16File *file, u32 *addr) {
 
     return 0;
 }
+
+u8 fat16NextCluster(Fat16File *file) {
+
+    Fat16Extent *ext = file->extents;
+
+    if (ext != 0) {
+        //next cluster from extents cache
+        ext += file->extent_idx;
+        if (file->cluster - ext->cluster + 1 < ext->num) {
+            file->cluster++;
+        } else {
+            if (file->extent_idx + 1 >= file->extent_num)return 1;
+            file->extent_idx++;
+            file->cluster = ext[1].cluster;
+        }
+    } else {
+        if (fat16GetFatTableRecord(file->cluster, &file->cluster) != 0)return 1;
+    }
+
+    file->sector = 0;
+    file->addr_buff = (file->cluster - 2) * cluster_size + fat16_data_start;
+
+    return 0;
+}
+
+u8 fat16SeekSector(Fat16File *file, u32 target) {
+
+    u8 spc = fat16_pbr.sector_per_cluster;
+    u32 cur;
+    u16 idx;
+    u16 cur_idx;
+    u16 cluster;
+
+    if (target == 0) {
+        file->pos = 0;
+        file->cluster = file->record->entry;
+        file->sector = 0;
+        file->extent_idx = 0;
+        file->addr_buff = (file->cluster - 2) * cluster_size + fat16_data_start;
+
+        return 0;
+    }
+
+    //cluster change is done on next read so we stay at end of the previous cluster on boundary
+    idx = (target - 1) / spc;
+
+    if (file->extents != 0) {
+
+        Fat16Extent *ext = file->extents;
+        u16 i = 0;
+
+        while (idx >= ext->num) {
+            idx -= ext->num;
+            ext++;
+            if (++i >= file->extent_num)return 1;
+        }
+
+        cluster = ext->cluster + idx;
+        file->extent_idx = i;
+    } else {
+
+        //follow the chain from current cluster when seeking forward
+        cur = (file->pos + 511) >> 9;
+        cur_idx = cur ? (cur - 1) / spc : 0;
+
+        if (idx >= cur_idx) {
+            cluster = file->cluster;
+            idx -= cur_idx;
+        } else {
+            cluster = file->record->entry;
+        }
+
+        while (idx--) {
+            if (fat16GetFatTableRecord(cluster, &cluster) != 0)return 2;
+        }
+    }
+
+    file->cluster = cluster;
+    file->sector = ((target - 1) % spc) + 1;
+    file->addr_buff = (cluster - 2) * cluster_size + fat16_data_start + (file->sector << 9);
+    file->pos = target << 9;
+    if (file->pos > file->record->size)file->pos = file->record->size;
+
+    return 0;
+}
+
+u8 fat16BuildExtents(Fat16File *file, Fat16Extent *extents, u16 max) {
+
+    u32 clusters = (file->record->size + cluster_size - 1) / cluster_size;
+    u16 cluster = file->record->entry;
+    u16 next;
+    u16 num;
+
+    file->extents = 0;
+    file->extent_num = 0;
+    file->extent_idx = 0;
+
+    if (clusters == 0)return 0;
+    if (max == 0)return 3;
+
+    extents->cluster = cluster;
+    extents->num = 1;
+    num = 1;
+
+    while (--clusters) {
+
+        //FAT sector is buffered so this only reads the MMC every 256 clusters
+        if (fat16GetFatTableRecord(cluster, &next) != 0)return 1;
+        if (next < 2 || next >= 0xfff8)return 2;
+
+        if (next == cluster + 1 && extents[num - 1].num != 0xffff) {
+            extents[num - 1].num++;
+        } else {
+            if (num == max)return 3;
+            extents[num].cluster = next;
+            extents[num].num = 1;
+            num++;
+        }
+
+        cluster = next;
+    }
+
+    file->extents = extents;
+    file->extent_num = num;
+
+    //set extent index for current position
+    return fat16SeekSector(file, (file->pos + 511) >> 9);
+}
+
+u8 fat16Seek(Fat16File *file, u32 pos) {
+
+    if (pos > file->record->size)return 1;
+    if (fat16SeekSector(file, pos >> 9) != 0)return 2;
+
+    return 0;
+}
+
+u8 fat16ReadSectors(Fat16File *file, u8 *dest, u16 num, u16 *read) {
+
+    u8 spc = fat16_pbr.sector_per_cluster;
+    u32 size = file->record->size;
+    u32 run;
+    u32 left;
+    u32 sector;
+    u16 done = 0;
+    u8 resp = 0;
+
+    if (file->pos >= size) {
+        resp = 1;
+        num = 0;
+    }
+
+    while (num) {
+
+        if (file->pos >= size)break;
+        if (file->sector == spc) {
+            if (fat16NextCluster(file) != 0) {
+                resp = 2;
+                break;
+            }
+        }
+
+        //number of contiguous sectors from current position
+        run = spc - file->sector;
+        if (file->extents != 0) {
+            Fat16Extent *ext = &file->extents[file->extent_idx];
+            run += (u32) (ext->cluster + ext->num - 1 - file->cluster) * spc;
+        }
+
+        left = (size - file->pos + 511) >> 9;
+        if (run > left)run = left;
+        if (run > num)run = num;
+
+        if (evd_mmcRdBlocks(file->addr_buff, dest, run) != 0) {
+            resp = 3;
+            break;
+        }
+
+        dest += run << 9;
+        done += run;
+        num -= run;
+
+        file->addr_buff += run << 9;
+        file->pos += run << 9;
+        if (file->pos > size)file->pos = size;
+
+        //we can only cross clusters of current extent here
+        sector = file->sector + run;
+        while (sector > spc) {
+            sector -= spc;
+            file->cluster++;
+        }
+        file->sector = sector;
+    }
+
+    if (read != 0)*read = done;
+
+    return resp;
+}
 
 #endif  /* FAT16_SUPPORT */
@@ -0,0 +1,422 @@
+#include "config.h"
+#include "types.h"
+
+#include "loader.h"
+
+#include "vdp.h"
+#include "vdp_tile.h"
+#include "memory.h"
+#include "dma.h"
+#include "tools.h"
+#include "maths.h"
+#include "kdebug.h"
+
+
+#define JOB_TILESET         0
+#define JOB_MAP             1
+
+#define STATE_UNPACK        0
+#define STATE_UPLOAD        1
+#define STATE_PALETTE       2
+#define STATE_DONE          3
+
+
+/*
+ * Jobs are stored in a circular queue and processed in order.
+ *
+ * STATE_UNPACK   resource is packed (or need basetile to be applied) so we allocate a staging buffer.
+ * STATE_UPLOAD   data (from ROM or from the staging buffer) is queued for DMA by slice of 'budget' bytes.
+ *                Packed data is unpacked incrementally (see unpackStream(..)) just before being uploaded.
+ * STATE_PALETTE  palette transfer is queued (Image only) so it's done on same VBlank than last tilemap rows.
+ * STATE_DONE     last transfer has been queued, we wait for it to be sent (DMA_isOpDone(..)) before releasing the staging
+ *                buffer and calling the callback (transfers can be postponed by the DMA queue capacity limit).
+ */
+typedef struct
+{
+    u16 id;
+    u16 type;
+    u16 state;
+    LoaderCallback *callback;
+    const void *res;
+    const Palette *palette;
+    void *buffer;
+    u16 *data;
+    u16 *tilemap;
+    UnpackStream stream;
+    VDPPlan plan;
+    u16 basetile;
+    u16 x;
+    u16 y;
+    u16 pos;
+    u32 offset;
+    u16 lastOp;
+} LoaderJob;
+
+
+static LoaderJob jobs[LOADER_MAX_JOB];
+static u16 head = 0;
+static u16 numJob = 0;
+static u16 nextId = 1;
+static u16 budget = LOADER_DEFAULT_BUDGET;
+
+
+static LoaderJob *addJob(u16 type, const void *res, LoaderCallback *callback);
+static void releaseJob(LoaderJob *job);
+static u16 unpackJob(LoaderJob *job);
+static u32 unpackUpTo(LoaderJob *job, u32 size);
+static u16 uploadTileSet(LoaderJob *job, u16 *remaining);
+static u16 uploadMap(LoaderJob *job, u16 *remaining);
+static u16 getPlanAddress(VDPPlan plan, u16 x, u16 y);
+
+
+void LOADER_reset()
+{
+    while(numJob)
+    {
+        releaseJob(&jobs[head]);
+        head = (head + 1) & (LOADER_MAX_JOB - 1);
+        numJob--;
+    }
+
+    head = 0;
+}
+
+void LOADER_setBudget(u16 value)
+{
+    // keep it even (DMA works in word)
+    budget = value & 0xFFFE;
+}
+
+u16 LOADER_getBudget()
+{
+    return budget;
+}
+
+
+u16 LOADER_loadTileSet(const TileSet *tileset, u16 index, LoaderCallback *callback)
+{
+    LoaderJob *job = addJob(JOB_TILESET, tileset, callback);
+
+    if (job == NULL) return 0;
+
+    job->basetile = index;
+    // nothing to unpack ? upload directly from source
+    if (tileset->compression == COMPRESSION_NONE)
+    {
+        job->data = (u16*) tileset->tiles;
+        job->state = STATE_UPLOAD;
+    }
+
+    return job->id;
+}
+
+u16 LOADER_loadMap(VDPPlan plan, const Map *map, u16 basetile, u16 x, u16 y, LoaderCallback *callback)
+{
+    LoaderJob *job = addJob(JOB_MAP, map, callback);
+
+    if (job == NULL) return 0;
+
+    job->plan = plan;
+    job->basetile = basetile;
+    job->x = x;
+    job->y = y;
+    // nothing to unpack and no attribute to apply ? upload directly from source
+    if ((map->compression == COMPRESSION_NONE) && (basetile == 0))
+    {
+        job->data = map->tilemap;
+        job->state = STATE_UPLOAD;
+    }
+
+    return job->id;
+}
+
+u16 LOADER_loadImage(VDPPlan plan, const Image *image, u16 basetile, u16 x, u16 y, u16 loadpal, LoaderCallback *callback)
+{
+    u16 id;
+
+    // need 2 jobs
+    if (numJob > (LOADER_MAX_JOB - 2))
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("LOADER_loadImage failed: loader queue is full !");
+#endif
+        return 0;
+    }
+
+    LOADER_loadTileSet(image->tileset, basetile & TILE_INDEX_MASK, NULL);
+    id = LOADER_loadMap(plan, image->map, basetile, x, y, callback);
+
+    // palette is uploaded with last tilemap rows
+    if (loadpal) jobs[(head + numJob - 1) & (LOADER_MAX_JOB - 1)].palette = image->palette;
+
+    return id;
+}
+
+
+void LOADER_update()
+{
+    u16 remaining;
+    u16 ind;
+    u16 i;
+
+    // release jobs done on previous VBlank (always at head as jobs are processed in order)
+    while(numJob)
+    {
+        LoaderJob *job = &jobs[head];
+
+        // last transfer not yet done ?
+        if ((job->state != STATE_DONE) || !DMA_isOpDone(job->lastOp)) break;
+
+        releaseJob(job);
+        head = (head + 1) & (LOADER_MAX_JOB - 1);
+        numJob--;
+
+        if (job->callback) job->callback(job->id);
+    }
+
+    remaining = budget;
+    ind = head;
+    i = numJob;
+
+    while(i--)
+    {
+        LoaderJob *job = &jobs[ind];
+        const u16 state = job->state;
+
+        // not enough memory for staging buffer ? retry later
+        if ((job->state == STATE_UNPACK) && !unpackJob(job)) break;
+
+        if (job->state == STATE_UPLOAD)
+        {
+            u16 done;
+
+            if (job->type == JOB_TILESET) done = uploadTileSet(job, &remaining);
+            else done = uploadMap(job, &remaining);
+
+            // not yet completed (budget or DMA queue exhausted) --> stop here
+            if (!done) break;
+
+            job->state = (job->palette != NULL)?STATE_PALETTE:STATE_DONE;
+        }
+
+        if (job->state == STATE_PALETTE)
+        {
+            const Palette *pal = job->palette;
+            const u16 index = ((job->basetile >> 9) & 0x30) + (pal->index & 0xF);
+
+            if (!DMA_queueDma(DMA_CRAM, (u32) pal->data, index * 2, pal->length, 2)) break;
+
+            job->state = STATE_DONE;
+        }
+
+        // keep trace of last transfer
+        if ((job->state == STATE_DONE) && (state != STATE_DONE)) job->lastOp = DMA_getQueueOpId();
+
+        ind = (ind + 1) & (LOADER_MAX_JOB - 1);
+    }
+}
+
+u16 LOADER_getNumPending()
+{
+    return numJob;
+}
+
+
+static LoaderJob *addJob(u16 type, const void *res, LoaderCallback *callback)
+{
+    LoaderJob *job;
+
+    if (numJob >= LOADER_MAX_JOB)
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("LOADER: cannot add resource, loader queue is full !");
+#endif
+        return NULL;
+    }
+
+    job = &jobs[(head + numJob) & (LOADER_MAX_JOB - 1)];
+    numJob++;
+
+    job->id = nextId++;
+    // 0 is reserved for error
+    if (nextId == 0) nextId = 1;
+    job->type = type;
+    job->state = STATE_UNPACK;
+    job->callback = callback;
+    job->res = res;
+    job->palette = NULL;
+    job->buffer = NULL;
+    job->data = NULL;
+    job->tilemap = NULL;
+    job->stream.compression = COMPRESSION_NONE;
+    job->pos = 0;
+    job->offset = 0;
+
+    return job;
+}
+
+static void releaseJob(LoaderJob *job)
+{
+    if (job->buffer)
+    {
+        MEM_free(job->buffer);
+        job->buffer = NULL;
+    }
+}
+
+static u16 unpackJob(LoaderJob *job)
+{
+    if (job->type == JOB_TILESET)
+    {
+        const TileSet *src = (const TileSet*) job->res;
+        TileSet *tileset = allocateTileSet(src);
+
+        if (tileset == NULL) return FALSE;
+
+        job->buffer = tileset;
+        job->data = (u16*) tileset->tiles;
+        unpackStreamInit(&job->stream, src->compression, (u8*) src->tiles, (u8*) tileset->tiles, 0);
+    }
+    else
+    {
+        const Map *src = (const Map*) job->res;
+        const u16 size = src->w * src->h;
+        Map *map;
+
+        if (src->compression == COMPRESSION_NONE)
+        {
+            // rows are copied from ROM with basetile applied
+            map = allocateMapEx(src->w, src->h);
+            if (map == NULL) return FALSE;
+
+            job->data = src->tilemap;
+            job->tilemap = map->tilemap;
+        }
+        else
+        {
+            // unpacked data can still be referenced by unpacker so basetile needs a second buffer
+            if (job->basetile) map = allocateMapEx(src->w, src->h * 2);
+            else map = allocateMap(src);
+            if (map == NULL) return FALSE;
+
+            job->data = map->tilemap;
+            if (job->basetile) job->tilemap = map->tilemap + size;
+            unpackStreamInit(&job->stream, src->compression, (u8*) src->tilemap, (u8*) map->tilemap, 0);
+        }
+
+        job->buffer = map;
+    }
+
+    job->state = STATE_UPLOAD;
+
+    return TRUE;
+}
+
+static u32 unpackUpTo(LoaderJob *job, u32 size)
+{
+    UnpackStream *stream = &job->stream;
+    u32 pos;
+
+    // data is not packed or already unpacked
+    if (stream->compression == COMPRESSION_NONE) return 0xFFFFFFFF;
+
+    pos = unpackStreamGetPos(stream);
+    if (!unpackStreamIsDone(stream) && (size > pos)) pos += unpackStream(stream, size - pos);
+
+    return pos;
+}
+
+static u16 uploadTileSet(LoaderJob *job, u16 *remaining)
+{
+    const TileSet *tileset = (const TileSet*) job->res;
+    const u32 size = tileset->numTile * 32;
+    u32 len;
+
+    // nothing left in budget
+    if (*remaining == 0) return FALSE;
+
+    len = min(unpackUpTo(job, job->offset + *remaining), size) - job->offset;
+    if (len > *remaining) len = *remaining;
+    if (len == 0) return FALSE;
+
+    if (!DMA_queueDma(DMA_VRAM, ((u32) job->data) + job->offset, (job->basetile * 32) + job->offset, len / 2, 2))
+        return FALSE;
+
+    job->offset += len;
+    *remaining -= len;
+
+    return (job->offset >= size);
+}
+
+static u16 uploadMap(LoaderJob *job, u16 *remaining)
+{
+    const Map *map = (const Map*) job->res;
+    const u16 w = map->w;
+    const u16 h = map->h;
+    const u16 rowSize = w * 2;
+    const u16 baseinc = job->basetile & (TILE_INDEX_MASK | TILE_ATTR_PALETTE_MASK);
+    const u16 baseor = job->basetile & (TILE_ATTR_PRIORITY_MASK | TILE_ATTR_VFLIP_MASK | TILE_ATTR_HFLIP_MASK);
+    const u16 pw = (job->plan.value == CONST_PLAN_WINDOW)?windowWidth:planWidth;
+    // number of tile before horizontal wrapping
+    const u16 wl = min(w, pw - (job->x & (pw - 1)));
+    // unpack rows we can upload in this frame (at least one)
+    const u32 available = unpackUpTo(job, (job->pos + max(*remaining / rowSize, 1)) * rowSize);
+
+    while(job->pos < h)
+    {
+        u16 *row;
+        u16 addr;
+
+        // budget exhausted (always allow at least one row per frame)
+        if ((rowSize > *remaining) && (*remaining != budget)) return FALSE;
+        // row not yet unpacked
+        if (((job->pos + 1) * rowSize) > available) return FALSE;
+
+        row = job->data + (job->pos * w);
+
+        // apply basetile
+        if (job->tilemap)
+        {
+            const u16 *src = row;
+            u16 *dst = job->tilemap + (job->pos * w);
+            u16 i = w;
+
+            row = dst;
+            while(i--) *dst++ = baseor | (*src++ + baseinc);
+        }
+
+        addr = getPlanAddress(job->plan, job->x, job->y + job->pos);
+
+        if (!DMA_queueDma(DMA_VRAM, (u32) row, addr, wl, 2)) return FALSE;
+        // row wrap on plan width --> second part goes at beginning of the row
+        if (wl < w)
+        {
+            // queue full --> whole row is sent again on next frame
+            if (!DMA_queueDma(DMA_VRAM, (u32) (row + wl), addr - (((job->x & (pw - 1))) * 2), w - wl, 2))
+                return FALSE;
+        }
+
+        job->pos++;
+
+        if (rowSize >= *remaining) *remaining = 0;
+        else *remaining -= rowSize;
+    }
+
+    return TRUE;
+}
+
+static u16 getPlanAddress(VDPPlan plan, u16 x, u16 y)
+{
+    switch(plan.value)
+    {
+        default:
+        case CONST_PLAN_A:
+            return VDP_PLAN_A + (((x & (planWidth - 1)) + ((y & (planHeight - 1)) << planWidthSft)) * 2);
+
+        case CONST_PLAN_B:
+            return VDP_PLAN_B + (((x & (planWidth - 1)) + ((y & (planHeight - 1)) << planWidthSft)) * 2);
+
+        case CONST_PLAN_WINDOW:
+            return VDP_PLAN_WINDOW + (((x & (windowWidth - 1)) + ((y & (32 - 1)) << windowWidthSft)) * 2);
+    }
+}
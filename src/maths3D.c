@@ -164,22 +164,15 @@ void M3D_combineTransform(Transformation3D *left, Transformation3D *right, Trans
 
     Mat3D_f16 *matRes = &(result->mat);
     Translation3D *tRes = result->translation;
+    Vect3D_f16 tmp;
 
     // compute matrix product (36 multiplications + 27 additions... outch !!!)
-    matRes->a.x = ((mat1->a.x * mat2->a.x) + (mat1->a.y * mat2->b.x) + (mat1->a.z * mat2->c.x)) >> FIX16_FRAC_BITS;
-    matRes->a.y = ((mat1->a.x * mat2->a.y) + (mat1->a.y * mat2->b.y) + (mat1->a.z * mat2->c.y)) >> FIX16_FRAC_BITS;
-    matRes->a.z = ((mat1->a.x * mat2->a.z) + (mat1->a.y * mat2->b.z) + (mat1->a.z * mat2->c.z)) >> FIX16_FRAC_BITS;
-    tRes->x = (((mat1->a.x * t2->x) + (mat1->a.y * t2->y) + (mat1->a.z * t2->z)) >> FIX16_FRAC_BITS) + t1->x;
-
-    matRes->b.x = ((mat1->b.x * mat2->a.x) + (mat1->b.y * mat2->b.x) + (mat1->b.z * mat2->c.x)) >> FIX16_FRAC_BITS;
-    matRes->b.y = ((mat1->b.x * mat2->a.y) + (mat1->b.y * mat2->b.y) + (mat1->b.z * mat2->c.y)) >> FIX16_FRAC_BITS;
-    matRes->b.z = ((mat1->b.x * mat2->a.z) + (mat1->b.y * mat2->b.z) + (mat1->b.z * mat2->c.z)) >> FIX16_FRAC_BITS;
-    tRes->y = (((mat1->b.x * t2->x) + (mat1->b.y * t2->y) + (mat1->b.z * t2->z)) >> FIX16_FRAC_BITS) + t1->y;
+    mat3DMul_f16(mat1, mat2, matRes);
+    mat3DMulVect3D_f16(mat1, t2, &tmp, 1);
 
-    matRes->c.x = ((mat1->c.x * mat2->a.x) + (mat1->c.y * mat2->b.x) + (mat1->c.z * mat2->c.x)) >> FIX16_FRAC_BITS;
-    matRes->c.y = ((mat1->c.x * mat2->a.y) + (mat1->c.y * mat2->b.y) + (mat1->c.z * mat2->c.y)) >> FIX16_FRAC_BITS;
-    matRes->c.z = ((mat1->c.x * mat2->a.z) + (mat1->c.y * mat2->b.z) + (mat1->c.z * mat2->c.z)) >> FIX16_FRAC_BITS;
-    tRes->z = (((mat1->c.x * t2->x) + (mat1->c.y * t2->y) + (mat1->c.z * t2->z)) >> FIX16_FRAC_BITS) + t1->z;
+    tRes->x = tmp.x + t1->x;
+    tRes->y = tmp.y + t1->y;
+    tRes->z = tmp.z + t1->z;
 
     // rebuild matrix cached infos
     M3D_buildMat3DExtras(result);
@@ -340,39 +333,16 @@ void M3D_translate(Transformation3D *t, Vect3D_f16 *vertices, u16 numv)
 
 void M3D_rotate(Transformation3D *t, const Vect3D_f16 *src, Vect3D_f16 *dest, u16 numv)
 {
-    const fix16 *s;
-    fix16 *d;
-    u16 i;
-
     if (t->rebuildMat) M3D_buildMat3D(t);
 
-    s = (fix16*) src;
-    d = (fix16*) dest;
-    i = numv;
-
-    while (i--)
-    {
-        const fix16 sx = *s++;
-        const fix16 sy = *s++;
-        const fix16 sz = *s++;
-
-        *d++ = ((sx * t->mat.a.x) + (sy * t->mat.a.y) + (sz * t->mat.a.z)) >> FIX16_FRAC_BITS;
-        *d++ = ((sx * t->mat.b.x) + (sy * t->mat.b.y) + (sz * t->mat.b.z)) >> FIX16_FRAC_BITS;
-        *d++ = ((sx * t->mat.c.x) + (sy * t->mat.c.y) + (sz * t->mat.c.z)) >> FIX16_FRAC_BITS;
-    }
+    mat3DMulVect3D_f16(&(t->mat), src, dest, numv);
 }
 
 void M3D_rotateInv(Transformation3D *t, const Vect3D_f16 *src, Vect3D_f16 *dest)
 {
     if (t->rebuildMat) M3D_buildMat3D(t);
 
-    const fix16 sx = src->x;
-    const fix16 sy = src->y;
-    const fix16 sz = src->z;
-
-    dest->x = ((sx * t->matInv.a.x) + (sy * t->matInv.a.y) + (sz * t->matInv.a.z)) >> FIX16_FRAC_BITS;
-    dest->y = ((sx * t->matInv.b.x) + (sy * t->matInv.b.y) + (sz * t->matInv.b.z)) >> FIX16_FRAC_BITS;
-    dest->z = ((sx * t->matInv.c.x) + (sy * t->matInv.c.y) + (sz * t->matInv.c.z)) >> FIX16_FRAC_BITS;
+    mat3DMulVect3D_f16(&(t->matInv), src, dest, 1);
 }
 
 //void M3D_transform_old(Transformation3D *t, const Vect3D_f16 *src, Vect3D_f16 *dest, u16 numv)
@@ -207,3 +207,218 @@ M3D_project_s16:
 .L42:
     movem.l (%sp)+,%d2-%d7/%a2-%a3
     rts
+
+
+    .globl    M3D_processMesh
+    .type    M3D_processMesh, @function
+M3D_processMesh:
+    movm.l %d2-%d7/%a2-%a6,-(%sp)
+
+    move.l 48(%sp),%a2                      | a2 = &transform
+
+    tst.w (%a2)
+    jeq .L60
+
+    move.l %a2,-(%sp)
+    jsr M3D_buildMat3D
+    addq.l #4,%sp
+
+.L60:
+    lea context3D,%a0
+
+    move.w (%a0)+,%d6
+    lsr.w #1,%d6                            | centerX = viewport.x / 2
+    swap %d6
+    move.w (%a0)+,%d6
+    lsr.w #1,%d6                            | d6 = (centerX << 16) | centerY
+
+    move.w (%a0),%d0
+    ext.l %d0
+    swap %d0
+    asr.l #6,%d0
+    move.l %d0,%a6                          | a6 = camDist << (6 + 4)
+
+    move.l 2(%a2),%a1                       | a1 = &translation
+    movem.w (%a1)+,%a3-%a5                  | a3 = translation.x   a4 = translation.y   a5 = translation.z
+    adda.w (%a0),%a5                        | a5 = translation.z + camDist
+
+    move.l 52(%sp),%a0                      | a0 = mesh
+    move.w (%a0),%d5                        | d5 = mesh->numVertex
+    move.l 4(%a0),%a0                       | a0 = src = mesh->vertices
+    move.l 56(%sp),%a1                      | a1 = dst = buf
+    lea 10(%a2),%a2                         | a2 = &(transform.mat)
+
+    subq.w #1,%d5
+    jmi .L66
+
+.L62:                                       | while(numVertex--) {
+    movem.w (%a0)+,%d2-%d4                  |   d2 = sx        d3 = sy        d4 = sz
+
+    move.w (%a2)+,%d0
+    muls.w %d2,%d0
+    move.w (%a2)+,%d1
+    muls.w %d3,%d1
+    add.l %d1,%d0
+    move.w (%a2)+,%d1
+    muls.w %d4,%d1
+    add.l %d1,%d0
+    asr.l #6,%d0
+    add.w %a3,%d0                           |   d0 = x = (mat.a * s) + translation.x
+
+    move.w (%a2)+,%d7
+    muls.w %d2,%d7
+    move.w (%a2)+,%d1
+    muls.w %d3,%d1
+    add.l %d1,%d7
+    move.w (%a2)+,%d1
+    muls.w %d4,%d1
+    add.l %d1,%d7
+    asr.l #6,%d7
+    add.w %a4,%d7                           |   d7 = y = (mat.b * s) + translation.y
+
+    muls.w (%a2)+,%d2
+    muls.w (%a2)+,%d3
+    add.l %d3,%d2
+    muls.w (%a2)+,%d4
+    add.l %d4,%d2
+    asr.l #6,%d2
+    lea -18(%a2),%a2                        |   a2 = &(transform.mat)
+    add.w %a5,%d2                           |   if ((zi = (mat.c * s) + translation.z + camDist) > 0)
+    jle .L64                                |   {
+
+    move.l %a6,%d3
+    divs.w %d2,%d3                          |       d3 = scale = fix16Div((camDist << (4 + 2)), zi)
+
+    muls.w %d3,%d0
+    swap %d0
+    rol.l #4,%d0
+    move.l %d6,%d1
+    swap %d1
+    add.w %d1,%d0
+    move.w %d0,(%a1)+                       |       d->x = centerX + (scale * x)
+
+    muls.w %d3,%d7
+    swap %d7
+    rol.l #4,%d7
+    move.w %d6,%d0
+    sub.w %d7,%d0
+    move.w %d0,(%a1)+                       |       d->y = centerY - (scale * y)
+    move.w %d2,(%a1)+                       |       d->z = zi
+
+    dbra %d5,.L62
+    jra .L66                                |   }
+                                            |   else
+.L64:                                       |   {
+    move.l %d6,(%a1)+                       |       d->x = centerX
+                                            |       d->y = centerY
+    move.w %d2,(%a1)+                       |       d->z = zi
+                                            |   }
+    dbra %d5,.L62                           | }
+
+.L66:
+    move.l 52(%sp),%a0                      | a0 = mesh
+    moveq #0,%d7
+    move.w 2(%a0),%d7                       | d7 = mesh->numFace (high word = number of visible face)
+    move.l 8(%a0),%a3                       | a3 = norm = mesh->faceNormals
+    move.l 12(%a0),%a0                      | a0 = ind = mesh->faceIndexes
+    move.l 56(%sp),%a1                      | a1 = buf
+    move.l 60(%sp),%a2                      | a2 = dst = faces
+    move.w 66(%sp),%d6                      | d6 = col
+
+    suba.l %a6,%a6                          | a6 = NULL (no lighting)
+    tst.w context3D+12                      | light enabled ?
+    jeq .L68
+    move.l %a3,%d0                          | face normals defined ?
+    jeq .L68
+    move.l 48(%sp),%a6
+    lea 52(%a6),%a6                         | a6 = &(transform.lightInv)
+
+.L68:
+    subq.w #1,%d7
+    jmi .L76
+
+.L70:                                       | while(numFace--) {
+    suba.l %a5,%a5                          |   a5 = zsum = 0
+
+    move.w (%a0)+,%d0
+    add.w %d0,%d0
+    move.w %d0,%d1
+    add.w %d0,%d0
+    add.w %d1,%d0                           |   d0 = *ind++ * 6
+    lea (%a1,%d0.w),%a4
+    move.l (%a4)+,(%a2)                     |   dst->pts[0] = buf[ind].xy
+    adda.w (%a4),%a5                        |   zsum += buf[ind].z
+
+    move.w (%a0)+,%d0
+    add.w %d0,%d0
+    move.w %d0,%d1
+    add.w %d0,%d0
+    add.w %d1,%d0
+    lea (%a1,%d0.w),%a4
+    move.l (%a4)+,4(%a2)                    |   dst->pts[1] = buf[ind].xy
+    adda.w (%a4),%a5
+
+    move.w (%a0)+,%d0
+    add.w %d0,%d0
+    move.w %d0,%d1
+    add.w %d0,%d0
+    add.w %d1,%d0
+    lea (%a1,%d0.w),%a4
+    move.l (%a4)+,8(%a2)                    |   dst->pts[2] = buf[ind].xy
+    adda.w (%a4),%a5
+
+    move.w (%a0)+,%d0
+    add.w %d0,%d0
+    move.w %d0,%d1
+    add.w %d0,%d0
+    add.w %d1,%d0
+    lea (%a1,%d0.w),%a4
+    move.l (%a4)+,12(%a2)                   |   dst->pts[3] = buf[ind].xy
+    adda.w (%a4),%a5
+
+    movem.w (%a2),%d0-%d5                   |   d0 = x0  d1 = y0  d2 = x1  d3 = y1  d4 = x2  d5 = y2
+    sub.w %d0,%d4                           |   d4 = x2 - x0
+    sub.w %d1,%d3                           |   d3 = y1 - y0
+    muls.w %d4,%d3                          |   d3 = (x2 - x0) * (y1 - y0)
+    sub.w %d0,%d2                           |   d2 = x1 - x0
+    sub.w %d1,%d5                           |   d5 = y2 - y0
+    muls.w %d5,%d2                          |   d2 = (x1 - x0) * (y2 - y0)
+    cmp.l %d3,%d2                           |   if (culled) continue
+    jlt .L74
+
+    move.l %a5,%d0
+    asr.l #2,%d0
+    move.w %d0,16(%a2)                      |   dst->z = zsum / 4
+
+    move.w %d6,%d1                          |   d1 = col
+    move.l %a6,%d0                          |   lighting ?
+    jeq .L72
+
+    movem.w (%a3),%d2-%d4                   |   d2 = norm->x   d3 = norm->y   d4 = norm->z
+    muls.w (%a6),%d2
+    muls.w 2(%a6),%d3
+    add.l %d3,%d2
+    muls.w 4(%a6),%d4
+    add.l %d4,%d2
+    asr.l #6,%d2                            |   d2 = dp = lightInv . norm
+    jle .L72                                |   if (dp > 0)
+
+    asr.w #4,%d2
+    add.w %d2,%d1                           |       col += dp >> (FIX16_FRAC_BITS - 2)
+
+.L72:
+    move.w %d1,18(%a2)                      |   dst->col = col
+    lea 20(%a2),%a2                         |   dst++
+    add.l #0x10000,%d7                      |   numVisible++
+
+.L74:
+    addq.l #6,%a3                           |   norm++
+    dbra %d7,.L70                           | }
+
+.L76:
+    swap %d7
+    moveq #0,%d0
+    move.w %d7,%d0                          | return numVisible
+
+    movem.l (%sp)+,%d2-%d7/%a2-%a6
+    rts
@@ -0,0 +1,394 @@
+    .extern    reciptab16
+
+
+# ---------------------------------------------------------------
+# fix32 fix32MulSafe(fix32 val1, fix32 val2);
+#
+# 32x32=64 bits multiplication built from 16x16 partial products
+# so intermediate result cannot overflow.
+# ---------------------------------------------------------------
+
+    .globl    fix32MulSafe
+    .type    fix32MulSafe, @function
+fix32MulSafe:
+    movem.l %d2-%d5,-(%sp)
+
+    move.l 20(%sp),%d0                      | d0 = a = val1
+    move.l 24(%sp),%d1                      | d1 = b = val2
+    move.l %d0,%d5
+    eor.l %d1,%d5                           | d5 = sign of result (bit 31)
+
+    tst.l %d0
+    jpl .L01
+    neg.l %d0                               | d0 = |a|
+.L01:
+    tst.l %d1
+    jpl .L02
+    neg.l %d1                               | d1 = |b|
+.L02:
+    move.l %d0,%d2
+    swap %d2                                | d2.w = ah
+    move.l %d1,%d3
+    swap %d3                                | d3.w = bh
+
+    move.w %d0,%d4
+    mulu.w %d1,%d4                          | d4 = lo = al * bl
+    mulu.w %d3,%d0                          | d0 = al * bh
+    mulu.w %d2,%d1                          | d1 = ah * bl
+    mulu.w %d3,%d2                          | d2 = hi = ah * bh
+
+    add.l %d1,%d0                           | d0 = mid = (al * bh) + (ah * bl)
+    jcc .L03
+    add.l #0x10000,%d2                      | mid carry goes in hi (bit 48 of result)
+
+.L03:
+    move.l %d0,%d1
+    swap %d1
+    clr.w %d1                               | d1 = mid << 16
+    clr.w %d0
+    swap %d0                                | d0 = mid >> 16
+    add.l %d1,%d4
+    addx.l %d0,%d2                          | hi:lo = |a| * |b|
+
+    tst.l %d5
+    jpl .L04
+    neg.l %d4
+    negx.l %d2                              | hi:lo = -(hi:lo)
+
+.L04:
+    moveq #10,%d1
+    lsr.l %d1,%d4
+    moveq #22,%d1
+    lsl.l %d1,%d2
+    or.l %d4,%d2
+    move.l %d2,%d0                          | return (hi:lo) >> FIX32_FRAC_BITS
+
+    movem.l (%sp)+,%d2-%d5
+    rts
+
+
+# ---------------------------------------------------------------
+# fix16 fix16DivFast(fix16 val1, fix16 val2);
+#
+# Use reciprocal table (multiplication) when |val2| < 1024,
+# standard division otherwise.
+# ---------------------------------------------------------------
+
+    .globl    fix16DivFast
+    .type    fix16DivFast, @function
+fix16DivFast:
+    move.w 6(%sp),%d0                       | d0 = val1
+    move.w 10(%sp),%d1                      | d1 = val2
+    jpl .L11
+    neg.w %d1                               | d1 = |val2|
+
+.L11:
+    cmp.w #1024,%d1                         | |val2| >= 1024 ? (unsigned test so 0x8000 is also catched)
+    jcc .L15
+
+    add.w %d1,%d1
+    lea reciptab16,%a0
+    move.w 0(%a0,%d1.w),%d1                 | d1 = 0x10000 / |val2|
+
+    tst.w %d0
+    jmi .L13
+
+    mulu.w %d1,%d0
+    moveq #10,%d1
+    lsr.l %d1,%d0                           | d0 = (val1 * (0x10000 / |val2|)) >> (16 - FIX16_FRAC_BITS)
+
+    tst.w 10(%sp)                           | val2 < 0 ?
+    jpl .L12
+    neg.w %d0
+.L12:
+    rts
+
+.L13:
+    neg.w %d0
+    mulu.w %d1,%d0
+    moveq #10,%d1
+    lsr.l %d1,%d0                           | d0 = (|val1| * (0x10000 / |val2|)) >> (16 - FIX16_FRAC_BITS)
+
+    tst.w 10(%sp)                           | val2 > 0 ?
+    jmi .L14
+    neg.w %d0
+.L14:
+    rts
+
+.L15:
+    ext.l %d0
+    asl.l #6,%d0
+    divs.w 10(%sp),%d0                      | d0 = (val1 << FIX16_FRAC_BITS) / val2
+    rts
+
+
+# ---------------------------------------------------------------
+# void vect2DAdd_f16(const Vect2D_f16 *src1, const Vect2D_f16 *src2, Vect2D_f16 *dest, u16 num);
+# ---------------------------------------------------------------
+
+    .globl    vect2DAdd_f16
+    .type    vect2DAdd_f16, @function
+vect2DAdd_f16:
+    move.l %a2,-(%sp)
+
+    movem.l 8(%sp),%a0-%a2                  | a0 = src1    a1 = src2    a2 = dest
+    move.w 22(%sp),%d1                      | d1 = num
+    jra .L22
+
+.L21:
+    move.w (%a0)+,%d0
+    add.w (%a1)+,%d0
+    move.w %d0,(%a2)+                       | dest->x = src1->x + src2->x
+    move.w (%a0)+,%d0
+    add.w (%a1)+,%d0
+    move.w %d0,(%a2)+                       | dest->y = src1->y + src2->y
+.L22:
+    dbra %d1,.L21
+
+    move.l (%sp)+,%a2
+    rts
+
+
+# ---------------------------------------------------------------
+# void vect3DAdd_f16(const Vect3D_f16 *src1, const Vect3D_f16 *src2, Vect3D_f16 *dest, u16 num);
+# ---------------------------------------------------------------
+
+    .globl    vect3DAdd_f16
+    .type    vect3DAdd_f16, @function
+vect3DAdd_f16:
+    move.l %a2,-(%sp)
+
+    movem.l 8(%sp),%a0-%a2                  | a0 = src1    a1 = src2    a2 = dest
+    move.w 22(%sp),%d1                      | d1 = num
+    jra .L32
+
+.L31:
+    move.w (%a0)+,%d0
+    add.w (%a1)+,%d0
+    move.w %d0,(%a2)+                       | dest->x = src1->x + src2->x
+    move.w (%a0)+,%d0
+    add.w (%a1)+,%d0
+    move.w %d0,(%a2)+                       | dest->y = src1->y + src2->y
+    move.w (%a0)+,%d0
+    add.w (%a1)+,%d0
+    move.w %d0,(%a2)+                       | dest->z = src1->z + src2->z
+.L32:
+    dbra %d1,.L31
+
+    move.l (%sp)+,%a2
+    rts
+
+
+# ---------------------------------------------------------------
+# void vect2DScale_f16(const Vect2D_f16 *src, fix16 scale, Vect2D_f16 *dest, u16 num);
+# ---------------------------------------------------------------
+
+    .globl    vect2DScale_f16
+    .type    vect2DScale_f16, @function
+vect2DScale_f16:
+    move.l %d2,-(%sp)
+
+    move.l 8(%sp),%a0                       | a0 = src
+    move.w 14(%sp),%d1                      | d1 = scale
+    move.l 16(%sp),%a1                      | a1 = dest
+    move.w 22(%sp),%d2                      | d2 = num
+    jra .L42
+
+.L41:
+    move.w (%a0)+,%d0
+    muls.w %d1,%d0
+    asr.l #6,%d0
+    move.w %d0,(%a1)+                       | dest->x = src->x * scale
+    move.w (%a0)+,%d0
+    muls.w %d1,%d0
+    asr.l #6,%d0
+    move.w %d0,(%a1)+                       | dest->y = src->y * scale
+.L42:
+    dbra %d2,.L41
+
+    move.l (%sp)+,%d2
+    rts
+
+
+# ---------------------------------------------------------------
+# void vect3DScale_f16(const Vect3D_f16 *src, fix16 scale, Vect3D_f16 *dest, u16 num);
+# ---------------------------------------------------------------
+
+    .globl    vect3DScale_f16
+    .type    vect3DScale_f16, @function
+vect3DScale_f16:
+    move.l %d2,-(%sp)
+
+    move.l 8(%sp),%a0                       | a0 = src
+    move.w 14(%sp),%d1                      | d1 = scale
+    move.l 16(%sp),%a1                      | a1 = dest
+    move.w 22(%sp),%d2                      | d2 = num
+    jra .L52
+
+.L51:
+    move.w (%a0)+,%d0
+    muls.w %d1,%d0
+    asr.l #6,%d0
+    move.w %d0,(%a1)+                       | dest->x = src->x * scale
+    move.w (%a0)+,%d0
+    muls.w %d1,%d0
+    asr.l #6,%d0
+    move.w %d0,(%a1)+                       | dest->y = src->y * scale
+    move.w (%a0)+,%d0
+    muls.w %d1,%d0
+    asr.l #6,%d0
+    move.w %d0,(%a1)+                       | dest->z = src->z * scale
+.L52:
+    dbra %d2,.L51
+
+    move.l (%sp)+,%d2
+    rts
+
+
+# ---------------------------------------------------------------
+# void vect2DDot_f16(const Vect2D_f16 *src1, const Vect2D_f16 *src2, fix16 *dest, u16 num);
+# ---------------------------------------------------------------
+
+    .globl    vect2DDot_f16
+    .type    vect2DDot_f16, @function
+vect2DDot_f16:
+    movem.l %d2/%a2,-(%sp)
+
+    movem.l 12(%sp),%a0-%a2                 | a0 = src1    a1 = src2    a2 = dest
+    move.w 26(%sp),%d2                      | d2 = num
+    jra .L62
+
+.L61:
+    move.w (%a0)+,%d0
+    muls.w (%a1)+,%d0                       | d0 = src1->x * src2->x
+    move.w (%a0)+,%d1
+    muls.w (%a1)+,%d1
+    add.l %d1,%d0                           | d0 += src1->y * src2->y
+    asr.l #6,%d0
+    move.w %d0,(%a2)+
+.L62:
+    dbra %d2,.L61
+
+    movem.l (%sp)+,%d2/%a2
+    rts
+
+
+# ---------------------------------------------------------------
+# void vect3DDot_f16(const Vect3D_f16 *src1, const Vect3D_f16 *src2, fix16 *dest, u16 num);
+# ---------------------------------------------------------------
+
+    .globl    vect3DDot_f16
+    .type    vect3DDot_f16, @function
+vect3DDot_f16:
+    movem.l %d2/%a2,-(%sp)
+
+    movem.l 12(%sp),%a0-%a2                 | a0 = src1    a1 = src2    a2 = dest
+    move.w 26(%sp),%d2                      | d2 = num
+    jra .L72
+
+.L71:
+    move.w (%a0)+,%d0
+    muls.w (%a1)+,%d0                       | d0 = src1->x * src2->x
+    move.w (%a0)+,%d1
+    muls.w (%a1)+,%d1
+    add.l %d1,%d0                           | d0 += src1->y * src2->y
+    move.w (%a0)+,%d1
+    muls.w (%a1)+,%d1
+    add.l %d1,%d0                           | d0 += src1->z * src2->z
+    asr.l #6,%d0
+    move.w %d0,(%a2)+
+.L72:
+    dbra %d2,.L71
+
+    movem.l (%sp)+,%d2/%a2
+    rts
+
+
+# ---------------------------------------------------------------
+# void mat3DMulVect3D_f16(const Mat3D_f16 *mat, const Vect3D_f16 *src, Vect3D_f16 *dest, u16 num);
+# ---------------------------------------------------------------
+
+    .globl    mat3DMulVect3D_f16
+    .type    mat3DMulVect3D_f16, @function
+mat3DMulVect3D_f16:
+    movem.l %d2-%d5/%a2,-(%sp)
+
+    movem.l 24(%sp),%a0-%a2                 | a0 = mat     a1 = src     a2 = dest
+    move.w 38(%sp),%d5                      | d5 = num
+    jra .L82
+
+.L81:
+    movem.w (%a1)+,%d2-%d4                  | d2 = sx        d3 = sy        d4 = sz
+
+    move.w (%a0)+,%d0
+    muls.w %d2,%d0
+    move.w (%a0)+,%d1
+    muls.w %d3,%d1
+    add.l %d1,%d0
+    move.w (%a0)+,%d1
+    muls.w %d4,%d1
+    add.l %d1,%d0
+    asr.l #6,%d0
+    move.w %d0,(%a2)+                       | dest->x = (mat.a.x * sx) + (mat.a.y * sy) + (mat.a.z * sz)
+
+    move.w (%a0)+,%d0
+    muls.w %d2,%d0
+    move.w (%a0)+,%d1
+    muls.w %d3,%d1
+    add.l %d1,%d0
+    move.w (%a0)+,%d1
+    muls.w %d4,%d1
+    add.l %d1,%d0
+    asr.l #6,%d0
+    move.w %d0,(%a2)+                       | dest->y = (mat.b.x * sx) + (mat.b.y * sy) + (mat.b.z * sz)
+
+    muls.w (%a0)+,%d2
+    muls.w (%a0)+,%d3
+    add.l %d3,%d2
+    muls.w (%a0)+,%d4
+    add.l %d4,%d2
+    asr.l #6,%d2
+    move.w %d2,(%a2)+                       | dest->z = (mat.c.x * sx) + (mat.c.y * sy) + (mat.c.z * sz)
+
+    lea -18(%a0),%a0                        | a0 = mat
+.L82:
+    dbra %d5,.L81
+
+    movem.l (%sp)+,%d2-%d5/%a2
+    rts
+
+
+# ---------------------------------------------------------------
+# void mat3DMul_f16(const Mat3D_f16 *mat1, const Mat3D_f16 *mat2, Mat3D_f16 *dest);
+# ---------------------------------------------------------------
+
+    .globl    mat3DMul_f16
+    .type    mat3DMul_f16, @function
+mat3DMul_f16:
+    movem.l %d2-%d6/%a2,-(%sp)
+
+    movem.l 28(%sp),%a0-%a2                 | a0 = mat1    a1 = mat2    a2 = dest
+    moveq #2,%d5                            | d5 = row
+
+.L91:
+    movem.w (%a0)+,%d2-%d4                  | d2 = row.x     d3 = row.y     d4 = row.z
+    moveq #2,%d6                            | d6 = column
+
+.L92:
+    move.w (%a1)+,%d0
+    muls.w %d2,%d0
+    move.w 4(%a1),%d1
+    muls.w %d3,%d1
+    add.l %d1,%d0
+    move.w 10(%a1),%d1
+    muls.w %d4,%d1
+    add.l %d1,%d0
+    asr.l #6,%d0
+    move.w %d0,(%a2)+                       | dest[row][col] = row . mat2[..][col]
+    dbra %d6,.L92
+
+    subq.l #6,%a1                           | a1 = mat2
+    dbra %d5,.L91
+
+    movem.l (%sp)+,%d2-%d6/%a2
+    rts
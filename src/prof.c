@@ -0,0 +1,738 @@
+#include "config.h"
+#include "types.h"
+
+#include "prof.h"
+
+#include "sys.h"
+#include "vdp.h"
+#include "vdp_bg.h"
+#include "timer.h"
+#include "memory.h"
+#include "sram.h"
+#include "string.h"
+#include "tools.h"
+
+
+// V counter last value before rollback (linear) and first value after rollback
+#define NTSC_V28_LAST       0xEA
+#define NTSC_V28_JUMP       0xE5
+#define PAL_V28_LAST        0x102
+#define PAL_V28_JUMP        0xCA
+#define PAL_V30_LAST        0x10A
+#define PAL_V30_JUMP        0xD2
+
+// H counter last value before jump (+1), first value after jump, total value per line and V counter increment position
+#define H40_END             0xB7
+#define H40_JUMP            0xE4
+#define H40_TOTAL           211
+#define H40_VINC            0xA5
+#define H32_END             0x94
+#define H32_JUMP            0xE9
+#define H32_TOTAL           171
+#define H32_VINC            0x85
+
+#define NO_LINE             0xFFFF
+
+// sample dump header
+#define SAMPLE_MAGIC        0x50534D50
+#define SAMPLE_VERSION      1
+#define SAMPLE_HEADER_SIZE  12
+// return address lower limit (vectors and ROM header)
+#define SAMPLE_ROM_START    0x200
+// stack scan upper limit
+#define SAMPLE_RAM_END      0x01000000
+
+// statistics table header (zone name is 13 characters width then 5 / 7 / 7 / 7 characters for numbers)
+#define HEADER              "Zone            Nb    Min    Avg    Max"
+
+
+// timing parameters for current video mode
+static u16 curHeight = 0;
+static u16 curWidth = 0;
+static u16 lpf;
+static u16 vLast;
+static u16 vJump;
+static u16 hEnd;
+static u16 hJump;
+static u16 hTotal;
+static u16 hInc;
+static u16 hMul;
+static u32 lastTime = 0;
+
+// sampling profiler
+static u32 *sampleBuffer = NULL;
+static u32 *sampleBufferEnd;
+static u32 *sampleWrite;
+static u16 sampleDepth;
+static u16 sampleMax;
+static vu16 sampleNum;
+static u16 sampling = FALSE;
+static u16 samplingHInt;
+static u16 prevHIntEnabled;
+
+// original internal callbacks (called by the sampling handlers)
+_voidCallback *profVIntCB;
+_voidCallback *profHIntCB;
+
+// sampling handlers (prof_a.s)
+extern void _prof_vint_sampler();
+extern void _prof_hint_sampler();
+// end of code section (linker)
+extern u32 _etext;
+
+
+static void setMode();
+static u32 lineToTime(u32 frame, u16 line, u16 h);
+
+
+u32 PROF_getTime()
+{
+    u32 frame;
+    u32 time;
+    u16 hv, v, h;
+    u16 l1, l2;
+
+    if ((screenHeight != curHeight) || (screenWidth != curWidth)) setMode();
+
+    // read frame counter and HV counter consistently
+    do
+    {
+        frame = vtimer;
+        hv = GET_HVCOUNTER;
+    } while(frame != vtimer);
+
+    v = hv >> 8;
+    h = hv & 0xFF;
+
+    // H counter jumps during horizontal blank --> linear position
+    if (h >= hJump) h -= hJump - hEnd;
+    // line starts when V counter is incremented
+    if (h >= hInc) h -= hInc;
+    else h += hTotal - hInc;
+    // convert to 1/256 line
+    h = (h * hMul) >> 8;
+
+    // V counter rolls back during vertical blank so a value can match 2 scanlines
+    l1 = NO_LINE;
+    l2 = NO_LINE;
+    if (v <= vLast) l1 = v;
+    if ((v + 256) <= vLast) l2 = v + 256;
+    else if (v >= vJump) l2 = (v + lpf) - 256;
+    if (l1 == NO_LINE)
+    {
+        l1 = l2;
+        l2 = NO_LINE;
+    }
+
+    // ambiguous ? use blank flag if it can discriminate (display enabled and only one scanline in blank area)
+    if ((l2 != NO_LINE) && (VDP_getReg(0x01) & 0x40))
+    {
+        const u16 b1 = (l1 >= screenHeight)?TRUE:FALSE;
+        const u16 b2 = (l2 >= screenHeight)?TRUE:FALSE;
+
+        if (b1 != b2)
+        {
+            if (b2 == (GET_VDPSTATUS(VDP_VBLANK_FLAG)?TRUE:FALSE)) l1 = l2;
+            l2 = NO_LINE;
+        }
+    }
+
+    time = lineToTime(frame, l1, h);
+
+    // still ambiguous --> take the first one which is not before last returned time
+    if (l2 != NO_LINE)
+    {
+        u32 t2 = lineToTime(frame, l2, h);
+
+        if ((s32) (t2 - time) < 0)
+        {
+            const u32 t = t2;
+            t2 = time;
+            time = t;
+        }
+        if ((s32) (time - lastTime) < 0) time = t2;
+    }
+
+    lastTime = time;
+
+    return time;
+}
+
+u32 PROF_timeToCycles(u32 time)
+{
+    return ((time >> 8) * PROF_CYCLE_PER_LINE) + (((time & 0xFF) * PROF_CYCLE_PER_LINE) >> 8);
+}
+
+
+static void setMode()
+{
+    curHeight = screenHeight;
+    curWidth = screenWidth;
+
+    if (IS_PALSYSTEM)
+    {
+        lpf = 313;
+        if (screenHeight == 240)
+        {
+            vLast = PAL_V30_LAST;
+            vJump = PAL_V30_JUMP;
+        }
+        else
+        {
+            vLast = PAL_V28_LAST;
+            vJump = PAL_V28_JUMP;
+        }
+    }
+    else
+    {
+        lpf = 262;
+        vLast = NTSC_V28_LAST;
+        vJump = NTSC_V28_JUMP;
+    }
+
+    if (screenWidth == 320)
+    {
+        hEnd = H40_END;
+        hJump = H40_JUMP;
+        hTotal = H40_TOTAL;
+        hInc = H40_VINC;
+    }
+    else
+    {
+        hEnd = H32_END;
+        hJump = H32_JUMP;
+        hTotal = H32_TOTAL;
+        hInc = H32_VINC;
+    }
+
+    hMul = 65536 / hTotal;
+}
+
+static u32 lineToTime(u32 frame, u16 line, u16 h)
+{
+    u16 k;
+
+    // frame counter is increased on V-Int so use V-Int scanline as frame origin
+    if (line >= screenHeight) k = line - screenHeight;
+    else k = (line + lpf) - screenHeight;
+
+    const u32 time = (((frame * lpf) + k) << 8) + h;
+
+    // V-Int line passed but frame counter not yet increased (V-Int pending) --> fix
+    if (((s32) (time - lastTime) < 0) && ((lastTime - time) > ((u32) lpf << 7)))
+        return time + ((u32) lpf << 8);
+
+    return time;
+}
+
+
+u16 PROF_startSampling(u16 numSample, u16 depth, u16 hintRate)
+{
+    PROF_releaseSamples();
+
+    if (depth > PROF_MAX_SAMPLE_DEPTH) depth = PROF_MAX_SAMPLE_DEPTH;
+    if (numSample == 0) return FALSE;
+
+    sampleBuffer = MEM_alloc(numSample * (depth + 1) * sizeof(u32));
+    if (sampleBuffer == NULL)
+    {
+#if (LIB_DEBUG != 0)
+        KLog("PROF_startSampling failed: not enough memory !");
+#endif
+
+        return FALSE;
+    }
+
+    sampleBufferEnd = sampleBuffer + (numSample * (depth + 1));
+    sampleWrite = sampleBuffer;
+    sampleDepth = depth;
+    sampleMax = numSample;
+    sampleNum = 0;
+
+    SYS_disableInts();
+
+    // install sampling handlers in front of internal callbacks
+    profVIntCB = internalVIntCB;
+    internalVIntCB = _prof_vint_sampler;
+
+    samplingHInt = hintRate?TRUE:FALSE;
+    if (samplingHInt)
+    {
+        prevHIntEnabled = (VDP_getReg(0x00) & 0x10)?TRUE:FALSE;
+        profHIntCB = internalHIntCB;
+        internalHIntCB = _prof_hint_sampler;
+        VDP_setHIntCounter(hintRate - 1);
+        VDP_setHInterrupt(1);
+    }
+
+    sampling = TRUE;
+
+    SYS_enableInts();
+
+    return TRUE;
+}
+
+void PROF_stopSampling()
+{
+    if (!sampling) return;
+
+    SYS_disableInts();
+
+    internalVIntCB = profVIntCB;
+    if (samplingHInt)
+    {
+        internalHIntCB = profHIntCB;
+        if (!prevHIntEnabled) VDP_setHInterrupt(0);
+    }
+
+    sampling = FALSE;
+
+    SYS_enableInts();
+}
+
+void PROF_releaseSamples()
+{
+    PROF_stopSampling();
+
+    if (sampleBuffer) MEM_free(sampleBuffer);
+    sampleBuffer = NULL;
+    sampleNum = 0;
+}
+
+u16 PROF_getNumSample()
+{
+    return sampleNum;
+}
+
+void PROF_dumpSamples()
+{
+    char str[8 + (PROF_MAX_SAMPLE_DEPTH + 1) * 9];
+    u32 *src;
+    u16 i;
+
+    KLog_U2("PSMP depth=", sampleDepth, " count=", sampleNum);
+
+    // oldest sample first
+    src = sampleWrite - (sampleNum * (sampleDepth + 1));
+    if (src < sampleBuffer) src += sampleBufferEnd - sampleBuffer;
+
+    i = sampleNum;
+    while(i--)
+    {
+        char *dst = str;
+        u16 j;
+
+        strcpy(dst, "PS:");
+        dst += 3;
+
+        j = sampleDepth + 1;
+        while(j--)
+        {
+            *dst++ = ' ';
+            intToHex(*src++, dst, 8);
+            dst += 8;
+        }
+
+        KLog(str);
+
+        if (src >= sampleBufferEnd) src = sampleBuffer;
+    }
+}
+
+u32 PROF_saveSamples(u32 offset)
+{
+    u32 *src;
+    u32 addr;
+    u16 i;
+
+    SRAM_enable();
+
+    addr = offset;
+    SRAM_writeLong(addr, SAMPLE_MAGIC);
+    SRAM_writeWord(addr + 4, SAMPLE_VERSION);
+    SRAM_writeWord(addr + 6, sampleDepth);
+    SRAM_writeWord(addr + 8, sampleNum);
+    SRAM_writeWord(addr + 10, 0);
+    addr += SAMPLE_HEADER_SIZE;
+
+    // oldest sample first
+    src = sampleWrite - (sampleNum * (sampleDepth + 1));
+    if (src < sampleBuffer) src += sampleBufferEnd - sampleBuffer;
+
+    i = sampleNum * (sampleDepth + 1);
+    while(i--)
+    {
+        SRAM_writeLong(addr, *src++);
+        addr += 4;
+        if (src >= sampleBufferEnd) src = sampleBuffer;
+    }
+
+    SRAM_disable();
+
+    return addr - offset;
+}
+
+// called by sampling handlers (interrupts are masked), frame points on the interrupted PC in the exception frame
+void PROF_doSample(u16 *frame)
+{
+    const u32 romEnd = (u32) &_etext;
+    u32 *dst;
+    u16 *p;
+    u16 *end;
+    u16 n;
+
+    dst = sampleWrite;
+
+    // interrupted PC
+    *dst++ = *(u32*) frame;
+
+    // scan interrupted code stack for values which look like return addresses
+    p = frame + 2;
+    end = p + PROF_SAMPLE_SCAN;
+    if ((u32) end > SAMPLE_RAM_END) end = (u16*) SAMPLE_RAM_END;
+
+    n = sampleDepth;
+    while(n && (p < end))
+    {
+        const u32 v = *(u32*) p;
+
+        if (!(v & 1) && (v >= SAMPLE_ROM_START) && (v < romEnd))
+        {
+            *dst++ = v;
+            n--;
+            p += 2;
+        }
+        else p++;
+    }
+    // clear remaining
+    while(n--) *dst++ = 0;
+
+    if (dst >= sampleBufferEnd) dst = sampleBuffer;
+    sampleWrite = dst;
+    if (sampleNum < sampleMax) sampleNum++;
+}
+
+
+#if (ENABLE_PROFILER != 0)
+
+typedef struct
+{
+    const char *name;
+    u16 parent;
+    u16 depth;
+    u16 calls;
+    u16 lastCalls;
+    u16 numFrame;
+    u32 frame;
+    u32 time;
+    u32 min;
+    u32 max;
+    u32 total;
+} ProfZone;
+
+
+static ProfZone zones[PROF_MAX_ZONE];
+static u16 numZone = 0;
+
+// zone stack (a slot is reserved before being written so it's safe to use profiling from interrupts)
+static u16 stackZone[PROF_MAX_DEPTH];
+static u32 stackTime[PROF_MAX_DEPTH];
+static vu16 depth = 0;
+
+
+static void resetZone(ProfZone *zone);
+static void commitFrame(ProfZone *zone);
+static void buildLine(char *str, ProfZone *zone);
+static void drawZones(u16 parent, u16 x, u16 *y);
+static void dumpZones(u16 parent);
+
+
+void PROF_reset()
+{
+    u16 i;
+
+    for(i = 0; i < numZone; i++)
+        resetZone(&zones[i]);
+}
+
+u16 PROF_getZone(const char *name)
+{
+    ProfZone *zone;
+    u16 i;
+
+    for(i = 0; i < numZone; i++)
+        if (!strcmp(zones[i].name, name)) return i + 1;
+
+    if (numZone >= PROF_MAX_ZONE)
+    {
+#if (LIB_DEBUG != 0)
+        KLog("PROF_getZone failed: no more free zone !");
+#endif
+
+        return 0;
+    }
+
+    zone = &zones[numZone++];
+    zone->name = name;
+    // set on first PROF_beginZone(..)
+    zone->depth = 0xFFFF;
+    zone->parent = 0;
+    resetZone(zone);
+
+    return numZone;
+}
+
+void PROF_beginZone(u16 id)
+{
+    // reserve stack slot first
+    const u16 d = depth++;
+
+    if (d >= PROF_MAX_DEPTH) return;
+
+    stackZone[d] = id;
+
+    if (id)
+    {
+        ProfZone *zone = &zones[id - 1];
+
+        // first time --> store hierarchy
+        if (zone->depth == 0xFFFF)
+        {
+            zone->parent = d?stackZone[d - 1]:0;
+            zone->depth = d;
+        }
+    }
+
+    // get time last so we don't measure our own overhead
+    stackTime[d] = PROF_getTime();
+}
+
+void PROF_endZone()
+{
+    const u32 now = PROF_getTime();
+    const u16 d = depth - 1;
+
+    // unbalanced PROF_end() ?
+    if (depth == 0) return;
+
+    if (d < PROF_MAX_DEPTH)
+    {
+        const u16 id = stackZone[d];
+
+        if (id)
+        {
+            ProfZone *zone = &zones[id - 1];
+            const u32 f = vtimer;
+
+            // new frame --> commit previous frame statistics
+            if (zone->frame != f)
+            {
+                commitFrame(zone);
+                zone->frame = f;
+            }
+
+            zone->time += now - stackTime[d];
+            zone->calls++;
+        }
+    }
+
+    // release stack slot last
+    depth = d;
+}
+
+u16 PROF_getZoneStats(u16 id, u32 *min, u32 *avg, u32 *max)
+{
+    ProfZone *zone;
+
+    if ((id == 0) || (id > numZone))
+    {
+        *min = 0;
+        *avg = 0;
+        *max = 0;
+
+        return 0;
+    }
+
+    zone = &zones[id - 1];
+    // last frame is complete ?
+    if (zone->frame != vtimer) commitFrame(zone);
+
+    if (zone->numFrame)
+    {
+        *min = PROF_timeToCycles(zone->min);
+        *avg = PROF_timeToCycles(zone->total / zone->numFrame);
+        *max = PROF_timeToCycles(zone->max);
+    }
+    else
+    {
+        *min = 0;
+        *avg = 0;
+        *max = 0;
+    }
+
+    return zone->lastCalls;
+}
+
+void PROF_dump()
+{
+    KLog("Profiler (68000 cycles per frame) -----------");
+    KLog(HEADER);
+    dumpZones(0);
+}
+
+void PROF_draw(u16 x, u16 y)
+{
+    u16 cy = y;
+
+    VDP_drawText(HEADER, x, cy++);
+    drawZones(0, x, &cy);
+}
+
+
+static void resetZone(ProfZone *zone)
+{
+    zone->calls = 0;
+    zone->lastCalls = 0;
+    zone->numFrame = 0;
+    zone->frame = vtimer;
+    zone->time = 0;
+    zone->min = 0xFFFFFFFF;
+    zone->max = 0;
+    zone->total = 0;
+}
+
+static void commitFrame(ProfZone *zone)
+{
+    const u32 t = zone->time;
+
+    // zone not entered during this frame
+    if (zone->calls == 0) return;
+
+    if (t < zone->min) zone->min = t;
+    if (t > zone->max) zone->max = t;
+    zone->total += t;
+    // keep a sliding average
+    if (++zone->numFrame >= PROF_AVG_FRAME)
+    {
+        zone->total >>= 1;
+        zone->numFrame >>= 1;
+    }
+
+    zone->lastCalls = zone->calls;
+    zone->calls = 0;
+    zone->time = 0;
+}
+
+static char* appendNum(char *dst, u32 value, u16 width)
+{
+    char tmp[12];
+    u16 len;
+
+    len = uintToStr(value, tmp, 1);
+    while(width-- > len) *dst++ = ' ';
+    strcpy(dst, tmp);
+
+    return dst + len;
+}
+
+static void buildLine(char *str, ProfZone *zone)
+{
+    const char *name = zone->name;
+    char *dst = str;
+    u32 min, avg, max;
+    u16 calls;
+    u16 i;
+
+    calls = PROF_getZoneStats((zone - zones) + 1, &min, &avg, &max);
+
+    // indented name (truncated to 13 characters)
+    i = zone->depth;
+    if (i > 6) i = 6;
+    while(i--) *dst++ = ' ';
+    while(*name && ((dst - str) < 13)) *dst++ = *name++;
+    while((dst - str) < 13) *dst++ = ' ';
+
+    dst = appendNum(dst, calls, 5);
+    dst = appendNum(dst, min, 7);
+    dst = appendNum(dst, avg, 7);
+    appendNum(dst, max, 7);
+}
+
+static void drawZones(u16 parent, u16 x, u16 *y)
+{
+    char str[48];
+    u16 i;
+
+    for(i = 0; i < numZone; i++)
+    {
+        ProfZone *zone = &zones[i];
+
+        // only zones already entered
+        if ((zone->depth == 0xFFFF) || (zone->parent != parent)) continue;
+
+        buildLine(str, zone);
+        VDP_drawText(str, x, (*y)++);
+        // then its children
+        drawZones(i + 1, x, y);
+    }
+}
+
+static void dumpZones(u16 parent)
+{
+    char str[48];
+    u16 i;
+
+    for(i = 0; i < numZone; i++)
+    {
+        ProfZone *zone = &zones[i];
+
+        if ((zone->depth == 0xFFFF) || (zone->parent != parent)) continue;
+
+        buildLine(str, zone);
+        KLog(str);
+        dumpZones(i + 1);
+    }
+}
+
+#else
+
+void PROF_reset()
+{
+
+}
+
+u16 PROF_getZone(const char *name)
+{
+    return 0;
+}
+
+void PROF_beginZone(u16 id)
+{
+
+}
+
+void PROF_endZone()
+{
+
+}
+
+u16 PROF_getZoneStats(u16 id, u32 *min, u32 *avg, u32 *max)
+{
+    *min = 0;
+    *avg = 0;
+    *max = 0;
+
+    return 0;
+}
+
+void PROF_dump()
+{
+    KLog("Profiler disabled (set ENABLE_PROFILER to 1 in config.h)");
+}
+
+void PROF_draw(u16 x, u16 y)
+{
+    VDP_drawText("Profiler disabled", x, y);
+}
+
+#endif // ENABLE_PROFILER
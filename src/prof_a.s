@@ -0,0 +1,34 @@
+| Sampling profiler handlers, installed in front of internalVIntCB / internalHIntCB by PROF_startSampling(..)
+| On entry (called from _VINT / _HINT in sega.s):
+|   0(%sp)  = return address in _VINT / _HINT
+|   4(%sp)  = saved d0-d1/a0-a1
+|   20(%sp) = SR of interrupted code
+|   22(%sp) = PC of interrupted code
+
+    .align  2
+    .globl  _prof_vint_sampler
+    .type   _prof_vint_sampler, @function
+_prof_vint_sampler:
+    pea     22(%sp)                         | pointer on interrupted PC
+    jsr     PROF_doSample
+    addq.l  #4,%sp
+
+    move.l  profVIntCB,%a0                  | then do normal V-Int process
+    jmp     (%a0)
+
+
+    .align  2
+    .globl  _prof_hint_sampler
+    .type   _prof_hint_sampler, @function
+_prof_hint_sampler:
+    move.w  %sr,-(%sp)                      | V-Int can interrupt H-Int so mask it while we write the sample
+    ori.w   #0x0700,%sr
+
+    pea     24(%sp)                         | pointer on interrupted PC (SR saved on stack)
+    jsr     PROF_doSample
+    addq.l  #4,%sp
+
+    move.w  (%sp)+,%sr
+
+    move.l  profHIntCB,%a0                  | then do normal H-Int process
+    jmp     (%a0)
@@ -14,6 +14,9 @@
 #include "sys.h"
 #include "xgm.h"
 
+// BUS requests from this unit are identified in Z80 BUS statistics
+#define Z80_requestBus(wait)    Z80_requestBusEx(wait, Z80_BUS_SOUND)
+
 
 // Z80_DRIVER_PCM
 // single channel 8 bits signed sample driver
@@ -14,6 +14,7 @@
 #include "kdebug.h"
 #include "string.h"
 #include "timer.h"
+#include "prof.h"
 
 
 //#define SPR_DEBUG
@@ -30,6 +31,8 @@
 #define VISIBILITY_OFF                      0x0000
 
 #define ALLOCATED                           0x8000
+// sprite set as static (see SPR_setStatic(..))
+#define STATIC                              0x4000
 
 #define NEED_ST_ATTR_UPDATE                 0x0001
 #define NEED_ST_POS_UPDATE                  0x0002
@@ -40,7 +43,69 @@
 #define NEED_FRAME_UPDATE                   0x0020
 #define NEED_TILES_UPLOAD                   0x0040
 
-#define NEED_UPDATE                         0x00FF
+#define NEED_UPDATE                         0x007F
+
+// static sprite currently out of the update list
+#define SLEEPING                            0x0080
+
+// maximum number of DMA operation used to send the VDP sprite table
+#define SPR_TABLE_MAX_RANGE                 4
+// modified VDP sprites separated by less than this number of VDP sprite are sent in the same DMA operation
+#define SPR_TABLE_RANGE_GAP                 4
+
+// collision broadphase grid: 32x32 pixels cells covering the screen area plus a 32 pixels border
+// (sprite positions are stored with a 0x80 offset)
+#define COL_CELL_SHIFT                      5
+#define COL_GRID_X                          (0x80 - 32)
+#define COL_GRID_Y                          (0x80 - 32)
+#define COL_GRID_W                          12
+#define COL_GRID_H                          10
+#define COL_GRID_SIZE                       (COL_GRID_W * COL_GRID_H)
+// sprite covering more cells than this are not stored in the grid but tested against all others
+#define COL_MAX_CELL                        4
+// default maximum number of reported collision pair
+#define COL_DEFAULT_MAX_PAIR                64
+
+// sprite multiplexing: maximum number of scanline (PAL V30 mode)
+#define MPLX_MAX_LINE                       240
+
+// incremental VRAM defragmentation: maximum number of candidate block examined per frame
+#define DEFRAG_MAX_TRY                      8
+
+// shared VRAM frame: no entry
+#define SHARED_FRAME_NONE                   0xFFFF
+
+
+// collision broadphase entry (bounding box of sprite collision shape, 0x80 offset, x1/y1 excluded)
+typedef struct
+{
+    Sprite *sprite;
+    u16 type;
+    u16 large;
+    s16 x0;
+    s16 y0;
+    s16 x1;
+    s16 y1;
+} CollisionEntry;
+
+// collision grid cell node
+typedef struct _collisionNode
+{
+    CollisionEntry *entry;
+    struct _collisionNode *next;
+} CollisionNode;
+
+
+// shared VRAM frame (SPR_FLAG_SHARED_VRAM_ALLOC), tileset = NULL for a free entry
+typedef struct
+{
+    const TileSet *tileset;
+    u16 index;
+    u16 newIndex;
+    u16 refCount;
+    u16 upload;
+    u16 next;       // next entry in the same tileset hash bucket (or in free list)
+} SharedFrame;
 
 
 // shared from vdp_spr.c unit
@@ -62,11 +127,31 @@ static void updateSpriteTableAll(Sprite *sprite);
 static void updateSpriteTablePos(Sprite *sprite);
 static void updateSpriteTableAttr(Sprite *sprite);
 static void loadTiles(Sprite *sprite);
+static u16 sendSpriteTable(u16 num);
+static u16 queueSpriteTable(u16 start, u16 end);
 static Sprite* sortSprite(Sprite* sprite);
 static void moveAfter(Sprite* pos, Sprite* sprite);
 static u16 getSpriteIndex(Sprite *sprite);
 static void logSprite(Sprite *sprite);
 
+static u16 getCollisionEntry(Sprite *sprite, CollisionEntry *entry);
+static u16 testCollisionEntries(const CollisionEntry *entry1, const CollisionEntry *entry2);
+static void updateCollision();
+
+static void resetSharedFrames();
+static u16 getSharedFrameBucket(const TileSet *tileset);
+static u16 acquireSharedFrame(const TileSet *tileset);
+static void releaseSharedFrame(u16 shared);
+
+static void addToUpdateList(Sprite *sprite);
+static void removeFromUpdateList(Sprite *sprite);
+static void wakeSprite(Sprite *sprite);
+
+static void multiplexSprites();
+static void relinkSprites();
+
+static void defragStep(u16 budget);
+
 // starter VDP sprite - never visible (used for sprite sorting)
 static VDPSprite *starter;
 
@@ -85,11 +170,57 @@ Sprite *firstSprite;
 Sprite *lastSprite;
 // number of active sprite
 u16 spriteNum;
+// list of sprites processed by SPR_update() (idle static sprites leave it)
+static Sprite *firstUpdate;
+// number of sprite in the update list
+static u16 updateNum;
 
 static u8 *unpackBuffer;
 static u8 *unpackNext;
+// sprites waiting for tiles upload (done after sprite table is queued)
+static Sprite **uploadList;
 static VRAMRegion vram;
 
+// force complete VDP sprite table transfer on next SPR_update()
+static u16 spriteTableFullUpdate;
+// size (in bytes) of VDP sprite table sent by last SPR_update()
+static u16 spriteTableTransferSize;
+
+// collision broadphase data (NULL when collision engine is not initialized)
+static CollisionEntry *colEntries = NULL;
+static CollisionEntry **colLargeEntries;
+static CollisionNode *colNodes;
+static CollisionNode *colCells[COL_GRID_SIZE];
+static SpriteCollisionPair *colPairs;
+static u16 colMaxPair;
+static u16 colNumPair;
+
+// shared VRAM frames (spritesBankSize + 1 entries as a sprite acquires its new frame before releasing the previous one)
+static SharedFrame *sharedFrames;
+// first entry of each tileset hash bucket (power of 2 number of bucket)
+static u16 *sharedBuckets;
+static u16 sharedBucketMask;
+// first free entry
+static u16 sharedFree;
+
+// sprite multiplexing data (NULL when multiplexing is not initialized)
+static u8 *mplxSpriteLoad;
+static u16 *mplxPixelLoad;
+static u8 *mplxOverflow;
+static Sprite **mplxSprites;
+static u16 mplxNumOverflow;
+static u16 mplxRotation;
+static u16 mplxRelinked;
+
+// incremental VRAM defragmentation: byte budget per frame (0 = disabled)
+static u16 defragBudget;
+// only blocks located below this tile index are candidates for the next move
+static u16 defragLimit;
+// previous location of moved blocks, released once the VRAM copy operations are done (defragOp)
+static u16 defragFree[DEFRAG_MAX_TRY];
+static u16 defragNumFree;
+static u16 defragOp;
+
 
 #ifdef SPR_PROFIL
 
@@ -113,8 +244,10 @@ static VRAMRegion vram;
 #define PROFIL_LOADTILES                17
 #define PROFIL_SORT                     18
 #define PROFIL_VRAM_DEFRAG              19
+#define PROFIL_COLLISION                20
+#define PROFIL_MULTIPLEX                21
 
-static u32 profil_time[20];
+static u32 profil_time[22];
 #endif
 
 
@@ -123,6 +256,7 @@ void SPR_init(u16 maxSprite, u16 cacheSize, u16 unpackBufferSize)
     u16 adjMax;
     u16 index;
     u16 size;
+    u16 numBucket;
 
     // already initialized --> end it first
     if (SPR_isInitialized()) SPR_end();
@@ -135,15 +269,27 @@ void SPR_init(u16 maxSprite, u16 cacheSize, u16 unpackBufferSize)
     spritesBankSize = adjMax;
     // allocation stack
     allocStack = MEM_alloc(adjMax * sizeof(Sprite*));
+    // tiles upload list
+    uploadList = MEM_alloc(adjMax * sizeof(Sprite*));
     // alloc sprite tile unpack buffer
     unpackBuffer = MEM_alloc(((unpackBufferSize?unpackBufferSize:256) * 32) + 1024);
+    // shared VRAM frames followed by tileset hash buckets
+    numBucket = 16;
+    while(numBucket < (adjMax + 1)) numBucket <<= 1;
+    sharedFrames = MEM_alloc(((adjMax + 1) * sizeof(SharedFrame)) + (numBucket * sizeof(u16)));
+    sharedBuckets = (u16*) &sharedFrames[adjMax + 1];
+    sharedBucketMask = numBucket - 1;
 
     size = cacheSize?cacheSize:384;
     // get start tile index for sprite cache (reserve VRAM area just before system font)
     index = TILE_FONTINDEX - size;
 
     // and create a VRAM region for sprite tile allocation
+#if (SPR_FAST_VRAM_ALLOC != 0)
+    VRAM_createRegionEx(&vram, index, size, VRAM_ALLOC_SEGREGATED);
+#else
     VRAM_createRegion(&vram, index, size);
+#endif
 
 #if (LIB_DEBUG != 0)
     KLog("Sprite engine initialized !");
@@ -170,10 +316,18 @@ void SPR_end()
         spritesBankSize = 0;
         MEM_free(allocStack);
         allocStack = NULL;
+        MEM_free(uploadList);
+        uploadList = NULL;
         MEM_free(unpackBuffer);
         unpackBuffer = NULL;
+        MEM_free(sharedFrames);
+        sharedFrames = NULL;
 
         VRAM_releaseRegion(&vram);
+
+        // end collision engine and multiplexing as they depend from sprites bank size
+        SPR_endCollision();
+        SPR_endMultiplexing();
     }
 
 #if (LIB_DEBUG != 0)
@@ -202,13 +356,20 @@ void SPR_reset()
     // no active sprites
     firstSprite = NULL;
     lastSprite = NULL;
+    firstUpdate = NULL;
     // reset current number of active sprite
     spriteNum = 0;
+    updateNum = 0;
     // reset unpack pointer
     unpackNext = unpackBuffer;
 
     // clear VRAM region
     VRAM_clearRegion(&vram);
+    // and shared VRAM frames
+    resetSharedFrames();
+    // restart incremental defragmentation from top of VRAM region
+    defragLimit = 0xFFFF;
+    defragNumFree = 0;
     // reset VDP sprite (allocation and display)
     VDP_resetSprites();
 
@@ -217,6 +378,12 @@ void SPR_reset()
     // hide it
     starter->y = 0;
 
+    // VRAM sprite table content is unknown
+    spriteTableFullUpdate = TRUE;
+    spriteTableTransferSize = 0;
+    // collision pairs refer released sprites
+    colNumPair = 0;
+
 #ifdef SPR_PROFIL
     memset(profil_time, 0, sizeof(profil_time));
 #endif // SPR_PROFIL
@@ -257,6 +424,8 @@ static Sprite* allocateSprite()
     // update first and last sprite
     if (firstSprite == NULL) firstSprite = result;
     lastSprite = result;
+    // new sprite need to be processed
+    addToUpdateList(result);
 
     // update sprite number
     spriteNum++;
@@ -316,6 +485,9 @@ static u16 releaseSprite(Sprite* sprite)
             lastSprite = prev;
         }
 
+        // remove it from update list
+        if (!(sprite->status & SLEEPING)) removeFromUpdateList(sprite);
+
         // decrement number of sprite
         spriteNum--;
 
@@ -365,6 +537,8 @@ Sprite* SPR_addSpriteEx(const SpriteDefinition *spriteDef, s16 x, s16 y, u16 att
     }
 
     sprite->status = ALLOCATED | (flags & SPR_FLAGS_MASK);
+    // shared VRAM allocation replaces the per sprite VRAM allocation
+    if (flags & SPR_FLAG_SHARED_VRAM_ALLOC) sprite->status &= ~SPR_FLAG_AUTO_VRAM_ALLOC;
 
 #ifdef SPR_DEBUG
     KLog_U2("SPR_addSpriteEx: added sprite #", getSpriteIndex(sprite), " - internal position = ", sprite - spritesBank);
@@ -385,6 +559,10 @@ Sprite* SPR_addSpriteEx(const SpriteDefinition *spriteDef, s16 x, s16 y, u16 att
     // sprite is always added at the end of list so we use MAX_DEPTH here
     sprite->depth = SPR_MAX_DEPTH;
     sprite->frameNumSprite = 0;
+    // collide with everything by default
+    sprite->collisionGroup = 1;
+    sprite->collisionMask = 0xFFFF;
+    sprite->sharedFrame = SHARED_FRAME_NONE;
 
     numVDPSprite = spriteDef->maxNumSprite;
 
@@ -419,7 +597,7 @@ Sprite* SPR_addSpriteEx(const SpriteDefinition *spriteDef, s16 x, s16 y, u16 att
     setVDPSpriteIndex(sprite, ind, numVDPSprite, lastVDPSprite);
 
     // auto VRAM alloc enabled ?
-    if (flags & SPR_FLAG_AUTO_VRAM_ALLOC)
+    if (sprite->status & SPR_FLAG_AUTO_VRAM_ALLOC)
     {
         // allocate VRAM
         ind = VRAM_alloc(&vram, spriteDef->maxNumTile);
@@ -441,6 +619,8 @@ Sprite* SPR_addSpriteEx(const SpriteDefinition *spriteDef, s16 x, s16 y, u16 att
         KLog_U3("  allocated ", spriteDef->maxNumTile, " tiles in VRAM at ", ind, ", remaining VRAM: ", VRAM_getFree(&vram));
 #endif // SPR_DEBUG
     }
+    // shared VRAM alloc --> VRAM is allocated on frame update
+    else if (flags & SPR_FLAG_SHARED_VRAM_ALLOC) sprite->attribut = attribut & TILE_ATTR_MASK;
     // just use the given attribut
     else sprite->attribut = attribut;
 
@@ -500,6 +680,12 @@ void SPR_releaseSprite(Sprite *sprite)
         KLog_U3("  released ", sprite->definition->maxNumTile, " tiles in VRAM at ", sprite->attribut & TILE_INDEX_MASK, ", remaining VRAM: ", VRAM_getFree(&vram));
 #endif // SPR_DEBUG
     }
+    // shared VRAM alloc enabled --> release reference on current frame VRAM area
+    if (status & SPR_FLAG_SHARED_VRAM_ALLOC)
+    {
+        releaseSharedFrame(sprite->sharedFrame);
+        sprite->sharedFrame = SHARED_FRAME_NONE;
+    }
 
 #ifdef SPR_PROFIL
     profil_time[PROFIL_REMOVE_SPRITE] += getSubTick() - prof;
@@ -511,6 +697,21 @@ u16 SPR_getNumActiveSprite()
     return spriteNum;
 }
 
+u16 SPR_getNumUpdatedSprite()
+{
+    return updateNum;
+}
+
+void SPR_setDefragBudget(u16 value)
+{
+    defragBudget = value;
+}
+
+u16 SPR_getDefragBudget()
+{
+    return defragBudget;
+}
+
 void SPR_defragVRAM()
 {
 #ifdef SPR_PROFIL
@@ -518,9 +719,28 @@ void SPR_defragVRAM()
 #endif // SPR_PROFIL
 
     Sprite* sprite;
+    SharedFrame *entry;
+    u16 i;
 
     // release all VRAM region
     VRAM_clearRegion(&vram);
+    // pending release of moved blocks is no longer needed
+    defragNumFree = 0;
+
+    // re-allocate shared frames first (can't fail here)
+    entry = sharedFrames;
+    i = spritesBankSize + 1;
+    while(i--)
+    {
+        if (entry->tileset)
+        {
+            entry->newIndex = VRAM_alloc(&vram, entry->tileset->numTile);
+            // moved --> need to re upload tiles
+            if (entry->newIndex != entry->index) entry->upload = TRUE;
+        }
+
+        entry++;
+    }
 
     // iterate over all sprites to re-allocate auto allocated VRAM
     sprite = firstSprite;
@@ -548,6 +768,29 @@ void SPR_defragVRAM()
                     status |= NEED_TILES_UPLOAD;
 
                 sprite->status = status;
+                if (status & SLEEPING) wakeSprite(sprite);
+            }
+        }
+        // sprite is using shared VRAM allocation ?
+        else if (status & SPR_FLAG_SHARED_VRAM_ALLOC)
+        {
+            const u16 attr = sprite->attribut;
+            const u16 shared = sprite->sharedFrame;
+
+            // entry still refers the previous VRAM index here
+            entry = (shared != SHARED_FRAME_NONE)?&sharedFrames[shared]:NULL;
+
+            if (entry && (entry->newIndex != entry->index))
+            {
+                sprite->attribut = entry->newIndex | (attr & TILE_ATTR_MASK);
+
+                // need to update attribute VDP sprite table and re upload tiles
+                status |= NEED_ST_ATTR_UPDATE;
+                if (status & SPR_FLAG_AUTO_TILE_UPLOAD)
+                    status |= NEED_TILES_UPLOAD;
+
+                sprite->status = status;
+                if (status & SLEEPING) wakeSprite(sprite);
             }
         }
 
@@ -555,6 +798,15 @@ void SPR_defragVRAM()
         sprite = sprite->next;
     }
 
+    // all sprites updated, we can now set the new shared frames position
+    entry = sharedFrames;
+    i = spritesBankSize + 1;
+    while(i--)
+    {
+        if (entry->tileset) entry->index = entry->newIndex;
+        entry++;
+    }
+
 #ifdef SPR_PROFIL
     profil_time[PROFIL_VRAM_DEFRAG] += getSubTick() - prof;
 #endif // SPR_PROFIL
@@ -566,6 +818,8 @@ u16 SPR_setDefinition(Sprite *sprite, const SpriteDefinition *spriteDef)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
 #ifdef SPR_DEBUG
     KLog_U1("SPR_setDefinition: #", getSpriteIndex(sprite));
 #endif // SPR_DEBUG
@@ -644,6 +898,8 @@ void SPR_setPosition(Sprite *sprite, s16 x, s16 y)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     const s16 newx = x + 0x80;
     const s16 newy = y + 0x80;
 
@@ -676,6 +932,8 @@ void SPR_setHFlip(Sprite *sprite, u16 value)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     const u16 oldAttribut = sprite->attribut;
 
     if (oldAttribut & TILE_ATTR_HFLIP_MASK)
@@ -730,6 +988,8 @@ void SPR_setVFlip(Sprite *sprite, u16 value)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     const u16 oldAttribut = sprite->attribut;
 
     if (oldAttribut & TILE_ATTR_VFLIP_MASK)
@@ -784,6 +1044,8 @@ void SPR_setPriorityAttribut(Sprite *sprite, u16 value)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     const u16 oldAttribut = sprite->attribut;
 
     if (oldAttribut & TILE_ATTR_PRIORITY_MASK)
@@ -824,6 +1086,8 @@ void SPR_setPalette(Sprite *sprite, u16 value)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     const u16 oldAttribut = sprite->attribut;
     const u16 newAttribut = (oldAttribut & (~TILE_ATTR_PALETTE_MASK)) | (value << TILE_ATTR_PALETTE_SFT);
 
@@ -882,6 +1146,8 @@ void SPR_setAnimAndFrame(Sprite *sprite, s16 anim, s16 frame)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     if ((sprite->animInd != anim) || (sprite->seqInd != frame))
     {
         Animation *animation = sprite->definition->animations[anim];
@@ -914,6 +1180,8 @@ void SPR_setAnim(Sprite *sprite, s16 anim)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     if (sprite->animInd != anim)
     {
         Animation *animation = sprite->definition->animations[anim];
@@ -947,6 +1215,8 @@ void SPR_setFrame(Sprite *sprite, s16 frame)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     if (sprite->seqInd != frame)
     {
         const Animation *animation = sprite->animation;
@@ -981,6 +1251,8 @@ void SPR_nextFrame(Sprite *sprite)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     const Animation *anim = sprite->animation;
     u16 seqInd = sprite->seqInd + 1;
 
@@ -1001,11 +1273,33 @@ u16 SPR_setVRAMTileIndex(Sprite *sprite, s16 value)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     s16 newInd;
     u16 status = sprite->status;
     u16 oldAttribut = sprite->attribut;
 
-    if (status & SPR_FLAG_AUTO_VRAM_ALLOC)
+    if (status & SPR_FLAG_SHARED_VRAM_ALLOC)
+    {
+        // keep shared allocation --> just return TRUE
+        if (value == -1)
+        {
+#ifdef SPR_PROFIL
+            profil_time[PROFIL_SET_VRAM_OR_SPRIND] += getSubTick() - prof;
+#endif // SPR_PROFIL
+
+            return TRUE;
+        }
+
+        // pass to manual allocation
+        status &= ~SPR_FLAG_SHARED_VRAM_ALLOC;
+        // release current shared frame first
+        releaseSharedFrame(sprite->sharedFrame);
+        sprite->sharedFrame = SHARED_FRAME_NONE;
+        // set fixed VRAM index
+        newInd = value;
+    }
+    else if (status & SPR_FLAG_AUTO_VRAM_ALLOC)
     {
         // pass to manual allocation
         if (value != -1)
@@ -1091,6 +1385,8 @@ u16 SPR_setSpriteTableIndex(Sprite *sprite, s16 value)
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     s16 newInd;
     u16 status = sprite->status;
     u16 num = sprite->definition->maxNumSprite;
@@ -1183,12 +1479,24 @@ void SPR_setAutoTileUpload(Sprite *sprite, u16 value)
     else sprite->status &= ~SPR_FLAG_AUTO_TILE_UPLOAD;
 }
 
+void SPR_setStatic(Sprite *sprite, u16 value)
+{
+    if (value) sprite->status |= STATIC;
+    else
+    {
+        if (sprite->status & SLEEPING) wakeSprite(sprite);
+        sprite->status &= ~STATIC;
+    }
+}
+
 void SPR_setVisibility(Sprite *sprite, SpriteVisibility value)
 {
 #ifdef SPR_PROFIL
     s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
+    if (sprite->status & SLEEPING) wakeSprite(sprite);
+
     u16 status = sprite->status;
 
     if (status & SPR_FLAG_AUTO_VISIBILITY)
@@ -1273,6 +1581,152 @@ u16 SPR_computeVisibility(Sprite *sprite)
 }
 
 
+u16 SPR_initCollision(u16 maxPair)
+{
+    // already initialized --> end it first
+    if (SPR_isCollisionInitialized()) SPR_endCollision();
+
+    colMaxPair = maxPair?maxPair:COL_DEFAULT_MAX_PAIR;
+    colNumPair = 0;
+
+    colEntries = MEM_alloc(spritesBankSize * sizeof(CollisionEntry));
+    colLargeEntries = MEM_alloc(spritesBankSize * sizeof(CollisionEntry*));
+    colNodes = MEM_alloc(spritesBankSize * COL_MAX_CELL * sizeof(CollisionNode));
+    colPairs = MEM_alloc(colMaxPair * sizeof(SpriteCollisionPair));
+
+    // not enough memory ?
+    if (!colEntries || !colLargeEntries || !colNodes || !colPairs)
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("SPR_initCollision failed: not enough memory !");
+#endif // LIB_DEBUG
+
+        // release what we got
+        MEM_free(colEntries);
+        colEntries = NULL;
+        MEM_free(colLargeEntries);
+        colLargeEntries = NULL;
+        MEM_free(colNodes);
+        colNodes = NULL;
+        MEM_free(colPairs);
+        colPairs = NULL;
+        colMaxPair = 0;
+
+        return FALSE;
+    }
+
+#if (LIB_DEBUG != 0)
+    KLog_U1("Sprite collision engine initialized - max pairs: ", colMaxPair);
+#endif // LIB_DEBUG
+
+    return TRUE;
+}
+
+void SPR_endCollision()
+{
+    if (SPR_isCollisionInitialized())
+    {
+        MEM_free(colEntries);
+        colEntries = NULL;
+        MEM_free(colLargeEntries);
+        colLargeEntries = NULL;
+        MEM_free(colNodes);
+        colNodes = NULL;
+        MEM_free(colPairs);
+        colPairs = NULL;
+        colMaxPair = 0;
+        colNumPair = 0;
+    }
+}
+
+u16 SPR_isCollisionInitialized()
+{
+    return (colEntries != NULL);
+}
+
+void SPR_setCollisionFilter(Sprite *sprite, u16 group, u16 mask)
+{
+    sprite->collisionGroup = group;
+    sprite->collisionMask = mask;
+}
+
+u16 SPR_testCollision(Sprite *sprite1, Sprite *sprite2)
+{
+    CollisionEntry entry1;
+    CollisionEntry entry2;
+
+    if (!getCollisionEntry(sprite1, &entry1)) return FALSE;
+    if (!getCollisionEntry(sprite2, &entry2)) return FALSE;
+
+    return testCollisionEntries(&entry1, &entry2);
+}
+
+u16 SPR_getCollisionPairs(SpriteCollisionPair **pairs)
+{
+    if (pairs) *pairs = colPairs;
+
+    return colNumPair;
+}
+
+
+void SPR_initMultiplexing()
+{
+    // already initialized --> end it first
+    if (SPR_isMultiplexingInitialized()) SPR_endMultiplexing();
+
+    // +1 for the end delta of sprites touching the last scanline
+    mplxSpriteLoad = MEM_alloc(MPLX_MAX_LINE + 1);
+    mplxPixelLoad = MEM_alloc((MPLX_MAX_LINE + 1) * sizeof(u16));
+    mplxOverflow = MEM_alloc(MPLX_MAX_LINE + 1);
+    mplxSprites = MEM_alloc(spritesBankSize * sizeof(Sprite*));
+
+    memset(mplxSpriteLoad, 0, MPLX_MAX_LINE + 1);
+    memsetU16(mplxPixelLoad, 0, MPLX_MAX_LINE + 1);
+    mplxNumOverflow = 0;
+    mplxRotation = 0;
+    mplxRelinked = FALSE;
+
+#if (LIB_DEBUG != 0)
+    KLog("Sprite multiplexing initialized");
+#endif // LIB_DEBUG
+}
+
+void SPR_endMultiplexing()
+{
+    if (SPR_isMultiplexingInitialized())
+    {
+        MEM_free(mplxSpriteLoad);
+        mplxSpriteLoad = NULL;
+        MEM_free(mplxPixelLoad);
+        mplxPixelLoad = NULL;
+        MEM_free(mplxOverflow);
+        mplxOverflow = NULL;
+        MEM_free(mplxSprites);
+        mplxSprites = NULL;
+        mplxNumOverflow = 0;
+    }
+}
+
+u16 SPR_isMultiplexingInitialized()
+{
+    return (mplxSpriteLoad != NULL);
+}
+
+const u8* SPR_getScanlineSpriteLoad()
+{
+    return mplxSpriteLoad;
+}
+
+const u16* SPR_getScanlinePixelLoad()
+{
+    return mplxPixelLoad;
+}
+
+u16 SPR_getNumOverflowScanline()
+{
+    return mplxNumOverflow;
+}
+
 void SPR_clear()
 {
 #ifdef SPR_PROFIL
@@ -1300,25 +1754,25 @@ void SPR_update()
 #endif // SPR_PROFIL
 
     Sprite* sprite;
+    Sprite** upload;
+    Sprite** sprites;
 
 #ifdef SPR_DEBUG
     KLog_U1("----------------- SPR_update:  sprite number = ", spriteNum);
 #endif // SPR_DEBUG
 
-    // disable interrupts (we want to avoid DMA queue process when executing this method)
-    SYS_disableInts();
+    PROF_begin("SPR_update");
 
-#ifdef SPR_DEBUG
-    KLog_U1_("  Send sprites to DMA queue: ", highestVDPSpriteIndex + 1, " sprite(s) sent");
-#endif // SPR_DEBUG
+    // lock DMA queue (we want to avoid DMA queue process when executing this method, interrupts stay enabled)
+    DMA_lockQueue();
 
-    const u16 sprNum = highestVDPSpriteIndex + 1;
+    // move some sprite VRAM areas first so tiles uploaded in this update go directly to their new location
+    if (defragBudget) defragStep(defragBudget);
 
-    // send sprites to VRAM using DMA queue (better to do it before sprite tiles upload to avoid being ignored by DMA queue)
-    DMA_queueDma(DMA_VRAM, (u32) vdpSpriteCacheQueue, VDP_SPRITE_TABLE, (sizeof(VDPSprite) / 2) * sprNum, 2);
+    upload = uploadList;
 
-    // iterate over all sprites
-    sprite = firstSprite;
+    // iterate over sprites of the update list (idle static sprites are skipped)
+    sprite = firstUpdate;
     while(sprite)
     {
         u16 timer = sprite->timer;
@@ -1371,8 +1825,9 @@ void SPR_update()
             // only if sprite is visible
             else
             {
+                // tiles are uploaded once sprite table is queued
                 if (status & NEED_TILES_UPLOAD)
-                    loadTiles(sprite);
+                    *upload++ = sprite;
 
                 if (status & NEED_ST_POS_UPDATE)
                 {
@@ -1393,24 +1848,57 @@ void SPR_update()
             sprite->status = status;
         }
 
-        // next sprite
-        sprite = sprite->next;
+        // static sprite not animated and nothing left to process (pending updates of an hidden sprite are done when it becomes visible) ?
+        if ((status & STATIC) && !sprite->timer && (!(status & NEED_UPDATE) || !sprite->visibility))
+        {
+            // leave the update list until a setter is called
+            removeFromUpdateList(sprite);
+            sprite->status = status | SLEEPING;
+        }
+
+        // next sprite (still valid when sprite just left the update list)
+        sprite = sprite->updateNext;
     }
 
-    // VDP sprite cache is now updated, copy it to the queue cache copy
-    memcpy(vdpSpriteCacheQueue, vdpSpriteCache, sizeof(VDPSprite) * sprNum);
+    // compute scanline load and rotate sprites priority on overflowing scanlines
+    if (mplxSpriteLoad) multiplexSprites();
+
+    // VDP sprite cache is now updated, send modified VDP sprites only
+    // (better to do it before sprite tiles upload to avoid being ignored by DMA queue)
+    spriteTableTransferSize = sendSpriteTable(highestVDPSpriteIndex + 1);
+
+    // rotated links were only for this transfer, restore depth ordered links
+    if (mplxRelinked) relinkSprites();
+
+#ifdef SPR_DEBUG
+    KLog_U1_("  Send sprites to DMA queue: ", spriteTableTransferSize, " byte(s) sent");
+#endif // SPR_DEBUG
+
+    // now upload tiles (in update list order)
+    sprites = uploadList;
+    while(sprites < upload) loadTiles(*sprites++);
 
     // reset unpack buffer address
     unpackNext = unpackBuffer;
 
-    // re-enable interrupts
-    SYS_enableInts();
+    // DMA queue can be flushed again (on next VBlank if we missed the current one)
+    DMA_unlockQueue();
+
+    // compute collision pairs (no VDP access here)
+    if (colEntries) updateCollision();
+
+    PROF_end();
 
 #ifdef SPR_PROFIL
     profil_time[PROFIL_UPDATE] += getSubTick() - prof;
 #endif // SPR_PROFIL
 }
 
+u16 SPR_getSpriteTableTransferSize()
+{
+    return spriteTableTransferSize;
+}
+
 void SPR_logProfil()
 {
 #ifdef SPR_PROFIL
@@ -1425,6 +1913,7 @@ void SPR_logProfil()
     KLog_U2x(4, "Update visibility=", profil_time[PROFIL_UPDATE_VISIBILITY], "  Update frame=", profil_time[PROFIL_UPDATE_FRAME]);
     KLog_U2x(4, "Update vdp_spr_ind=", profil_time[PROFIL_UPDATE_VDPSPRIND], "  Update vis spr table=", profil_time[PROFIL_UPDATE_VISTABLE]);
     KLog_U2x(4, "Update Sprite Table=", profil_time[PROFIL_UPDATE_SPRITE_TABLE], " Load Tiles=", profil_time[PROFIL_LOADTILES]);
+    KLog_U1x(4, "Collision=", profil_time[PROFIL_COLLISION]);
 
     // reset profil counters
     memset(profil_time, 0, sizeof(profil_time));
@@ -1642,6 +2131,21 @@ static u16 updateFrame(Sprite *sprite)
     if (status & SPR_FLAG_AUTO_VISIBILITY)
         status |= NEED_VISIBILITY_UPDATE;
 
+    // shared VRAM alloc --> get VRAM area of the new frame
+    if (status & SPR_FLAG_SHARED_VRAM_ALLOC)
+    {
+        const u16 attr = sprite->attribut;
+        const u16 shared = acquireSharedFrame(sprite->frame->tileset);
+
+        // keep previous frame VRAM area if allocation failed
+        if (shared != SHARED_FRAME_NONE)
+        {
+            releaseSharedFrame(sprite->sharedFrame);
+            sprite->sharedFrame = shared;
+            sprite->attribut = (attr & TILE_ATTR_MASK) | sharedFrames[shared].index;
+        }
+    }
+
     u16 numSpriteFrame = sprite->frame->numSprite;
 
     // number of VDP sprite to use for the current frame changed ?
@@ -1835,6 +2339,25 @@ static void loadTiles(Sprite *sprite)
     u16 compression = tileset->compression;
     u16 lenInWord = (tileset->numTile * 32) / 2;
 
+    // shared VRAM frame ? tiles are uploaded only once
+    if (sprite->status & SPR_FLAG_SHARED_VRAM_ALLOC)
+    {
+        const u16 shared = sprite->sharedFrame;
+        SharedFrame *entry = (shared != SHARED_FRAME_NONE)?&sharedFrames[shared]:NULL;
+
+        // already uploaded (or VRAM area of another frame if allocation failed)
+        if ((entry == NULL) || (!entry->upload) || (entry->tileset != tileset))
+        {
+#ifdef SPR_PROFIL
+            profil_time[PROFIL_LOADTILES] += getSubTick() - prof;
+#endif // SPR_PROFIL
+
+            return;
+        }
+
+        entry->upload = FALSE;
+    }
+
     // TODO: separate tileset per VDP sprite and only unpack/upload visible VDP sprite (using visibility) to VRAM
 
     // need unpacking ?
@@ -1875,62 +2398,319 @@ static void loadTiles(Sprite *sprite)
 #endif // SPR_PROFIL
 }
 
-static Sprite* sortSprite(Sprite* sprite)
+static u16 sendSpriteTable(u16 num)
 {
-#ifdef SPR_PROFIL
-    s32 prof = getSubTick();
-#endif // SPR_PROFIL
+    u32 *src;
+    u32 *dst;
+    u16 start, end;
+    u16 numRange;
+    u16 size;
+    u16 ok;
+    u16 i;
 
-    Sprite* prev = sprite->prev;
-    Sprite* next = sprite->next;
-    Sprite* s;
+    // complete transfer requested ?
+    if (spriteTableFullUpdate)
+    {
+        memcpy(vdpSpriteCacheQueue, vdpSpriteCache, sizeof(VDPSprite) * num);
 
-    // cache sprite depth coordinate
-    const s16 sdepth = sprite->depth;
+        ok = queueSpriteTable(0, num);
+        size = num * sizeof(VDPSprite);
+    }
+    else
+    {
+        src = (u32*) vdpSpriteCache;
+        dst = (u32*) vdpSpriteCacheQueue;
+        start = 0;
+        end = 0;
+        numRange = 0;
+        size = 0;
+        ok = TRUE;
+
+        // compare with queue copy (= last sent VDP sprite table) to find modified VDP sprites
+        for(i = 0; i < num; i++)
+        {
+            if ((src[0] != dst[0]) || (src[1] != dst[1]))
+            {
+                // update queue copy
+                dst[0] = src[0];
+                dst[1] = src[1];
+
+                // first modified VDP sprite
+                if (end == start) start = i;
+                // too far from current range ? (we don't split anymore if we reached maximum number of range)
+                else if (((i - end) >= SPR_TABLE_RANGE_GAP) && (numRange < (SPR_TABLE_MAX_RANGE - 1)))
+                {
+                    ok &= queueSpriteTable(start, end);
+                    size += (end - start) * sizeof(VDPSprite);
+                    numRange++;
+                    start = i;
+                }
 
-#ifdef SPR_DEBUG
-    KLog_U2("Start depth compare for sprite #", getSpriteIndex(sprite), " VDP Sprite Ind=", sprite->VDPSpriteIndex);
-#endif // SPR_DEBUG
+                end = i + 1;
+            }
 
-    // find position forward first
-    s = next;
-    while(s && (s->depth < sdepth)) s = s->next;
-    // position changed ?
-    if (s != next)
-    {
-        // adjust on previous as we insert *after*
-        if (s) s = s->prev;
-        else s = lastSprite;
+            src += 2;
+            dst += 2;
+        }
+
+        // last range
+        if (end > start)
+        {
+            ok &= queueSpriteTable(start, end);
+            size += (end - start) * sizeof(VDPSprite);
+        }
     }
-    else
+
+    // DMA queue is full or transfer may be ignored because of the over capacity strategy ?
+    if (!ok || (DMA_getMaxTransferSize() && DMA_getIgnoreOverCapacity() && (DMA_getQueueTransferSize() > (u32) DMA_getMaxTransferSize())))
     {
-        // try to find position backward then
-        s = prev;
-        while(s && (s->depth > sdepth)) s = s->prev;
+#if (LIB_DEBUG != 0)
+        KLog("SPR_update: sprite table transfer may be lost, full transfer scheduled for next update");
+#endif
+
+        // VRAM sprite table may not be up to date, resend it completely next time
+        spriteTableFullUpdate = TRUE;
     }
+    else spriteTableFullUpdate = FALSE;
 
-#ifdef SPR_DEBUG
-    if (s) KLog_U1("Position for sprite = ", getSpriteIndex(s) + 1);
-    else KLog_U1("Position for sprite = ", 0);
-#endif // SPR_DEBUG
+    return size;
+}
 
-    // position changed ? --> insert sprite after s
-    if (s != prev) moveAfter(s, sprite);
+static u16 queueSpriteTable(u16 start, u16 end)
+{
+    return DMA_queueDma(DMA_VRAM, (u32) &vdpSpriteCacheQueue[start], VDP_SPRITE_TABLE + (start * sizeof(VDPSprite)), (sizeof(VDPSprite) / 2) * (end - start), 2);
+}
 
+static void multiplexSprites()
+{
 #ifdef SPR_PROFIL
-    profil_time[PROFIL_SORT] += getSubTick() - prof;
+    s32 prof = getSubTick();
 #endif // SPR_PROFIL
 
-    // return prev just for convenience on full sorting
-    return prev;
-}
+    u8 *spriteLoad = mplxSpriteLoad;
+    u16 *pixelLoad = mplxPixelLoad;
+    u8 *overflow = mplxOverflow;
+    Sprite **sprites = mplxSprites;
+    Sprite *sprite;
+    VDPSprite *vdpSprite;
+    VDPSprite *last;
+    const s16 height = screenHeight;
+    const u16 maxSprite = (screenWidth == 320)?20:16;
+    const u16 maxPixel = screenWidth;
+    u16 numOver;
+    u16 num;
+    u16 rot;
+    u16 i;
+    u8 sl;
+    u16 pl;
 
-static void moveAfter(Sprite* pos, Sprite* sprite)
-{
-    Sprite* prev = sprite->prev;
-    Sprite* next = sprite->next;
+    // clear scanline deltas
+    memset(spriteLoad, 0, height + 1);
+    memsetU16(pixelLoad, 0, height + 1);
 
-#ifdef SPR_DEBUG
+    // add start / end deltas of each displayed VDP sprite (links are still in depth order here)
+    sprite = firstSprite;
+    while(sprite)
+    {
+        // hidden sprite has all its VDP sprites at y = 0
+        if (sprite->visibility)
+        {
+            last = sprite->lastVDPSprite;
+            vdpSprite = &vdpSpriteCache[sprite->VDPSpriteIndex];
+
+            while(TRUE)
+            {
+                s16 y0 = vdpSprite->y - 0x80;
+                s16 y1 = y0 + (((vdpSprite->size & 3) + 1) << 3);
+
+                if ((y1 > 0) && (y0 < height))
+                {
+                    const u16 w = (((vdpSprite->size >> 2) & 3) + 1) << 3;
+
+                    if (y0 < 0) y0 = 0;
+                    if (y1 > height) y1 = height;
+
+                    spriteLoad[y0]++;
+                    spriteLoad[y1]--;
+                    pixelLoad[y0] += w;
+                    pixelLoad[y1] -= w;
+                }
+
+                if (vdpSprite == last) break;
+                vdpSprite = &vdpSpriteCache[vdpSprite->link];
+            }
+        }
+
+        sprite = sprite->next;
+    }
+
+    // integrate deltas and count overflowing scanlines (overflow[y] = number of overflowing scanline before y)
+    sl = 0;
+    pl = 0;
+    numOver = 0;
+    for(i = 0; i < height; i++)
+    {
+        sl += spriteLoad[i];
+        pl += pixelLoad[i];
+        spriteLoad[i] = sl;
+        pixelLoad[i] = pl;
+        overflow[i] = numOver;
+
+        if ((sl > maxSprite) || (pl > maxPixel)) numOver++;
+    }
+    overflow[height] = numOver;
+    mplxNumOverflow = numOver;
+
+#ifdef SPR_DEBUG
+    KLog_U1("  Multiplexing - overflowing scanlines: ", numOver);
+#endif // SPR_DEBUG
+
+    if (numOver)
+    {
+        // get sprites (in depth order) having at least one VDP sprite on an overflowing scanline
+        num = 0;
+        sprite = firstSprite;
+        while(sprite)
+        {
+            // always on top sprites keep their priority
+            if (sprite->visibility && (sprite->depth != SPR_MIN_DEPTH))
+            {
+                last = sprite->lastVDPSprite;
+                vdpSprite = &vdpSpriteCache[sprite->VDPSpriteIndex];
+
+                while(TRUE)
+                {
+                    s16 y0 = vdpSprite->y - 0x80;
+                    s16 y1 = y0 + (((vdpSprite->size & 3) + 1) << 3);
+
+                    if ((y1 > 0) && (y0 < height))
+                    {
+                        if (y0 < 0) y0 = 0;
+                        if (y1 > height) y1 = height;
+
+                        // at least one overflowing scanline in [y0, y1[
+                        if (overflow[y1] != overflow[y0])
+                        {
+                            sprites[num++] = sprite;
+                            break;
+                        }
+                    }
+
+                    if (vdpSprite == last) break;
+                    vdpSprite = &vdpSpriteCache[vdpSprite->link];
+                }
+            }
+
+            sprite = sprite->next;
+        }
+
+        // rotate these sprites in their depth order slots so the VDP drops a different one each frame
+        if (num > 1)
+        {
+            rot = mplxRotation++ % num;
+
+            last = starter;
+            i = 0;
+            sprite = firstSprite;
+            while(sprite)
+            {
+                Sprite *s = sprite;
+
+                if ((i < num) && (sprite == sprites[i]))
+                {
+                    s = sprites[rot];
+                    if (++rot == num) rot = 0;
+                    i++;
+                }
+
+                last->link = s->VDPSpriteIndex;
+                last = s->lastVDPSprite;
+                sprite = sprite->next;
+            }
+            last->link = 0;
+
+            // need to restore depth order links after sprite table transfer
+            mplxRelinked = TRUE;
+        }
+    }
+
+#ifdef SPR_PROFIL
+    profil_time[PROFIL_MULTIPLEX] += getSubTick() - prof;
+#endif // SPR_PROFIL
+}
+
+static void relinkSprites()
+{
+    VDPSprite *last = starter;
+    Sprite *sprite = firstSprite;
+
+    while(sprite)
+    {
+        last->link = sprite->VDPSpriteIndex;
+        last = sprite->lastVDPSprite;
+        sprite = sprite->next;
+    }
+    last->link = 0;
+
+    mplxRelinked = FALSE;
+}
+
+static Sprite* sortSprite(Sprite* sprite)
+{
+#ifdef SPR_PROFIL
+    s32 prof = getSubTick();
+#endif // SPR_PROFIL
+
+    Sprite* prev = sprite->prev;
+    Sprite* next = sprite->next;
+    Sprite* s;
+
+    // cache sprite depth coordinate
+    const s16 sdepth = sprite->depth;
+
+#ifdef SPR_DEBUG
+    KLog_U2("Start depth compare for sprite #", getSpriteIndex(sprite), " VDP Sprite Ind=", sprite->VDPSpriteIndex);
+#endif // SPR_DEBUG
+
+    // find position forward first
+    s = next;
+    while(s && (s->depth < sdepth)) s = s->next;
+    // position changed ?
+    if (s != next)
+    {
+        // adjust on previous as we insert *after*
+        if (s) s = s->prev;
+        else s = lastSprite;
+    }
+    else
+    {
+        // try to find position backward then
+        s = prev;
+        while(s && (s->depth > sdepth)) s = s->prev;
+    }
+
+#ifdef SPR_DEBUG
+    if (s) KLog_U1("Position for sprite = ", getSpriteIndex(s) + 1);
+    else KLog_U1("Position for sprite = ", 0);
+#endif // SPR_DEBUG
+
+    // position changed ? --> insert sprite after s
+    if (s != prev) moveAfter(s, sprite);
+
+#ifdef SPR_PROFIL
+    profil_time[PROFIL_SORT] += getSubTick() - prof;
+#endif // SPR_PROFIL
+
+    // return prev just for convenience on full sorting
+    return prev;
+}
+
+static void moveAfter(Sprite* pos, Sprite* sprite)
+{
+    Sprite* prev = sprite->prev;
+    Sprite* next = sprite->next;
+
+#ifdef SPR_DEBUG
     if (pos) KLog_U2("Insert #", getSpriteIndex(sprite), "  after #", getSpriteIndex(pos));
     else KLog_U1_("Insert #", getSpriteIndex(sprite), "  at #0");
 #endif // SPR_DEBUG
@@ -1996,6 +2776,298 @@ static void moveAfter(Sprite* pos, Sprite* sprite)
     }
 }
 
+static void resetSharedFrames()
+{
+    SharedFrame *entry = sharedFrames;
+    const u16 num = spritesBankSize + 1;
+    u16 i;
+
+    // all entries are free
+    for(i = 0; i < num; i++, entry++)
+    {
+        entry->tileset = NULL;
+        entry->next = (i < (num - 1))?(i + 1):SHARED_FRAME_NONE;
+    }
+    sharedFree = 0;
+
+    // and all buckets are empty
+    memsetU16(sharedBuckets, SHARED_FRAME_NONE, sharedBucketMask + 1);
+}
+
+static u16 getSharedFrameBucket(const TileSet *tileset)
+{
+    const u32 adr = (u32) tileset;
+
+    // tilesets are word aligned
+    return ((adr >> 1) ^ (adr >> 9)) & sharedBucketMask;
+}
+
+static u16 acquireSharedFrame(const TileSet *tileset)
+{
+    const u16 bucket = getSharedFrameBucket(tileset);
+    SharedFrame *entry;
+    u16 shared;
+    s16 ind;
+
+    shared = sharedBuckets[bucket];
+    while(shared != SHARED_FRAME_NONE)
+    {
+        entry = &sharedFrames[shared];
+
+        // frame already in VRAM --> just add a reference
+        if (entry->tileset == tileset)
+        {
+            entry->refCount++;
+            return shared;
+        }
+
+        shared = entry->next;
+    }
+
+    // allocate VRAM for this frame
+    ind = VRAM_alloc(&vram, tileset->numTile);
+
+    // not enough VRAM
+    if (ind < 0)
+    {
+#if (LIB_DEBUG != 0)
+        KLog_U1("SPR_update: cannot allocate VRAM for shared frame, tile number = ", tileset->numTile);
+#endif // LIB_DEBUG
+
+        return SHARED_FRAME_NONE;
+    }
+
+#ifdef SPR_DEBUG
+    KLog_U3("  shared frame: allocated ", tileset->numTile, " tiles in VRAM at ", ind, ", remaining VRAM: ", VRAM_getFree(&vram));
+#endif // SPR_DEBUG
+
+    // can't be empty (one entry per sprite + 1)
+    shared = sharedFree;
+    entry = &sharedFrames[shared];
+    sharedFree = entry->next;
+
+    entry->tileset = tileset;
+    entry->index = ind;
+    entry->refCount = 1;
+    entry->upload = TRUE;
+    // insert in bucket
+    entry->next = sharedBuckets[bucket];
+    sharedBuckets[bucket] = shared;
+
+    return shared;
+}
+
+static void releaseSharedFrame(u16 shared)
+{
+    SharedFrame *entry;
+
+    // no frame allocated yet
+    if (shared == SHARED_FRAME_NONE) return;
+
+    entry = &sharedFrames[shared];
+
+    // last reference --> release VRAM
+    if (--entry->refCount == 0)
+    {
+        u16 *link = &sharedBuckets[getSharedFrameBucket(entry->tileset)];
+
+        VRAM_free(&vram, entry->index);
+
+        // remove from bucket (only frames sharing the same hash are visited)
+        while(*link != shared) link = &sharedFrames[*link].next;
+        *link = entry->next;
+
+        // and put back in free list
+        entry->tileset = NULL;
+        entry->next = sharedFree;
+        sharedFree = shared;
+
+#ifdef SPR_DEBUG
+        KLog_U2("  shared frame: released tiles in VRAM at ", entry->index, ", remaining VRAM: ", VRAM_getFree(&vram));
+#endif // SPR_DEBUG
+    }
+}
+
+static void defragStep(u16 budget)
+{
+#ifdef SPR_PROFIL
+    s32 prof = getSubTick();
+#endif // SPR_PROFIL
+
+    Sprite* sprite;
+    Sprite* owner;
+    SharedFrame *entry;
+    SharedFrame *ownerEntry;
+    u16 tries = DEFRAG_MAX_TRY;
+
+    // previous moves pending ?
+    if (defragNumFree)
+    {
+        // VRAM copy not yet done (DMA queue capacity limit) --> can't release previous locations
+        if (!DMA_isOpDone(defragOp)) return;
+
+        while(defragNumFree) VRAM_free(&vram, defragFree[--defragNumFree]);
+    }
+
+    // nothing to compact
+    if (VRAM_getFragmentation(&vram) == 0) return;
+
+    while(tries--)
+    {
+        u16 ind = 0;
+        u16 size = 0;
+        u16 i;
+
+        owner = NULL;
+        ownerEntry = NULL;
+
+        // find the highest movable block below the limit (sprite with automatic VRAM allocation and tile upload)
+        sprite = firstSprite;
+        while(sprite)
+        {
+            const u16 status = sprite->status;
+
+            if ((status & SPR_FLAG_AUTO_VRAM_ALLOC) && (status & SPR_FLAG_AUTO_TILE_UPLOAD))
+            {
+                const u16 spriteInd = sprite->attribut & TILE_INDEX_MASK;
+
+                if ((spriteInd < defragLimit) && (spriteInd >= ind))
+                {
+                    ind = spriteInd;
+                    size = sprite->definition->maxNumTile;
+                    owner = sprite;
+                }
+            }
+
+            sprite = sprite->next;
+        }
+
+        // or shared VRAM frame
+        entry = sharedFrames;
+        i = spritesBankSize + 1;
+        while(i--)
+        {
+            if (entry->tileset && (entry->index < defragLimit) && (entry->index >= ind))
+            {
+                ind = entry->index;
+                size = entry->tileset->numTile;
+                owner = NULL;
+                ownerEntry = entry;
+            }
+
+            entry++;
+        }
+
+        // no more candidate --> restart from top of VRAM region on next frame
+        if ((owner == NULL) && (ownerEntry == NULL))
+        {
+            defragLimit = 0xFFFF;
+            break;
+        }
+
+        // next candidate will be located below this one
+        defragLimit = ind;
+
+        const u16 len = size * 32;
+
+        // not enough budget left for this block
+        if (len > budget) continue;
+
+        // find a free area ending before the block (can't overlap so copy is safe)
+        const s16 newInd = VRAM_allocBelow(&vram, size, ind);
+        if (newInd < 0) continue;
+
+        // queue copy of tiles to their new location (done at VBlank, before tiles uploaded by this update and before
+        // the sprite table using the new location as the DMA queue is processed in order)
+        if (!DMA_queueVRamCopy(ind * 32, newInd * 32, len, 1))
+        {
+            // DMA queue is full --> cancel
+            VRAM_free(&vram, newInd);
+            break;
+        }
+
+        // previous area is released only when the copy is done so nothing can be uploaded there before
+        defragFree[defragNumFree++] = ind;
+        defragOp = DMA_getQueueOpId();
+        budget -= len;
+
+#ifdef SPR_DEBUG
+        KLog_U3("  defragStep: moved ", size, " tiles from ", ind, " to ", newInd);
+#endif // SPR_DEBUG
+
+        if (owner)
+        {
+            owner->attribut = newInd | (owner->attribut & TILE_ATTR_MASK);
+            owner->status |= NEED_ST_ATTR_UPDATE;
+            if (owner->status & SLEEPING) wakeSprite(owner);
+        }
+        else
+        {
+            const u16 shared = ownerEntry - sharedFrames;
+
+            ownerEntry->index = newInd;
+
+            // update all sprites using this shared frame
+            sprite = firstSprite;
+            while(sprite)
+            {
+                const u16 attr = sprite->attribut;
+
+                if ((sprite->status & SPR_FLAG_SHARED_VRAM_ALLOC) && (sprite->sharedFrame == shared))
+                {
+                    sprite->attribut = newInd | (attr & TILE_ATTR_MASK);
+                    sprite->status |= NEED_ST_ATTR_UPDATE;
+                    if (sprite->status & SLEEPING) wakeSprite(sprite);
+                }
+
+                sprite = sprite->next;
+            }
+        }
+
+        // budget exhausted
+        if (budget == 0) break;
+    }
+
+#ifdef SPR_PROFIL
+    profil_time[PROFIL_VRAM_DEFRAG] += getSubTick() - prof;
+#endif // SPR_PROFIL
+}
+
+static void addToUpdateList(Sprite *sprite)
+{
+    // insert at head, processing order does not matter
+    sprite->updatePrev = NULL;
+    sprite->updateNext = firstUpdate;
+    if (firstUpdate) firstUpdate->updatePrev = sprite;
+    firstUpdate = sprite;
+
+    updateNum++;
+}
+
+static void removeFromUpdateList(Sprite *sprite)
+{
+    Sprite *prev = sprite->updatePrev;
+    Sprite *next = sprite->updateNext;
+
+    // sprite->updateNext is preserved so SPR_update() can continue its iteration
+    if (prev) prev->updateNext = next;
+    else firstUpdate = next;
+    if (next) next->updatePrev = prev;
+
+    updateNum--;
+}
+
+static void wakeSprite(Sprite *sprite)
+{
+    // static sprite put back in the update list (it leaves it again once processed)
+    sprite->status &= ~SLEEPING;
+    addToUpdateList(sprite);
+
+#ifdef SPR_DEBUG
+    KLog_U1("wakeSprite: #", getSpriteIndex(sprite));
+#endif // SPR_DEBUG
+}
+
 static u16 getSpriteIndex(Sprite *sprite)
 {
     u16 res = 0;
@@ -2019,3 +3091,276 @@ static void logSprite(Sprite *sprite)
     KLog_U2("VDPSpriteInd=", sprite->VDPSpriteIndex, " link=", sprite->lastVDPSprite->link);
     KLog_U2("prev=", (sprite->prev==NULL)?128:getSpriteIndex(sprite->prev), " next=", (sprite->next==NULL)?128:getSpriteIndex(sprite->next));
 }
+
+
+static u16 getCollisionEntry(Sprite *sprite, CollisionEntry *entry)
+{
+    const AnimationFrame *frame = sprite->frame;
+
+    if (!frame) return FALSE;
+
+    const Collision *collision = frame->collision;
+
+    if (!collision) return FALSE;
+
+    const Box *box;
+
+    // get shape for current flip state (Box and Circle share x and y fields)
+    switch(sprite->attribut & (TILE_ATTR_HFLIP_MASK | TILE_ATTR_VFLIP_MASK))
+    {
+        default:
+            box = &collision->norm.box;
+            break;
+
+        case TILE_ATTR_HFLIP_MASK:
+            box = &collision->hflip.box;
+            break;
+
+        case TILE_ATTR_VFLIP_MASK:
+            box = &collision->vflip.box;
+            break;
+
+        case TILE_ATTR_HFLIP_MASK | TILE_ATTR_VFLIP_MASK:
+            box = &collision->hvflip.box;
+            break;
+    }
+
+    entry->sprite = sprite;
+    entry->type = collision->type;
+
+    if (collision->type == COLLISION_TYPE_CIRCLE)
+    {
+        const Circle *circle = (const Circle*) box;
+        const s16 ray = circle->ray;
+
+        // empty shape
+        if (!ray) return FALSE;
+
+        const s16 x = sprite->x + circle->x;
+        const s16 y = sprite->y + circle->y;
+
+        entry->x0 = x - ray;
+        entry->y0 = y - ray;
+        entry->x1 = x + ray;
+        entry->y1 = y + ray;
+    }
+    else
+    {
+        // empty shape
+        if (!(box->w && box->h)) return FALSE;
+
+        const s16 x = sprite->x + box->x;
+        const s16 y = sprite->y + box->y;
+
+        entry->x0 = x;
+        entry->y0 = y;
+        entry->x1 = x + box->w;
+        entry->y1 = y + box->h;
+    }
+
+    return TRUE;
+}
+
+static u16 testCircleBox(const CollisionEntry *circle, const CollisionEntry *box)
+{
+    // use doubled coordinates so circle center is an integer
+    const s16 cx = circle->x0 + circle->x1;
+    const s16 cy = circle->y0 + circle->y1;
+    const s16 d = circle->x1 - circle->x0;
+    s16 dx;
+    s16 dy;
+
+    // distance to nearest box point
+    if (cx < (box->x0 * 2)) dx = cx - (box->x0 * 2);
+    else if (cx > (box->x1 * 2)) dx = cx - (box->x1 * 2);
+    else dx = 0;
+    if (cy < (box->y0 * 2)) dy = cy - (box->y0 * 2);
+    else if (cy > (box->y1 * 2)) dy = cy - (box->y1 * 2);
+    else dy = 0;
+
+    return (((s32) dx * (s32) dx) + ((s32) dy * (s32) dy)) < ((s32) d * (s32) d);
+}
+
+static u16 testCollisionEntries(const CollisionEntry *entry1, const CollisionEntry *entry2)
+{
+    // bounding box test first (exact for box vs box)
+    if ((entry1->x0 >= entry2->x1) || (entry2->x0 >= entry1->x1) ||
+        (entry1->y0 >= entry2->y1) || (entry2->y0 >= entry1->y1))
+        return FALSE;
+
+    if (entry1->type == COLLISION_TYPE_CIRCLE)
+    {
+        if (entry2->type == COLLISION_TYPE_CIRCLE)
+        {
+            // use doubled coordinates so circle center is an integer
+            const s16 dx = (entry1->x0 + entry1->x1) - (entry2->x0 + entry2->x1);
+            const s16 dy = (entry1->y0 + entry1->y1) - (entry2->y0 + entry2->y1);
+            const s16 d = (entry1->x1 - entry1->x0) + (entry2->x1 - entry2->x0);
+
+            return (((s32) dx * (s32) dx) + ((s32) dy * (s32) dy)) < ((s32) d * (s32) d);
+        }
+
+        return testCircleBox(entry1, entry2);
+    }
+    if (entry2->type == COLLISION_TYPE_CIRCLE)
+        return testCircleBox(entry2, entry1);
+
+    return TRUE;
+}
+
+static inline u16 getCellX(s16 x)
+{
+    x -= COL_GRID_X;
+
+    if (x < 0) return 0;
+    x >>= COL_CELL_SHIFT;
+    if (x >= COL_GRID_W) return COL_GRID_W - 1;
+
+    return x;
+}
+
+static inline u16 getCellY(s16 y)
+{
+    y -= COL_GRID_Y;
+
+    if (y < 0) return 0;
+    y >>= COL_CELL_SHIFT;
+    if (y >= COL_GRID_H) return COL_GRID_H - 1;
+
+    return y;
+}
+
+static void addCollisionPair(const CollisionEntry *entry1, const CollisionEntry *entry2)
+{
+    Sprite *sprite1 = entry1->sprite;
+    Sprite *sprite2 = entry2->sprite;
+
+    // collision filter
+    if (!(sprite1->collisionGroup & sprite2->collisionMask)) return;
+    if (!(sprite2->collisionGroup & sprite1->collisionMask)) return;
+    // max number of pair reached
+    if (colNumPair >= colMaxPair) return;
+
+    if (testCollisionEntries(entry1, entry2))
+    {
+        SpriteCollisionPair *pair = &colPairs[colNumPair++];
+
+        pair->sprite1 = sprite1;
+        pair->sprite2 = sprite2;
+    }
+}
+
+static void updateCollision()
+{
+#ifdef SPR_PROFIL
+    s32 prof = getSubTick();
+#endif // SPR_PROFIL
+
+    CollisionEntry *entry;
+    CollisionEntry **large;
+    CollisionNode *node;
+    Sprite *sprite;
+    u16 numEntry;
+    u16 numLarge;
+    u16 cx, cy;
+
+    memset(colCells, 0, sizeof(colCells));
+    colNumPair = 0;
+
+    entry = colEntries;
+    large = colLargeEntries;
+    node = colNodes;
+
+    // fill broadphase grid
+    sprite = firstSprite;
+    while(sprite)
+    {
+        if (sprite->collisionGroup && getCollisionEntry(sprite, entry))
+        {
+            const u16 cx0 = getCellX(entry->x0);
+            const u16 cy0 = getCellY(entry->y0);
+            const u16 cx1 = getCellX(entry->x1 - 1);
+            const u16 cy1 = getCellY(entry->y1 - 1);
+
+            if ((((cx1 - cx0) + 1) * ((cy1 - cy0) + 1)) > COL_MAX_CELL)
+            {
+                entry->large = TRUE;
+                *large++ = entry;
+            }
+            else
+            {
+                entry->large = FALSE;
+
+                for(cy = cy0; cy <= cy1; cy++)
+                {
+                    CollisionNode **cell = &colCells[(cy * COL_GRID_W) + cx0];
+
+                    for(cx = cx0; cx <= cx1; cx++, cell++, node++)
+                    {
+                        node->entry = entry;
+                        node->next = *cell;
+                        *cell = node;
+                    }
+                }
+            }
+
+            entry++;
+        }
+
+        sprite = sprite->next;
+    }
+
+    numEntry = entry - colEntries;
+    numLarge = large - colLargeEntries;
+
+    // test sprites sharing a cell
+    CollisionNode **cell = colCells;
+    for(cy = 0; cy < COL_GRID_H; cy++)
+    {
+        for(cx = 0; cx < COL_GRID_W; cx++, cell++)
+        {
+            CollisionNode *node1 = *cell;
+
+            while(node1)
+            {
+                const CollisionEntry *entry1 = node1->entry;
+                CollisionNode *node2 = node1->next;
+
+                while(node2)
+                {
+                    const CollisionEntry *entry2 = node2->entry;
+
+                    // only report the pair in the cell containing the top-left corner of the bounding boxes intersection
+                    // so a pair is never reported twice
+                    if ((getCellX(max(entry1->x0, entry2->x0)) == cx) && (getCellY(max(entry1->y0, entry2->y0)) == cy))
+                        addCollisionPair(entry1, entry2);
+
+                    node2 = node2->next;
+                }
+
+                node1 = node1->next;
+            }
+        }
+    }
+
+    // test large sprites against all others
+    large = colLargeEntries;
+    while(numLarge--)
+    {
+        const CollisionEntry *entry1 = *large++;
+        u16 i;
+
+        entry = colEntries;
+        for(i = 0; i < numEntry; i++, entry++)
+        {
+            // large vs large pair only tested once
+            if (entry->large && (entry <= entry1)) continue;
+
+            addCollisionPair(entry1, entry);
+        }
+    }
+
+#ifdef SPR_PROFIL
+    profil_time[PROFIL_COLLISION] += getSubTick() - prof;
+#endif // SPR_PROFIL
+}
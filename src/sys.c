@@ -46,11 +46,15 @@ extern void BMP_doVBlankProcess();
 extern void TC_doVBlankProcess();
 extern u16 SPR_doVBlankProcess();
 extern void XGM_doVBlankProcess();
+extern u16 VDP_doExtVBlankVIntProcess();
+extern u16 VDP_doExtVBlankHIntProcess();
+extern void VDP_doPlanShadowVBlankProcess();
 
 // main function
 extern int main(u16 hard);
 
 static void internal_reset();
+static void flushDMAQueue();
 
 // exception callbacks
 _voidCallback *busErrorCB;
@@ -405,23 +409,24 @@ void _vint_callback()
         if (vintp & PROCESS_XGM_TASK)
             XGM_doVBlankProcess();
 
-        // dma processing
-        if (vintp & PROCESS_DMA_TASK)
-        {
-            // DMA protection for XGM driver
-            if (currentDriver == Z80_DRIVER_XGM)
-            {
-                XGM_set68KBUSProtection(TRUE);
+        u16 flushDMA = TRUE;
 
-                // delay enabled ? --> wait a bit to improve PCM playback (test on SOR2)
-                if (SND_getForceDelayDMA_XGM()) waitSubTick(10);
+        // plan shadow processing (modified spans not yet sent with VDP_flushPlanShadow() are queued before the DMA flush)
+        if (vintp & PROCESS_PLANSHADOW_TASK)
+        {
+            VDP_doPlanShadowVBlankProcess();
+            // DMA process may have been set by the queued spans
+            vintp |= VIntProcess & PROCESS_DMA_TASK;
+        }
 
-                DMA_flushQueue();
+        // extended blank processing (DMA queue is flushed at bottom border instead of VBlank when there is one)
+        if (vintp & PROCESS_EXTVBLANK_TASK)
+            flushDMA = VDP_doExtVBlankVIntProcess();
 
-                XGM_set68KBUSProtection(FALSE);
-            }
-            else
-                DMA_flushQueue();
+        // dma processing (operations added while the queue is locked are not yet committed)
+        if (flushDMA && (vintp & PROCESS_DMA_TASK))
+        {
+            flushDMAQueue();
 
             // always clear process
             vintp &= ~PROCESS_DMA_TASK;
@@ -461,6 +466,23 @@ void _hint_callback()
     {
         if (!BMP_doHBlankProcess()) HIntProcess &= ~PROCESS_BITMAP_TASK;
     }
+    // extended blank processing
+    if (HIntProcess & PROCESS_EXTVBLANK_TASK)
+    {
+        // display disabled at bottom border --> flush DMA queue now
+        if (VDP_doExtVBlankHIntProcess())
+        {
+            // modified plan shadow spans go with this flush
+            if (VIntProcess & PROCESS_PLANSHADOW_TASK)
+                VDP_doPlanShadowVBlankProcess();
+
+            if (VIntProcess & PROCESS_DMA_TASK)
+            {
+                flushDMAQueue();
+                VIntProcess &= ~PROCESS_DMA_TASK;
+            }
+        }
+    }
 
     // ...
 
@@ -600,6 +622,25 @@ void _reset_entry()
 }
 
 
+static void flushDMAQueue()
+{
+    // DMA protection for XGM driver
+    if (currentDriver == Z80_DRIVER_XGM)
+    {
+        XGM_set68KBUSProtection(TRUE);
+
+        // delay enabled ? --> wait a bit to improve PCM playback (test on SOR2)
+        // not from H-Int (extended blank) where we don't want to delay main code and display more
+        if (SND_getForceDelayDMA_XGM() && !(intTrace & IN_HINT)) waitSubTick(10);
+
+        DMA_flushQueue();
+
+        XGM_set68KBUSProtection(FALSE);
+    }
+    else
+        DMA_flushQueue();
+}
+
 static void internal_reset()
 {
     VIntCBPre = NULL;
@@ -0,0 +1,314 @@
+#include "config.h"
+#include "types.h"
+
+#include "task.h"
+
+#include "vdp.h"
+#include "timer.h"
+#include "kdebug.h"
+
+
+/*
+ * Task slots are never moved so a task can safely be added or removed from a callback.
+ * 'order' contains the index of slots in scheduling order (priority then insertion order),
+ * tasks added while the scheduler is running are inserted in 'order' when it stops.
+ */
+typedef struct
+{
+    TaskCallback *callback;
+    void *data;
+    u16 id;
+    u16 priority;
+    u16 budget;
+    u16 flags;
+    u16 used;
+    u16 yielded;
+    u32 frame;
+} Task;
+
+
+static Task tasks[TASK_MAX];
+static u16 order[TASK_MAX];
+static u16 pending[TASK_MAX];
+static u16 numTask = 0;
+static u16 numPending = 0;
+static u16 nextId = 1;
+static u16 budget = TASK_DEFAULT_BUDGET;
+
+// scheduler state while running
+static Task *current = NULL;
+static u32 taskEnd;
+static u32 schedEnd;
+static u16 untilVSync;
+
+
+static void insertPending();
+static void removeDead();
+static u16 run(u32 end, u16 mask);
+static u16 isVSyncNear();
+
+
+void TASK_reset()
+{
+    u16 i;
+
+    for(i = 0; i < TASK_MAX; i++)
+    {
+        tasks[i].id = 0;
+        tasks[i].callback = NULL;
+    }
+
+    numTask = 0;
+    numPending = 0;
+    budget = TASK_DEFAULT_BUDGET;
+}
+
+u16 TASK_add(TaskCallback *callback, void *data, u16 priority, u16 taskBudget, u16 flags)
+{
+    Task *task;
+    u16 i;
+
+    task = tasks;
+    i = TASK_MAX;
+    while(i--)
+    {
+        if (task->id == 0) break;
+        task++;
+    }
+
+    if (task == &tasks[TASK_MAX])
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("TASK_add failed: no more free task slot !");
+#endif
+
+        return 0;
+    }
+
+    task->callback = callback;
+    task->data = data;
+    task->priority = priority;
+    task->budget = taskBudget;
+    task->flags = flags;
+    task->used = 0;
+    task->yielded = FALSE;
+    task->frame = vtimer;
+    task->id = nextId++;
+    // 0 is reserved for free slot
+    if (nextId == 0) nextId = 1;
+
+    pending[numPending++] = task - tasks;
+    // not running --> can directly insert it
+    if (current == NULL) insertPending();
+
+    return task->id;
+}
+
+void TASK_remove(u16 id)
+{
+    Task *task;
+    u16 i;
+
+    if (id == 0) return;
+
+    task = tasks;
+    i = TASK_MAX;
+    while(i--)
+    {
+        if ((task->id == id) && (task->callback != NULL))
+        {
+            // just mark it, slot is released when scheduler is not running
+            task->callback = NULL;
+            if (current == NULL) removeDead();
+            return;
+        }
+
+        task++;
+    }
+}
+
+u16 TASK_isAlive(u16 id)
+{
+    Task *task;
+    u16 i;
+
+    if (id == 0) return FALSE;
+
+    task = tasks;
+    i = TASK_MAX;
+    while(i--)
+    {
+        if ((task->id == id) && (task->callback != NULL)) return TRUE;
+        task++;
+    }
+
+    return FALSE;
+}
+
+u16 TASK_getNumTask()
+{
+    return numTask + numPending;
+}
+
+
+void TASK_setBudget(u16 value)
+{
+    budget = value;
+}
+
+u16 TASK_getBudget()
+{
+    return budget;
+}
+
+
+u16 TASK_update()
+{
+    // nothing to do or called from a task
+    if ((TASK_getNumTask() == 0) || (current != NULL)) return TASK_getNumTask();
+
+    untilVSync = FALSE;
+
+    return run(getSubTick() + budget, TASK_FOREGROUND);
+}
+
+u16 TASK_updateUntilVSync()
+{
+    // nothing to do or called from a task
+    if ((TASK_getNumTask() == 0) || (current != NULL)) return TASK_getNumTask();
+
+    untilVSync = TRUE;
+
+    return run(0xFFFFFFFF, TASK_BACKGROUND);
+}
+
+u16 TASK_shouldYield()
+{
+    // not called from a task
+    if (current == NULL) return FALSE;
+
+    if (getSubTick() >= taskEnd) return TRUE;
+    if (untilVSync) return isVSyncNear();
+
+    return FALSE;
+}
+
+
+static u16 run(u32 end, u16 mask)
+{
+    u16 i;
+
+    schedEnd = end;
+
+    for(i = 0; i < numTask; i++)
+    {
+        Task *task = &tasks[order[i]];
+        u32 start;
+        u32 elapsed;
+        u16 res;
+
+        // removed or not allowed in this pass
+        if ((task->callback == NULL) || ((task->flags & mask) != mask)) continue;
+
+        start = getSubTick();
+
+        // new frame --> reset task frame state
+        if (task->frame != vtimer)
+        {
+            task->frame = vtimer;
+            task->used = 0;
+            task->yielded = FALSE;
+        }
+
+        // task already yielded or used its budget for this frame
+        if (task->yielded || (task->budget && (task->used >= task->budget))) continue;
+
+        taskEnd = end;
+        if (task->budget)
+        {
+            const u32 te = start + (task->budget - task->used);
+            if (te < taskEnd) taskEnd = te;
+        }
+
+        current = task;
+        do
+        {
+            res = task->callback(task->data);
+        } while((res == TASK_CONTINUE) && (task->callback != NULL) && !TASK_shouldYield());
+        current = NULL;
+
+        elapsed = getSubTick() - start;
+        if ((task->used + elapsed) > 0xFFFF) task->used = 0xFFFF;
+        else task->used += elapsed;
+
+        if (res == TASK_DONE) task->callback = NULL;
+        else if (res == TASK_YIELD) task->yielded = TRUE;
+
+        // scheduler budget spent ?
+        if (getSubTick() >= schedEnd) break;
+        if (untilVSync && isVSyncNear()) break;
+    }
+
+    removeDead();
+    insertPending();
+
+    return TASK_getNumTask();
+}
+
+static u16 isVSyncNear()
+{
+    if (GET_VDPSTATUS(VDP_VBLANK_FLAG)) return TRUE;
+
+    // extended VBlank starts at bottom border (see VDP_setExtendedVBlank(..))
+    return (GET_VCOUNTER >= (screenHeight - (VDP_getExtendedVBlankBottom() + TASK_VSYNC_MARGIN)))?TRUE:FALSE;
+}
+
+static void insertPending()
+{
+    u16 i;
+
+    // pending tasks are inserted in the order they were added
+    for(i = 0; i < numPending; i++)
+    {
+        const u16 ind = pending[i];
+        Task *task = &tasks[ind];
+        u16 j;
+
+        // removed before being inserted
+        if (task->callback == NULL)
+        {
+            task->id = 0;
+            continue;
+        }
+
+        // find position (after tasks with same or higher priority)
+        j = numTask;
+        while(j && (tasks[order[j - 1]].priority < task->priority))
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+
+        order[j] = ind;
+        numTask++;
+    }
+
+    numPending = 0;
+}
+
+static void removeDead()
+{
+    u16 i, j;
+
+    j = 0;
+    for(i = 0; i < numTask; i++)
+    {
+        Task *task = &tasks[order[i]];
+
+        // release slot
+        if (task->callback == NULL) task->id = 0;
+        else order[j++] = order[i];
+    }
+
+    numTask = j;
+}
@@ -9,6 +9,7 @@
 #include "tools.h"
 #include "sys.h"
 #include "kdebug.h"
+#include "prof.h"
 
 
 #define DEFAULT_NUM_BLOC    128
@@ -170,6 +171,8 @@ static void addToUploadQueue(TileSet *tileset, u16 index);
 TileSet** uploads;            // this variable is specifically cleared in SYS reset method
 static u16 uploadIndex;
 static u16 uploadDone;
+// DMA queue identifier of last upload operation
+static u16 uploadOp;
 
 
 void TC_init()
@@ -258,6 +261,8 @@ void TC_flushCache(TileCache *cache)
 
 s16 TC_alloc(TileCache *cache, TileSet *tileset, TCUpload upload)
 {
+    PROF_begin("TC_alloc");
+
     // try re-allocation first if already present in cache
     u16 index = TC_reAlloc(cache, tileset);
 
@@ -275,6 +280,7 @@ s16 TC_alloc(TileCache *cache, TileSet *tileset, TCUpload upload)
             KDebug_Alert("TC_alloc failed: no more free block !");
 #endif
 
+            PROF_end();
             return -1;
         }
 
@@ -284,7 +290,10 @@ s16 TC_alloc(TileCache *cache, TileSet *tileset, TCUpload upload)
 
         // not enough space in cache
         if ((s16) index == -1)
+        {
+            PROF_end();
             return index;
+        }
 
         // process VDP upload if required
         if (upload != NO_UPLOAD)
@@ -304,7 +313,10 @@ s16 TC_alloc(TileCache *cache, TileSet *tileset, TCUpload upload)
 
                 // error while unpacking tileset
                 if (unpacked == NULL)
+                {
+                    PROF_end();
                     return -1;
+                }
 
                 // upload the tileset to VRAM now ?
                 if (upload == UPLOAD_NOW)
@@ -356,6 +368,8 @@ s16 TC_alloc(TileCache *cache, TileSet *tileset, TCUpload upload)
         block->index = index;
     }
 
+    PROF_end();
+
     return index;
 }
 
@@ -601,6 +615,9 @@ static void releaseFlushable(TileCache *cache, u16 start, u16 end)
 
 static void addToUploadQueue(TileSet *tileset, u16 index)
 {
+    // upload info and DMA operation have to be flushed at same VBlank
+    DMA_lockQueue();
+
     // need to clear to queue ?
     if (uploadDone)
     {
@@ -626,6 +643,10 @@ static void addToUploadQueue(TileSet *tileset, u16 index)
 
     // put in DMA queue
     DMA_queueDma(DMA_VRAM, (u32) tileset->tiles, index * 32, tileset->numTile * 16, 2);
+    // set while the queue is locked so VInt processing never sees a previous operation identifier
+    uploadOp = DMA_getQueueOpId();
+
+    DMA_unlockQueue();
 }
 
 
@@ -633,6 +654,7 @@ static void addToUploadQueue(TileSet *tileset, u16 index)
 void TC_doVBlankProcess()
 {
     // just inform the upload has been done (DMA queue) so we can released tilesets
-    if (!uploadDone && uploadIndex)
+    // (upload may be postponed by the DMA capacity limit so we check the operation is really sent)
+    if (!uploadDone && uploadIndex && !DMA_isQueueLocked() && DMA_isOpDone(uploadOp))
         uploadDone = TRUE;
 }
@@ -9,6 +9,7 @@
 #include "maths.h"
 #include "memory.h"
 #include "vdp.h"
+#include "dma.h"
 
 
 //forward
@@ -830,7 +831,7 @@ void KLog_F4x(s16 numDec, char* t1, fix32 v1, char* t2, fix32 v2, char* t3, fix3
 static u16 getBitmapAllocSize(const Bitmap *bitmap)
 {
     // need space to decompress
-    if (bitmap->compression != COMPRESSION_NONE)
+    if ((bitmap->compression & BITMAP_COMPRESSION_MASK) != COMPRESSION_NONE)
         return (bitmap->w * bitmap->h) / 2;
 
     return 0;
@@ -862,9 +863,10 @@ static Bitmap *allocateBitmapInternal(const Bitmap *bitmap, void *adr)
 
     if (result != NULL)
     {
-        result->compression = COMPRESSION_NONE;
+        // keep layout
+        result->compression = bitmap->compression & BITMAP_TILED;
 
-        if (bitmap->compression != COMPRESSION_NONE)
+        if ((bitmap->compression & BITMAP_COMPRESSION_MASK) != COMPRESSION_NONE)
             // allocate sub buffers (no need to allocate palette as we directly use the source pointer)
             result->image = (u8*) (adr + sizeof(Bitmap));
         else
@@ -1033,10 +1035,12 @@ Bitmap *unpackBitmap(const Bitmap *src, Bitmap *dest)
         result->w = src->w;
         result->h = src->h;
         result->palette = src->palette;
+        // unpacked but keep layout
+        result->compression = src->compression & BITMAP_TILED;
 
         // unpack image
-        if (src->compression != COMPRESSION_NONE)
-            unpack(src->compression, (u8*) src->image, (u8*) result->image);
+        if ((src->compression & BITMAP_COMPRESSION_MASK) != COMPRESSION_NONE)
+            unpack(src->compression & BITMAP_COMPRESSION_MASK, (u8*) src->image, (u8*) result->image);
         // simple copy if needed
         else if (src->image != result->image)
             memcpy((u8*) result->image, (u8*) src->image, (src->w * src->h) / 2);
@@ -1139,6 +1143,386 @@ u32 unpack(u16 compression, u8 *src, u8 *dest)
     }
 }
 
+// match length (in word) from which we use VRAM copy DMA instead of VDP read / write
+#define LZ4W_VRAM_COPY_MIN  24
+
+u32 lz4w_unpackToVRam(const u8 *src, u16 dest)
+{
+    vu16 *pwdata;
+    vu32 *plctrl;
+    u16 buf[16];
+    u16 pos;
+
+    /* point to vdp port */
+    plctrl = (u32 *) GFX_CTRL_PORT;
+    pwdata = (u16 *) GFX_DATA_PORT;
+
+    pos = dest;
+    VDP_setAutoInc(2);
+    *plctrl = GFX_WRITE_VRAM_ADDR(pos);
+
+    while(TRUE)
+    {
+        const u16 lit = src[0] >> 4;
+        const u16 mat = src[0] & 0xF;
+        const u16 off = src[1];
+        u16 offset;
+        u16 len;
+        u16 i;
+
+        src += 2;
+
+        // literals
+        i = lit;
+        while(i--)
+        {
+            *pwdata = *((u16*) src);
+            src += 2;
+        }
+        pos += lit * 2;
+
+        // short match
+        if (mat)
+        {
+            len = mat + 1;
+            offset = (off + 1) * 2;
+        }
+        // long match (offset stored after literals, already * 2)
+        else if (off)
+        {
+            len = off + 2;
+            offset = *((u16*) src) + 2;
+            src += 2;
+        }
+        // end marker
+        else if (lit == 0) break;
+        // only literals
+        else continue;
+
+        if (len >= LZ4W_VRAM_COPY_MIN)
+        {
+            // VRAM copy works by byte in increasing order so it handles overlapping match
+            DMA_doVRamCopy(pos - offset, pos, len * 2, 1);
+            VDP_waitDMACompletion();
+            VDP_setAutoInc(2);
+            pos += len * 2;
+        }
+        else
+        {
+            while(len)
+            {
+                // don't read data not yet written (overlapping match)
+                u16 n = min(len, min(offset >> 1, 16));
+                u16 *b;
+
+                *plctrl = GFX_READ_VRAM_ADDR((u16) (pos - offset));
+                b = buf;
+                i = n;
+                while(i--) *b++ = *pwdata;
+
+                *plctrl = GFX_WRITE_VRAM_ADDR(pos);
+                b = buf;
+                i = n;
+                while(i--) *pwdata = *b++;
+
+                pos += n * 2;
+                len -= n;
+            }
+        }
+
+        // restore write address
+        *plctrl = GFX_WRITE_VRAM_ADDR(pos);
+    }
+
+    // need to copy a last byte ?
+    if (*((s16*) src) < 0)
+    {
+        u16 v;
+
+        // preserve low byte
+        *plctrl = GFX_READ_VRAM_ADDR(pos);
+        v = *pwdata;
+        *plctrl = GFX_WRITE_VRAM_ADDR(pos);
+        *pwdata = (src[1] << 8) | (v & 0xFF);
+        pos++;
+    }
+
+    // VRAM address arithmetic is 16 bits so the result has to be truncated
+    return (u16) (pos - dest);
+}
+
+// incremental unpacker states
+#define US_STATE_START      0
+#define US_STATE_RUN        1
+#define US_STATE_LONGMATCH  2
+#define US_STATE_END        3
+
+void unpackStreamInit(UnpackStream *us, u16 compression, const u8 *src, u8 *dest, u16 windowSize)
+{
+    us->compression = compression;
+    us->state = US_STATE_START;
+    us->src = src;
+    us->dest = dest;
+    // linear buffer ? no wrapping
+    if (windowSize) us->mask = windowSize - 1;
+    else us->mask = 0xFFFFFFFF;
+    us->pos = 0;
+    us->len = 0;
+    us->offset = 0;
+    us->lastOffset = 0;
+    us->lit = 0;
+    us->lwm = 2;
+    // empty bit buffer (only the marker bit)
+    us->bits = 0x80;
+
+#if (LIB_DEBUG != 0)
+    if (windowSize & (windowSize - 1))
+        KDebug_Alert("unpackStreamInit: window size should be a power of 2 !");
+#endif
+}
+
+u32 unpackStreamGetPos(UnpackStream *us)
+{
+    return us->pos;
+}
+
+u16 unpackStreamIsDone(UnpackStream *us)
+{
+    return us->state == US_STATE_END;
+}
+
+static u16 lz4wStream(UnpackStream *us, u16 size)
+{
+    const u8 *src = us->src;
+    u8 *dest = us->dest;
+    const u32 mask = us->mask;
+    u32 pos = us->pos;
+    // LZ4W works by word
+    u16 remaining = size >> 1;
+
+    while(remaining)
+    {
+        u16 n;
+
+        // pending literals
+        if (us->lit)
+        {
+            n = min(us->lit, remaining);
+            us->lit -= n;
+            remaining -= n;
+
+            while(n--)
+            {
+                *((u16*) &dest[pos & mask]) = *((u16*) src);
+                src += 2;
+                pos += 2;
+            }
+        }
+        // long match offset is stored after literals
+        else if (us->state == US_STATE_LONGMATCH)
+        {
+            // stored offset is already * 2
+            us->offset = *((u16*) src) + 2;
+            src += 2;
+            us->state = US_STATE_RUN;
+        }
+        // pending match
+        else if (us->len)
+        {
+            u32 from = pos - us->offset;
+
+            n = min(us->len, remaining);
+            us->len -= n;
+            remaining -= n;
+
+            while(n--)
+            {
+                *((u16*) &dest[pos & mask]) = *((u16*) &dest[from & mask]);
+                from += 2;
+                pos += 2;
+            }
+        }
+        else
+        {
+            const u16 lit = src[0] >> 4;
+            const u16 mat = src[0] & 0xF;
+            const u16 off = src[1];
+
+            src += 2;
+            us->lit = lit;
+
+            // short match
+            if (mat)
+            {
+                us->len = mat + 1;
+                us->offset = (off + 1) * 2;
+            }
+            // long match
+            else if (off)
+            {
+                us->len = off + 2;
+                us->state = US_STATE_LONGMATCH;
+            }
+            // end marker
+            else if (lit == 0)
+            {
+                const u16 last = *((u16*) src);
+
+                src += 2;
+                // need to copy a last byte ?
+                if (last & 0x8000) dest[pos++ & mask] = last;
+
+                us->state = US_STATE_END;
+                break;
+            }
+        }
+    }
+
+    size = pos - us->pos;
+    us->src = src;
+    us->pos = pos;
+
+    return size;
+}
+
+static u16 aplibGetBit(UnpackStream *us)
+{
+    u16 bits = us->bits << 1;
+
+    // only the marker bit remains ? get next byte
+    if ((bits & 0xFF) == 0) bits = (*us->src++ << 1) | 1;
+
+    us->bits = bits & 0xFF;
+
+    return (bits >> 8) & 1;
+}
+
+static u32 aplibGetGamma(UnpackStream *us)
+{
+    u32 v = 1;
+
+    do
+    {
+        v = (v << 1) + aplibGetBit(us);
+    } while(aplibGetBit(us));
+
+    return v;
+}
+
+static u16 aplibStream(UnpackStream *us, u16 size)
+{
+    u8 *dest = us->dest;
+    const u32 mask = us->mask;
+    u32 pos = us->pos;
+    u16 remaining = size;
+
+    while(remaining)
+    {
+        // pending match
+        if (us->len)
+        {
+            u32 from = pos - us->offset;
+            u16 n = min(us->len, remaining);
+
+            us->len -= n;
+            remaining -= n;
+
+            while(n--) dest[pos++ & mask] = dest[from++ & mask];
+        }
+        // first byte is always a literal
+        else if (us->state == US_STATE_START)
+        {
+            dest[pos++ & mask] = *us->src++;
+            remaining--;
+            us->state = US_STATE_RUN;
+        }
+        // %0 --> literal
+        else if (!aplibGetBit(us))
+        {
+            dest[pos++ & mask] = *us->src++;
+            remaining--;
+            us->lwm = 2;
+        }
+        // %10 --> code pair
+        else if (!aplibGetBit(us))
+        {
+            u32 offset = aplibGetGamma(us);
+
+            // same offset than previous match
+            if (offset == us->lwm)
+                us->len = aplibGetGamma(us);
+            else
+            {
+                offset = ((offset - (us->lwm + 1)) << 8) | *us->src++;
+                us->len = aplibGetGamma(us);
+
+                if (offset >= 32000) us->len += 2;
+                else if (offset >= 1280) us->len += 1;
+                else if (offset < 128) us->len += 2;
+
+                us->lastOffset = offset;
+            }
+
+            us->offset = us->lastOffset;
+            us->lwm = 1;
+        }
+        // %110 --> short match
+        else if (!aplibGetBit(us))
+        {
+            const u16 b = *us->src++;
+            const u16 offset = b >> 1;
+
+            // end marker
+            if (offset == 0)
+            {
+                us->state = US_STATE_END;
+                break;
+            }
+
+            us->len = 2 + (b & 1);
+            us->offset = offset;
+            us->lastOffset = offset;
+            us->lwm = 1;
+        }
+        // %111 --> single byte from 4 bits offset (0 = write 0)
+        else
+        {
+            u16 offset = 0;
+            u16 i = 4;
+
+            while(i--) offset = (offset << 1) | aplibGetBit(us);
+
+            if (offset) dest[pos & mask] = dest[(pos - offset) & mask];
+            else dest[pos & mask] = 0;
+            pos++;
+            remaining--;
+            us->lwm = 2;
+        }
+    }
+
+    size = pos - us->pos;
+    us->pos = pos;
+
+    return size;
+}
+
+u16 unpackStream(UnpackStream *us, u16 size)
+{
+    if (us->state == US_STATE_END) return 0;
+
+    switch(us->compression)
+    {
+        case COMPRESSION_APLIB:
+            return aplibStream(us, size);
+
+        case COMPRESSION_LZ4W:
+            return lz4wStream(us, size);
+
+        default:
+            return 0;
+    }
+}
+
 
 #define QSORT(type)                                     \
     u16 partition_##type(type *data, u16 p, u16 r)      \
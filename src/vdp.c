@@ -13,6 +13,8 @@
 #include "string.h"
 #include "memory.h"
 #include "dma.h"
+#include "sys.h"
+#include "task.h"
 
 #include "font.h"
 
@@ -23,8 +25,20 @@
 #define APLAN_DEFAULT           0xE000      // multiple of 0x2000
 #define BPLAN_DEFAULT           0xC000      // multiple of 0x2000
 
+// DMA bandwidth (in byte) per blanked scanline in H40 / H32 mode
+#define DMA_LINE_CAPACITY_H40   205
+#define DMA_LINE_CAPACITY_H32   167
+// scanlines lost in interrupt processing
+#define DMA_LINE_MARGIN         2
+
+
+// we don't want to share them
+extern vu32 VIntProcess;
+extern vu32 HIntProcess;
+
 
 static void updateMapsAddress();
+static u16 getDMACapacity(u16 lines);
 
 
 static u8 regValues[0x13];
@@ -45,6 +59,19 @@ u16 planWidthSft;
 u16 planHeightSft;
 u16 windowWidthSft;
 
+// extended vblank: number of blanked scanline at top / bottom of the screen and H-Int phase
+static u16 extBlankTop;
+static u16 extBlankBottom;
+static u16 extBlankPhase;
+static s16 extBlankPrevMaxTransfer;
+// DMA capacity when bottom border is blanked / when it isn't (only VBlank and top border)
+static s16 extBlankCapacity;
+static s16 extBlankSkipCapacity;
+// DMA queue has been flushed at bottom border for this frame
+static vu16 extBlankFlushed;
+// main code is idle in VDP_waitVSync() (no VDP access in progress)
+static vu16 waitingVSync;
+
 
 // constants for plan
 const VDPPlan PLAN_A = { CONST_PLAN_A };
@@ -79,6 +106,12 @@ void VDP_init()
     planHeightSft = 5;
     windowWidthSft = 6;
 
+    // no extended blank
+    extBlankTop = 0;
+    extBlankBottom = 0;
+    extBlankFlushed = FALSE;
+    waitingVSync = FALSE;
+
     regValues[0x00] = 0x04;
     regValues[0x01] = 0x74;                     /* reg. 1 - Enable display, VBL, DMA + VCell size */
     regValues[0x02] = aplan_addr / 0x400;       /* reg. 2 - Plane A = $E000 */
@@ -670,6 +703,160 @@ void VDP_setWindowVPos(u16 down, u16 pos)
 }
 
 
+u16 VDP_setExtendedVBlank(u16 top, u16 bottom)
+{
+    const u16 enabled = extBlankTop || extBlankBottom;
+
+    // bitmap mode uses its own H-Int processing
+    if (HIntProcess & PROCESS_BITMAP_TASK)
+    {
+#if (LIB_DEBUG != 0)
+        KDebug_Alert("VDP_setExtendedVBlank failed: can't be used with bitmap mode !");
+#endif
+
+        return FALSE;
+    }
+
+    // top border can't exceed half of the remaining active area (see VDP_doExtVBlankHIntProcess())
+    if (bottom > (screenHeight / 2)) bottom = screenHeight / 2;
+    if (top > ((screenHeight - bottom) / 2) - 1) top = ((screenHeight - bottom) / 2) - 1;
+
+    SYS_disableInts();
+
+    extBlankTop = top;
+    extBlankBottom = bottom;
+
+    // disable
+    if ((top == 0) && (bottom == 0))
+    {
+        if (enabled)
+        {
+            HIntProcess &= ~PROCESS_EXTVBLANK_TASK;
+            VIntProcess &= ~PROCESS_EXTVBLANK_TASK;
+
+            VDP_setHInterrupt(0);
+            // re enable VDP if it was disabled because of extended blank
+            VDP_setEnable(1);
+            VDP_setHIntCounter(255);
+            // restore previous DMA capacity
+            DMA_setMaxTransferSize(extBlankPrevMaxTransfer);
+        }
+    }
+    else
+    {
+        if (!enabled) extBlankPrevMaxTransfer = DMA_getMaxTransferSize();
+
+        // wait first VBlank to start (display stays as it is until then)
+        extBlankPhase = 3;
+        extBlankFlushed = FALSE;
+        VDP_setHIntCounter(255);
+
+        HIntProcess |= PROCESS_EXTVBLANK_TASK;
+        VIntProcess |= PROCESS_EXTVBLANK_TASK;
+        VDP_setHInterrupt(1);
+
+        // limit DMA queue transfer to what fits in the extended blank
+        extBlankCapacity = getDMACapacity(VDP_getScanlineNumber() - screenHeight + top + bottom);
+        extBlankSkipCapacity = getDMACapacity(VDP_getScanlineNumber() - screenHeight + top);
+        DMA_setMaxTransferSize(extBlankCapacity);
+    }
+
+    SYS_enableInts();
+
+    return TRUE;
+}
+
+u16 VDP_getExtendedVBlankTop()
+{
+    return extBlankTop;
+}
+
+u16 VDP_getExtendedVBlankBottom()
+{
+    return extBlankBottom;
+}
+
+u16 VDP_getVBlankDMACapacity()
+{
+    return getDMACapacity(VDP_getScanlineNumber() - screenHeight + extBlankTop + extBlankBottom);
+}
+
+u16 VDP_doExtVBlankVIntProcess()
+{
+    // DMA queue not flushed at bottom border (no bottom border or skipped) --> flush it now
+    const u16 flush = !extBlankFlushed;
+
+    extBlankFlushed = FALSE;
+
+    // bottom border not blanked for this frame --> DMA queue only has VBlank and top border
+    if (flush) DMA_setMaxTransferSize(extBlankSkipCapacity);
+
+    if (extBlankTop)
+    {
+        // keep display disabled up to the end of top border
+        VDP_setEnable(0);
+        VDP_setHIntCounter(extBlankTop - 1);
+        extBlankPhase = 0;
+    }
+    else
+    {
+        // no top border --> display is enabled now and next H-Int is for bottom border
+        VDP_setEnable(1);
+        VDP_setHIntCounter((screenHeight - extBlankBottom) - 1);
+        extBlankPhase = 2;
+    }
+
+    return flush;
+}
+
+u16 VDP_doExtVBlankHIntProcess()
+{
+    switch(extBlankPhase)
+    {
+        // end of top border
+        case 0:
+            VDP_setEnable(1);
+
+            if (extBlankBottom)
+            {
+                // counter was already reloaded with (top - 1) so new value is used after next H-Int (at line (top * 2) - 1)
+                VDP_setHIntCounter(((screenHeight - extBlankBottom) - 1) - (extBlankTop * 2));
+                extBlankPhase = 1;
+            }
+            else
+            {
+                VDP_setHIntCounter(255);
+                extBlankPhase = 3;
+            }
+            return FALSE;
+
+        // in active screen
+        case 1:
+            extBlankPhase = 2;
+            return FALSE;
+
+        // start of bottom border --> disable display, DMA queue can be flushed now
+        case 2:
+            extBlankPhase = 3;
+
+            // main code may be inside a VDP access sequence (control / data port) or a Z80 BUS access
+            // --> don't touch VDP, display stays enabled and DMA queue is flushed at VBlank
+            if (!waitingVSync) return FALSE;
+
+            VDP_setEnable(0);
+            // next H-Int after VBlank is set in VDP_doExtVBlankVIntProcess()
+            VDP_setHIntCounter(255);
+            extBlankFlushed = TRUE;
+            // whole extended blank available for DMA queue
+            DMA_setMaxTransferSize(extBlankCapacity);
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+
 void VDP_waitDMACompletion()
 {
     while(GET_VDPSTATUS(VDP_DMABUSY_FLAG));
@@ -688,7 +875,12 @@ void VDP_waitVSync()
     pw = (u16 *) GFX_CTRL_PORT;
 
     while (*pw & VDP_VBLANK_FLAG);
+    // use idle time before VBlank to process background tasks
+    if (TASK_getNumTask()) TASK_updateUntilVSync();
+    // no VDP access from here so extended blank H-Int processing can be done
+    waitingVSync = TRUE;
     while (!(*pw & VDP_VBLANK_FLAG));
+    waitingVSync = FALSE;
 }
 
 
@@ -732,6 +924,16 @@ void VDP_showFPS(u16 float_display)
 }
 
 
+static u16 getDMACapacity(u16 lines)
+{
+    u32 result = (lines - DMA_LINE_MARGIN) * ((screenWidth == 320)?DMA_LINE_CAPACITY_H40:DMA_LINE_CAPACITY_H32);
+
+    // DMA_setMaxTransferSize(..) uses a signed 16 bits value
+    if (result > 0x7FFF) return 0x7FFF;
+
+    return result;
+}
+
 static void updateMapsAddress()
 {
     u16 min_addr = window_addr;
@@ -282,8 +282,28 @@ u16 VDP_drawBitmapEx(VDPPlan plan, const Bitmap *bitmap, u16 basetile, u16 x, u1
     const int ht = bitmap->h / 8;
     const Palette *palette = bitmap->palette;
 
+    // tile ordered bitmap --> direct upload, no conversion needed
+    // (immediate DMA as tilemap is written right now, DMA takes care of 128 KB bank crossing)
+    if (bitmap->compression & BITMAP_TILED)
+    {
+        const u16 index = basetile & TILE_INDEX_MASK;
+        const u16 num = wt * ht;
+
+        // compressed bitmap ?
+        if ((bitmap->compression & BITMAP_COMPRESSION_MASK) != COMPRESSION_NONE)
+        {
+            Bitmap *b = unpackBitmap(bitmap, NULL);
+
+            if (b == NULL) return FALSE;
+
+            VDP_loadTileData((u32*) b->image, index, num, DMA);
+            MEM_free(b);
+        }
+        // directly from source
+        else VDP_loadTileData((u32*) bitmap->image, index, num, DMA);
+    }
     // compressed bitmap ?
-    if (bitmap->compression != COMPRESSION_NONE)
+    else if (bitmap->compression != COMPRESSION_NONE)
     {
         Bitmap *b = unpackBitmap(bitmap, NULL);
 
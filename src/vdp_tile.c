@@ -4,6 +4,7 @@
 #include "vdp.h"
 #include "vdp_tile.h"
 
+#include "sys.h"
 #include "memory.h"
 #include "vdp_pal.h"
 #include "vdp_dma.h"
@@ -12,19 +13,61 @@
 
 #include "font.h"
 #include "tab_cnv.h"
+#include "kdebug.h"
+
+
+// plan shadow: dirty spans of consecutive rows separated by less than this number of tile are sent in the same DMA operation
+#define SHADOW_MERGE_GAP    16
+
+
+// plan tilemap shadow (RAM copy of the plan tilemap), tilemap = NULL when disabled
+typedef struct
+{
+    u16 *tilemap;
+    u8 *dirtyStart;
+    u8 *dirtyEnd;
+    u16 width;
+    u16 height;
+    u16 widthSft;
+    u16 dirty;
+} PlanShadow;
+
+
+extern vu32 VIntProcess;
+
+
+// forward
+static PlanShadow* getPlanShadow(VDPPlan plan);
+static void setShadowLinear(u16 plan, const u16 *data, u16 baseinc, u16 baseor, u16 inc, u16 ind, u16 num);
+static void setShadowRect(PlanShadow *shadow, const u16 *data, u16 baseinc, u16 baseor, u16 inc, u16 x, u16 y, u16 w, u16 h, u16 wm);
+
+// plan A, plan B and window shadows
+static PlanShadow planShadows[3];
+// number of enabled shadow
+static u16 numPlanShadow = 0;
 
 
 u16 VDP_loadTileSet(const TileSet *tileset, u16 index, TransferMethod tm)
 {
     const u16 comp = tileset->compression;
 
+    // LZ4W compressed tileset and CPU transfer ? directly unpack in VRAM
+    if ((comp == COMPRESSION_LZ4W) && (tm == CPU))
+        lz4w_unpackToVRam((u8*) tileset->tiles, index * 32);
     // compressed tileset ?
-    if (comp != COMPRESSION_NONE)
+    else if (comp != COMPRESSION_NONE)
     {
         // unpack first
         TileSet *t = unpackTileSet(tileset, NULL);
 
-        if (t == NULL) return FALSE;
+        if (t == NULL)
+        {
+            // not enough memory ? LZ4W can still be directly unpacked in VRAM
+            if (comp != COMPRESSION_LZ4W) return FALSE;
+
+            lz4w_unpackToVRam((u8*) tileset->tiles, index * 32);
+            return TRUE;
+        }
 
         // tiles
         VDP_loadTileData(t->tiles, index, t->numTile, tm);
@@ -76,6 +119,9 @@ void VDP_setTileMap(u16 plan, u16 tile, u16 ind)
 
     *plctrl = GFX_WRITE_VRAM_ADDR(addr);
     *pwdata = tile;
+
+    // keep shadow in sync
+    if (numPlanShadow) setShadowLinear(plan, NULL, tile, 0, 0, ind, 1);
 }
 
 
@@ -102,6 +148,14 @@ void VDP_setTileMapXY(VDPPlan plan, u16 tile, u16 x, u16 y)
     vu16 *pwdata;
     u16 addr;
 
+    PlanShadow *shadow = getPlanShadow(plan);
+    // shadowed plan --> only update the RAM copy (sent by VDP_flushPlanShadow())
+    if (shadow)
+    {
+        setShadowRect(shadow, NULL, tile, 0, 0, x, y, 1, 1, 1);
+        return;
+    }
+
     /* point to vdp port */
     plctrl = (u32 *) GFX_CTRL_PORT;
     pwdata = (u16 *) GFX_DATA_PORT;
@@ -151,6 +205,9 @@ void VDP_fillTileMap(u16 plan, u16 tile, u16 ind, u16 num)
 
     i = num & 7;
     while (i--) *pwdata = tile;
+
+    // keep shadow in sync
+    if (numPlanShadow) setShadowLinear(plan, NULL, tile, 0, 0, ind, num);
 }
 
 void VDP_fillTileMapRect(VDPPlan plan, u16 tile, u16 x, u16 y, u16 w, u16 h)
@@ -161,6 +218,14 @@ void VDP_fillTileMapRect(VDPPlan plan, u16 tile, u16 x, u16 y, u16 w, u16 h)
     u16 width;
     u16 i, j;
 
+    PlanShadow *shadow = getPlanShadow(plan);
+    // shadowed plan --> only update the RAM copy (sent by VDP_flushPlanShadow())
+    if (shadow)
+    {
+        setShadowRect(shadow, NULL, tile, 0, 0, x, y, w, h, w);
+        return;
+    }
+
     VDP_setAutoInc(2);
 
     /* point to vdp port */
@@ -196,6 +261,9 @@ void VDP_clearTileMap(u16 plan, u16 ind, u16 num, u16 wait)
     // wait for DMA completion
     if (wait)
         VDP_waitDMACompletion();
+
+    // keep shadow in sync
+    if (numPlanShadow) setShadowLinear(plan, NULL, 0, 0, 0, ind, num);
 }
 
 void VDP_clearTileMapRect(VDPPlan plan, u16 x, u16 y, u16 w, u16 h)
@@ -250,6 +318,9 @@ void VDP_fillTileMapInc(u16 plan, u16 basetile, u16 ind, u16 num)
 
     i = num & 7;
     while (i--) *pwdata = tile++;
+
+    // keep shadow in sync
+    if (numPlanShadow) setShadowLinear(plan, NULL, basetile, 0, 1, ind, num);
 }
 
 void VDP_fillTileMapRectInc(VDPPlan plan, u16 basetile, u16 x, u16 y, u16 w, u16 h)
@@ -261,6 +332,14 @@ void VDP_fillTileMapRectInc(VDPPlan plan, u16 basetile, u16 x, u16 y, u16 w, u16
     u16 tile;
     u16 i, j;
 
+    PlanShadow *shadow = getPlanShadow(plan);
+    // shadowed plan --> only update the RAM copy (sent by VDP_flushPlanShadow())
+    if (shadow)
+    {
+        setShadowRect(shadow, NULL, basetile, 0, 1, x, y, w, h, w);
+        return;
+    }
+
     VDP_setAutoInc(2);
 
     /* point to vdp port */
@@ -331,6 +410,9 @@ void VDP_setTileMapData(u16 plan, const u16 *data, u16 ind, u16 num, TransferMet
         i = num & 7;
         while (i--) *pwdata = *src++;
     }
+
+    // keep shadow in sync
+    if (numPlanShadow) setShadowLinear(plan, data, 0, 0, 0, ind, num);
 }
 
 void VDP_setTileMapDataRect(VDPPlan plan, const u16 *data, u16 x, u16 y, u16 w, u16 h)
@@ -342,6 +424,14 @@ void VDP_setTileMapDataRect(VDPPlan plan, const u16 *data, u16 x, u16 y, u16 w,
     u16 width;
     u16 i, j;
 
+    PlanShadow *shadow = getPlanShadow(plan);
+    // shadowed plan --> only update the RAM copy (sent by VDP_flushPlanShadow())
+    if (shadow)
+    {
+        setShadowRect(shadow, data, 0, 0, 0, x, y, w, h, w);
+        return;
+    }
+
     VDP_setAutoInc(2);
 
     /* point to vdp port */
@@ -417,6 +507,9 @@ void VDP_setTileMapDataEx(u16 plan, const u16 *data, u16 basetile, u16 ind, u16
 
     i = num & 7;
     while (i--) *pwdata = baseor | (*src++ + baseinc);
+
+    // keep shadow in sync
+    if (numPlanShadow) setShadowLinear(plan, data, baseinc, baseor, 0, ind, num);
 }
 
 void VDP_setTileMapRectEx(VDPPlan plan, const u16 *data, u16 baseindex, u16 baseflags, u16 x, u16 y, u16 w, u16 h)
@@ -435,6 +528,19 @@ void VDP_setTileMapDataRectEx(VDPPlan plan, const u16 *data, u16 basetile, u16 x
     u16 baseor;
     u16 i, j;
 
+    // we can increment both index and palette
+    baseinc = basetile & (TILE_INDEX_MASK | TILE_ATTR_PALETTE_MASK);
+    // we can only do logical OR on priority and HV flip
+    baseor = basetile & (TILE_ATTR_PRIORITY_MASK | TILE_ATTR_VFLIP_MASK | TILE_ATTR_HFLIP_MASK);
+
+    PlanShadow *shadow = getPlanShadow(plan);
+    // shadowed plan --> only update the RAM copy (sent by VDP_flushPlanShadow())
+    if (shadow)
+    {
+        setShadowRect(shadow, data, baseinc, baseor, 0, x, y, w, h, wm);
+        return;
+    }
+
     VDP_setAutoInc(2);
 
     /* point to vdp port */
@@ -445,10 +551,6 @@ void VDP_setTileMapDataRectEx(VDPPlan plan, const u16 *data, u16 basetile, u16 x
     if (plan.value == CONST_PLAN_WINDOW) width = windowWidth;
     else width = planWidth;
 
-    // we can increment both index and palette
-    baseinc = basetile & (TILE_INDEX_MASK | TILE_ATTR_PALETTE_MASK);
-    // we can only do logical OR on priority and HV flip
-    baseor = basetile & (TILE_ATTR_PRIORITY_MASK | TILE_ATTR_VFLIP_MASK | TILE_ATTR_HFLIP_MASK);
     src = data;
 
     i = h;
@@ -493,3 +595,333 @@ u16 VDP_setMapEx(VDPPlan plan, const Map *map, u16 basetile, u16 x, u16 y, u16 x
 
     return TRUE;
 }
+
+
+static PlanShadow* getPlanShadow(VDPPlan plan)
+{
+    PlanShadow *shadow;
+
+    if (!numPlanShadow || (plan.value > CONST_PLAN_WINDOW)) return NULL;
+
+    shadow = &planShadows[plan.value];
+    if (shadow->tilemap) return shadow;
+
+    return NULL;
+}
+
+static u16 getPlanShadowAddress(u16 index)
+{
+    switch(index)
+    {
+        default:
+        case CONST_PLAN_A:
+            return VDP_PLAN_A;
+
+        case CONST_PLAN_B:
+            return VDP_PLAN_B;
+
+        case CONST_PLAN_WINDOW:
+            return VDP_PLAN_WINDOW;
+    }
+}
+
+static u16 setShadowCells(u16 *dst, const u16 *src, u16 baseinc, u16 baseor, u16 inc, u16 num)
+{
+    u16 i = num;
+
+    if (src)
+    {
+        while(i--) *dst++ = baseor | (*src++ + baseinc);
+        return baseinc;
+    }
+
+    while(i--)
+    {
+        *dst++ = baseinc;
+        baseinc += inc;
+    }
+
+    return baseinc;
+}
+
+static void setShadowDirty(PlanShadow *shadow, u16 row, u16 start, u16 end)
+{
+    u8 *ds = &shadow->dirtyStart[row];
+    u8 *de = &shadow->dirtyEnd[row];
+
+    // clean row
+    if (*de == 0)
+    {
+        *ds = start;
+        *de = end;
+    }
+    else
+    {
+        if (start < *ds) *ds = start;
+        if (end > *de) *de = end;
+    }
+
+    shadow->dirty = TRUE;
+}
+
+static void setShadowLinear(u16 plan, const u16 *data, u16 baseinc, u16 baseor, u16 inc, u16 ind, u16 num)
+{
+    PlanShadow *shadow = planShadows;
+    u16 i;
+
+    for(i = CONST_PLAN_A; i <= CONST_PLAN_WINDOW; i++, shadow++)
+    {
+        if (shadow->tilemap && (getPlanShadowAddress(i) == plan))
+        {
+            const u16 size = shadow->height << shadow->widthSft;
+
+            // VRAM was written directly, just mirror the data
+            if (ind < size)
+                setShadowCells(&shadow->tilemap[ind], data, baseinc, baseor, inc, min(num, size - ind));
+
+            return;
+        }
+    }
+}
+
+static void setShadowRect(PlanShadow *shadow, const u16 *data, u16 baseinc, u16 baseor, u16 inc, u16 x, u16 y, u16 w, u16 h, u16 wm)
+{
+    const u16 width = shadow->width;
+    const u16 height = shadow->height;
+    const u16 xs = x & (width - 1);
+    const u16 *src = data;
+    u16 ys = y & (height - 1);
+    u16 wl, wr;
+    u16 i;
+
+    if (w > width) w = width;
+
+    // region crosses the plan right border --> wrap on the same row
+    if ((xs + w) > width)
+    {
+        wl = width - xs;
+        wr = w - wl;
+    }
+    else
+    {
+        wl = w;
+        wr = 0;
+    }
+
+    i = h;
+    while(i--)
+    {
+        u16 *row = &shadow->tilemap[ys << shadow->widthSft];
+
+        baseinc = setShadowCells(row + xs, src, baseinc, baseor, inc, wl);
+        if (src) src += wl;
+
+        if (wr)
+        {
+            baseinc = setShadowCells(row, src, baseinc, baseor, inc, wr);
+            if (src) src += wr;
+
+            setShadowDirty(shadow, ys, 0, width);
+        }
+        else setShadowDirty(shadow, ys, xs, xs + wl);
+
+        if (src) src += wm - w;
+        ys = (ys + 1) & (height - 1);
+    }
+}
+
+static u16 sendShadowRun(PlanShadow *shadow, u16 addr, u16 start, u16 end, u16 firstRow, u16 lastRow)
+{
+    if (!DMA_queueDma(DMA_VRAM, (u32) &shadow->tilemap[start], addr + (start * 2), end - start, 2))
+        return FALSE;
+
+    // rows are now clean
+    memset(&shadow->dirtyEnd[firstRow], 0, (lastRow - firstRow) + 1);
+
+    return TRUE;
+}
+
+u16 VDP_enablePlanShadow(VDPPlan plan)
+{
+    vu32 *plctrl;
+    vu16 *pwdata;
+    PlanShadow *shadow;
+    u16 *dst;
+    u16 size;
+    u16 i;
+
+    if (plan.value > CONST_PLAN_WINDOW) return FALSE;
+
+    shadow = &planShadows[plan.value];
+    // already enabled
+    if (shadow->tilemap) return TRUE;
+
+    if (plan.value == CONST_PLAN_WINDOW)
+    {
+        shadow->width = windowWidth;
+        shadow->widthSft = windowWidthSft;
+        shadow->height = 32;
+    }
+    else
+    {
+        shadow->width = planWidth;
+        shadow->widthSft = planWidthSft;
+        shadow->height = planHeight;
+    }
+
+    size = shadow->height << shadow->widthSft;
+    // tilemap copy followed by dirty span of each row
+    dst = MEM_alloc((size * 2) + (shadow->height * 2));
+
+    if (dst == NULL)
+    {
+#if (LIB_DEBUG != 0)
+        KLog_U1("VDP_enablePlanShadow failed: not enough memory, required = ", (size * 2) + (shadow->height * 2));
+#endif // LIB_DEBUG
+
+        return FALSE;
+    }
+
+    shadow->tilemap = dst;
+    shadow->dirtyStart = (u8*) &dst[size];
+    shadow->dirtyEnd = shadow->dirtyStart + shadow->height;
+    shadow->dirty = FALSE;
+    memset(shadow->dirtyEnd, 0, shadow->height);
+
+    // read back current tilemap so the shadow starts in sync with VRAM
+    VDP_setAutoInc(2);
+
+    /* point to vdp port */
+    plctrl = (u32 *) GFX_CTRL_PORT;
+    pwdata = (u16 *) GFX_DATA_PORT;
+
+    *plctrl = GFX_READ_VRAM_ADDR((u32) getPlanShadowAddress(plan.value));
+
+    i = size;
+    while(i--) *dst++ = *pwdata;
+
+    numPlanShadow++;
+    // enable plan shadow V-Int processing
+    VIntProcess |= PROCESS_PLANSHADOW_TASK;
+
+    return TRUE;
+}
+
+void VDP_disablePlanShadow(VDPPlan plan)
+{
+    PlanShadow *shadow;
+
+    if (plan.value > CONST_PLAN_WINDOW) return;
+
+    shadow = &planShadows[plan.value];
+    // not enabled
+    if (shadow->tilemap == NULL) return;
+
+    // V-Int processing can access the shadow
+    SYS_disableInts();
+
+    MEM_free(shadow->tilemap);
+    shadow->tilemap = NULL;
+    numPlanShadow--;
+    // disable plan shadow V-Int processing
+    if (numPlanShadow == 0) VIntProcess &= ~PROCESS_PLANSHADOW_TASK;
+
+    SYS_enableInts();
+}
+
+u16 VDP_isPlanShadowEnabled(VDPPlan plan)
+{
+    return (getPlanShadow(plan) != NULL)?TRUE:FALSE;
+}
+
+static u16 flushPlanShadows()
+{
+    PlanShadow *shadow = planShadows;
+    u16 num = 0;
+    u16 i;
+
+    // spans are committed together (V-Int processing doesn't flush shadows while the queue is locked)
+    DMA_lockQueue();
+
+    for(i = CONST_PLAN_A; i <= CONST_PLAN_WINDOW; i++, shadow++)
+    {
+        if ((shadow->tilemap == NULL) || !shadow->dirty) continue;
+
+        // cleared first so modifications done while we send the spans are not lost
+        shadow->dirty = FALSE;
+
+        const u16 addr = getPlanShadowAddress(i);
+        const u16 sft = shadow->widthSft;
+        const u8 *ds = shadow->dirtyStart;
+        const u8 *de = shadow->dirtyEnd;
+        u16 start = 0;
+        u16 end = 0;
+        u16 firstRow = 0;
+        u16 lastRow = 0;
+        u16 pending = FALSE;
+        u16 row;
+
+        for(row = 0; row < shadow->height; row++)
+        {
+            // clean row
+            if (de[row] == 0) continue;
+
+            const u16 s = (row << sft) + ds[row];
+            const u16 e = (row << sft) + de[row];
+
+            // close enough from previous span --> send them in a single DMA operation
+            if (pending && ((s - end) <= SHADOW_MERGE_GAP))
+            {
+                end = e;
+                lastRow = row;
+            }
+            else
+            {
+                if (pending)
+                {
+                    // DMA queue full --> remaining rows stay dirty for next flush
+                    if (!sendShadowRun(shadow, addr, start, end, firstRow, lastRow))
+                    {
+                        shadow->dirty = TRUE;
+                        DMA_unlockQueue();
+                        return num;
+                    }
+                    num++;
+                }
+
+                start = s;
+                end = e;
+                firstRow = row;
+                lastRow = row;
+                pending = TRUE;
+            }
+        }
+
+        if (pending)
+        {
+            if (!sendShadowRun(shadow, addr, start, end, firstRow, lastRow))
+            {
+                shadow->dirty = TRUE;
+                DMA_unlockQueue();
+                return num;
+            }
+            num++;
+        }
+    }
+
+    DMA_unlockQueue();
+
+    return num;
+}
+
+u16 VDP_flushPlanShadow()
+{
+    return flushPlanShadows();
+}
+
+// V-Int process: remaining modified spans are queued just before the DMA queue flush
+void VDP_doPlanShadowVBlankProcess()
+{
+    // main code is adding DMA operations (or flushing shadows) --> keep spans for next frame
+    if (!DMA_isQueueLocked()) flushPlanShadows();
+}
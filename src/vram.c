@@ -15,18 +15,38 @@
 #define USED_MASK   (1 << USED_SFT)
 #define SIZE_MASK   0x7FFF
 
+// empty free list link
+#define NO_BLOCK    0xFFFF
+
 
 // forward
 static u16* pack(VRAMRegion *region, u16 nsize);
+static void getFreeRuns(VRAMRegion *region, u16 *num, u16 *largest);
+
+static u16 getClass(u16 size);
+static void insertBlock(VRAMRegion *region, u16 ind, u16 size);
+static void removeBlock(VRAMRegion *region, u16 ind, u16 size);
+static s16 allocSegregated(VRAMRegion *region, u16 size);
+static void useBlock(VRAMRegion *region, u16 ind, u16 bsize, u16 size);
+static void freeSegregated(VRAMRegion *region, u16 ind);
 
 
 void VRAM_createRegion(VRAMRegion *region, u16 startIndex, u16 size)
+{
+    VRAM_createRegionEx(region, startIndex, size, VRAM_ALLOC_PACK);
+}
+
+void VRAM_createRegionEx(VRAMRegion *region, u16 startIndex, u16 size, u16 allocator)
 {
     region->startIndex = startIndex;
     region->endIndex = startIndex + (size - 1);
+    region->allocator = allocator;
 
     // alloc vram image allocation buffer
     region->vram = MEM_alloc((size + 1) * sizeof(u16));
+    // alloc free block links (next then previous)
+    if (allocator == VRAM_ALLOC_SEGREGATED) region->links = MEM_alloc(size * 2 * sizeof(u16));
+    else region->links = NULL;
 
     VRAM_clearRegion(region);
 }
@@ -36,11 +56,18 @@ void VRAM_releaseRegion(VRAMRegion *region)
     // release vram image buffer
     MEM_free(region->vram);
     region->vram = NULL;
+    // and free block links
+    if (region->links)
+    {
+        MEM_free(region->links);
+        region->links = NULL;
+    }
 }
 
 void VRAM_clearRegion(VRAMRegion *region)
 {
     u16 size = (region->endIndex - region->startIndex) + 1;
+    u16 i;
 
     // all region is free :)
     region->vram[0] = size;
@@ -49,6 +76,22 @@ void VRAM_clearRegion(VRAMRegion *region)
 
     // init free position
     region->free = region->vram;
+
+    if (region->allocator == VRAM_ALLOC_SEGREGATED)
+    {
+        // boundary tag
+        region->vram[size - 1] = size;
+
+        // empty free lists
+        for(i = 0; i < VRAM_NUM_CLASS; i++)
+            region->classHead[i] = NO_BLOCK;
+        region->classMask = 0;
+        region->numFreeBlock = 0;
+        region->numFreeTile = size;
+
+        // a single free block
+        insertBlock(region, 0, size);
+    }
 }
 
 u16 VRAM_getFree(VRAMRegion *region)
@@ -57,6 +100,9 @@ u16 VRAM_getFree(VRAMRegion *region)
     u16 bsize;
     u16 res;
 
+    if (region->allocator == VRAM_ALLOC_SEGREGATED)
+        return region->numFreeTile;
+
     b = region->vram;
     res = 0;
 
@@ -82,6 +128,31 @@ u16 VRAM_getLargestFreeBlock(VRAMRegion *region)
     u16 bsize;
     u16 res;
 
+    if (region->allocator == VRAM_ALLOC_SEGREGATED)
+    {
+        u16 mask = region->classMask;
+        u16 c;
+        u16 ind;
+
+        // no free block
+        if (!mask) return 0;
+
+        // largest blocks are in the highest non empty class
+        c = VRAM_NUM_CLASS - 1;
+        while(!(mask & (1 << c))) c--;
+
+        res = 0;
+        ind = region->classHead[c];
+        while(ind != NO_BLOCK)
+        {
+            bsize = region->vram[ind];
+            if (bsize > res) res = bsize;
+            ind = region->links[ind];
+        }
+
+        return res;
+    }
+
     b = region->vram;
     res = 0;
 
@@ -109,6 +180,9 @@ u16 VRAM_getAllocated(VRAMRegion *region)
     u16 bsize;
     u16 res;
 
+    if (region->allocator == VRAM_ALLOC_SEGREGATED)
+        return ((region->endIndex - region->startIndex) + 1) - region->numFreeTile;
+
     b = region->vram;
     res = 0;
 
@@ -132,6 +206,41 @@ u16 VRAM_getAllocated(VRAMRegion *region)
     return res;
 }
 
+u16 VRAM_getNumFreeBlock(VRAMRegion *region)
+{
+    u16 num;
+    u16 largest;
+
+    if (region->allocator == VRAM_ALLOC_SEGREGATED)
+        return region->numFreeBlock;
+
+    getFreeRuns(region, &num, &largest);
+
+    return num;
+}
+
+u16 VRAM_getFragmentation(VRAMRegion *region)
+{
+    u16 num;
+    u16 largest;
+    u16 free;
+
+    if (region->allocator == VRAM_ALLOC_SEGREGATED)
+    {
+        free = region->numFreeTile;
+        largest = VRAM_getLargestFreeBlock(region);
+    }
+    else
+    {
+        free = VRAM_getFree(region);
+        getFreeRuns(region, &num, &largest);
+    }
+
+    if (!free) return 0;
+
+    return 100 - (u16) ((((u32) largest) * 100) / free);
+}
+
 s16 VRAM_alloc(VRAMRegion *region, u16 size)
 {
     u16* p;
@@ -139,6 +248,9 @@ s16 VRAM_alloc(VRAMRegion *region, u16 size)
     u16 remaining;
     s16 result;
 
+    if (region->allocator == VRAM_ALLOC_SEGREGATED)
+        return allocSegregated(region, size);
+
     // cache free pointer
     free = region->free;
 
@@ -200,13 +312,91 @@ s16 VRAM_alloc(VRAMRegion *region, u16 size)
     return result;
 }
 
+s16 VRAM_allocBelow(VRAMRegion *region, u16 size, u16 index)
+{
+    u16 *b;
+    u16 *run;
+    u16 *end;
+    u16 *free;
+    u16 bsize;
+    u16 rsize;
+    s16 result;
+
+    // allocation should end before index
+    if (index <= region->startIndex) return -1;
+    if (index > region->endIndex) end = region->vram + ((region->endIndex - region->startIndex) + 1);
+    else end = region->vram + (index - region->startIndex);
+
+    b = region->vram;
+    run = b;
+    rsize = 0;
+
+    // find first free run (adjacent free blocks merged) large enough
+    while ((b < end) && (bsize = *b))
+    {
+        if (bsize & USED_MASK)
+        {
+            rsize = 0;
+            b += bsize & SIZE_MASK;
+            run = b;
+        }
+        else
+        {
+            rsize += bsize;
+            b += bsize;
+
+            if (rsize >= size) break;
+        }
+    }
+
+    // not found or allocation would go after index
+    if ((rsize < size) || ((run + size) > end)) return -1;
+
+    if (region->allocator == VRAM_ALLOC_SEGREGATED)
+        // free blocks are always merged here so run is a single free block
+        useBlock(region, run - region->vram, rsize, size);
+    else
+    {
+        // set block size and mark as used
+        *run = size | USED_MASK;
+        if (rsize > size) run[size] = rsize - size;
+
+        // free pointer was in the allocated run ? --> fix it
+        free = region->free;
+        if ((free >= run) && (free < (run + rsize)))
+        {
+            free = run + size;
+
+            // no more space in run --> find next free block
+            if (rsize == size)
+            {
+                while((bsize = *free) & USED_MASK)
+                    free += bsize & SIZE_MASK;
+            }
+
+            region->free = free;
+        }
+    }
+
+    result = (run - region->vram) + region->startIndex;
+
+#if (LIB_DEBUG != 0)
+    KLog_U3("VRAM_allocBelow(", size, ") success: ", result, " - remaining = ", VRAM_getFree(region));
+#endif
+
+    return result;
+}
+
 void VRAM_free(VRAMRegion *region, u16 index)
 {
     const s16 adjInd = index - region->startIndex;
 
     // inside region ? --> free block
     if ((adjInd >= 0) && (index <= region->endIndex))
-        region->vram[adjInd] &= ~USED_MASK;
+    {
+        if (region->allocator == VRAM_ALLOC_SEGREGATED) freeSegregated(region, adjInd);
+        else region->vram[adjInd] &= ~USED_MASK;
+    }
 
 #if (LIB_DEBUG != 0)
     KLog_U2("VRAM_free(", index, ") --> remaining = ", VRAM_getFree(region));
@@ -261,3 +451,249 @@ static u16* pack(VRAMRegion *region, u16 nsize)
 
     return NULL;
 }
+
+/*
+ * Get number of free block and largest free block (adjacent free blocks are counted as a single block)
+ */
+static void getFreeRuns(VRAMRegion *region, u16 *num, u16 *largest)
+{
+    u16 *b;
+    u16 bsize;
+    u16 run;
+    u16 n;
+    u16 res;
+
+    b = region->vram;
+    run = 0;
+    n = 0;
+    res = 0;
+
+    while ((bsize = *b))
+    {
+        if (bsize & USED_MASK)
+        {
+            // end of free run
+            if (run)
+            {
+                if (run > res) res = run;
+                n++;
+                run = 0;
+            }
+
+            b += bsize & SIZE_MASK;
+        }
+        else
+        {
+            run += bsize;
+            b += bsize;
+        }
+    }
+
+    // last free run
+    if (run)
+    {
+        if (run > res) res = run;
+        n++;
+    }
+
+    *num = n;
+    *largest = res;
+}
+
+
+/*
+ * Segregated fit allocator
+ *
+ * Each block has its header (size | used flag) in its first and last entry so both neighbours can be merged on release.
+ * Free blocks are stored in doubly linked lists by size class: class n contains blocks of [2^n, 2^(n+1)[ tiles.
+ */
+
+static u16 getClass(u16 size)
+{
+    u16 c = 0;
+
+    // floor(log2(size))
+    if (size & 0xFF00)
+    {
+        size >>= 8;
+        c += 8;
+    }
+    if (size & 0x00F0)
+    {
+        size >>= 4;
+        c += 4;
+    }
+    if (size & 0x000C)
+    {
+        size >>= 2;
+        c += 2;
+    }
+    if (size & 0x0002) c++;
+
+    return c;
+}
+
+static void insertBlock(VRAMRegion *region, u16 ind, u16 size)
+{
+    u16 *next = region->links;
+    u16 *prev = next + ((region->endIndex - region->startIndex) + 1);
+    const u16 c = getClass(size);
+    const u16 head = region->classHead[c];
+
+    // insert at head of class list
+    next[ind] = head;
+    prev[ind] = NO_BLOCK;
+    if (head != NO_BLOCK) prev[head] = ind;
+    region->classHead[c] = ind;
+    region->classMask |= 1 << c;
+    region->numFreeBlock++;
+}
+
+static void removeBlock(VRAMRegion *region, u16 ind, u16 size)
+{
+    u16 *next = region->links;
+    u16 *prev = next + ((region->endIndex - region->startIndex) + 1);
+    const u16 n = next[ind];
+    const u16 p = prev[ind];
+
+    if (p != NO_BLOCK) next[p] = n;
+    else
+    {
+        const u16 c = getClass(size);
+
+        region->classHead[c] = n;
+        // class is now empty
+        if (n == NO_BLOCK) region->classMask &= ~(1 << c);
+    }
+    if (n != NO_BLOCK) prev[n] = p;
+
+    region->numFreeBlock--;
+}
+
+static s16 allocSegregated(VRAMRegion *region, u16 size)
+{
+    u16 *vram = region->vram;
+    u16 c;
+    u16 mask;
+    u16 ind;
+    u16 bsize;
+    s16 result;
+
+    c = getClass(size);
+    // not a power of 2 ? --> all blocks of the next class are large enough
+    if (size & (size - 1)) c++;
+
+    mask = region->classMask >> c;
+
+    if (mask)
+    {
+        // smallest non empty class which fits
+        while(!(mask & 1))
+        {
+            mask >>= 1;
+            c++;
+        }
+
+        ind = region->classHead[c];
+        bsize = vram[ind];
+    }
+    else
+    {
+        // last chance: blocks of the size class may be large enough
+        ind = region->classHead[getClass(size)];
+        while((ind != NO_BLOCK) && (vram[ind] < size)) ind = region->links[ind];
+
+        // no enough memory
+        if (ind == NO_BLOCK)
+        {
+#if (LIB_DEBUG != 0)
+            if (size > region->numFreeTile)
+                KLog_U2_("VRAM_alloc(", size, ") failed: no enough free tile in VRAM (free = ", region->numFreeTile, ")");
+            else
+                KLog_U3_("VRAM_alloc(", size, ") failed: cannot find a big enough VRAM tile block (largest free block = ", VRAM_getLargestFreeBlock(region), " - free = ", region->numFreeTile, ")");
+#endif
+
+            return -1;
+        }
+
+        bsize = vram[ind];
+    }
+
+    useBlock(region, ind, bsize, size);
+
+    // get index position in VRAM region
+    result = ind + region->startIndex;
+
+#if (LIB_DEBUG != 0)
+    KLog_U3("VRAM_alloc(", size, ") success: ", result, " - remaining = ", region->numFreeTile);
+#endif
+
+    return result;
+}
+
+static void useBlock(VRAMRegion *region, u16 ind, u16 bsize, u16 size)
+{
+    u16 *vram = region->vram;
+
+    removeBlock(region, ind, bsize);
+
+    // split block and put back the remaining part in free lists
+    if (bsize > size)
+    {
+        const u16 rind = ind + size;
+        const u16 rsize = bsize - size;
+
+        vram[rind] = rsize;
+        vram[rind + (rsize - 1)] = rsize;
+        insertBlock(region, rind, rsize);
+    }
+
+    // set block header and boundary tag, mark as used
+    vram[ind] = size | USED_MASK;
+    vram[ind + (size - 1)] = size | USED_MASK;
+    region->numFreeTile -= size;
+}
+
+static void freeSegregated(VRAMRegion *region, u16 ind)
+{
+    u16 *vram = region->vram;
+    u16 size = vram[ind];
+    u16 nsize;
+    u16 psize;
+
+    // not an allocated block ? --> ignore
+    if (!(size & USED_MASK))
+    {
+#if (LIB_DEBUG != 0)
+        KLog_U1("VRAM_free(..) failed: no allocated block at ", ind + region->startIndex);
+#endif
+
+        return;
+    }
+
+    size &= SIZE_MASK;
+    region->numFreeTile += size;
+
+    // merge with next block if free (end of region marker is 0)
+    nsize = vram[ind + size];
+    if (nsize && !(nsize & USED_MASK))
+    {
+        removeBlock(region, ind + size, nsize);
+        size += nsize;
+    }
+    // merge with previous block if free (use its boundary tag)
+    if (ind)
+    {
+        psize = vram[ind - 1];
+        if (!(psize & USED_MASK))
+        {
+            ind -= psize;
+            removeBlock(region, ind, psize);
+            size += psize;
+        }
+    }
+
+    vram[ind] = size;
+    vram[ind + (size - 1)] = size;
+    insertBlock(region, ind, size);
+}
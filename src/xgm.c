@@ -12,13 +12,24 @@
 #include "bmp.h"
 #include "vdp_tile.h"
 #include "libres.h"
+#include "prof.h"
 
 
+// BUS requests from this unit are identified in Z80 BUS statistics
+#define Z80_requestBus(wait)    Z80_requestBusEx(wait, Z80_BUS_XGM)
+
 // allow to access it without "public" share
 extern vu32 VIntProcess;
 extern s16 currentDriver;
 extern u16 driverFlags;
 
+#if (Z80_BUS_STATS != 0)
+// used for BUS statistics of fast BUS request methods (we don't want to share them)
+extern void Z80_statsBusTaken(u16 requester);
+extern void Z80_statsBusReleased();
+extern void Z80_statsProtect(u16 value);
+#endif
+
 // specific for the XGM driver
 static u16 xgmTempo;
 static u16 xgmTempoDef;
@@ -32,6 +43,21 @@ static u16 xgmTabInd;
 static u16 xgmIdleMean;
 static u16 xgmWaitMean;
 
+// PCM underrun (driver only has a 8 bit counter)
+static u8 xgmUnderrunLast;
+static u16 xgmUnderrunFrame;
+static u32 xgmUnderrun;
+
+// command mailbox: PCM commands are sent and status is read back on XGM frame process
+static u16 xgmCmdPCM;
+static u8 xgmCmdPCMArg[4 * 2];
+static vu8 xgmStatus;
+
+
+static void updatePCMUnderrun();
+static void flushMailbox();
+static void queuePCM(const u8 id, const u8 priority, const u16 channel);
+
 
 // Z80_DRIVER_XGM
 // XGM driver
@@ -39,27 +65,16 @@ static u16 xgmWaitMean;
 
 u8 XGM_isPlaying()
 {
-    vu8 *pb;
-    u8 ret;
-
-    // disable ints when requesting Z80 BUS
-    SYS_disableInts();
-
     // load the appropriate driver if not already done
-    Z80_loadDriver(Z80_DRIVER_XGM, TRUE);
-
-    // point to Z80 status
-    pb = (u8 *) Z80_DRV_STATUS;
-
-    Z80_requestBus(TRUE);
-    // play status
-    ret = *pb & (1 << 6);
-    Z80_releaseBus();
-
-    // re-enable ints
-    SYS_enableInts();
+    if (currentDriver != Z80_DRIVER_XGM)
+    {
+        SYS_disableInts();
+        Z80_loadDriver(Z80_DRIVER_XGM, TRUE);
+        SYS_enableInts();
+    }
 
-    return ret;
+    // cached status (updated on XGM frame process)
+    return xgmStatus & (1 << 6);
 }
 
 void XGM_startPlay(const u8 *song)
@@ -129,6 +144,9 @@ void XGM_startPlay(const u8 *song)
 
     Z80_releaseBus();
 
+    // music status is refreshed on next XGM frame process
+    xgmStatus |= 1 << 6;
+
     // re-enable ints
     SYS_enableInts();
 }
@@ -170,6 +188,9 @@ void XGM_stopPlay()
 
     Z80_releaseBus();
 
+    // music status is refreshed on next XGM frame process
+    xgmStatus &= ~(1 << 6);
+
     // re-enable ints
     SYS_enableInts();
 }
@@ -227,28 +248,16 @@ void XGM_resumePlay()
 
 u8 XGM_isPlayingPCM(const u16 channel_mask)
 {
-    vu8 *pb;
-    u8 ret;
-
-    // disable ints when requesting Z80 BUS
-    SYS_disableInts();
-
     // load the appropriate driver if not already done
-    Z80_loadDriver(Z80_DRIVER_XGM, TRUE);
-
-    Z80_requestBus(TRUE);
-
-    // point to Z80 status
-    pb = (u8 *) Z80_DRV_STATUS;
-    // play status
-    ret = *pb & (channel_mask << Z80_DRV_STAT_PLAYING_SFT);
-
-    Z80_releaseBus();
-
-    // re-enable ints
-    SYS_enableInts();
+    if (currentDriver != Z80_DRIVER_XGM)
+    {
+        SYS_disableInts();
+        Z80_loadDriver(Z80_DRIVER_XGM, TRUE);
+        SYS_enableInts();
+    }
 
-    return ret;
+    // cached status (updated on XGM frame process and by pending commands)
+    return xgmStatus & (channel_mask << Z80_DRV_STAT_PLAYING_SFT);
 }
 
 void XGM_setPCM(const u8 id, const u8 *sample, const u32 len)
@@ -285,62 +294,13 @@ void XGM_setPCMFast(const u8 id, const u8 *sample, const u32 len)
 
 void XGM_startPlayPCM(const u8 id, const u8 priority, const u16 channel)
 {
-    vu8 *pb;
-
-    // disable ints when requesting Z80 BUS
-    SYS_disableInts();
-
-    // load the appropriate driver if not already done
-    Z80_loadDriver(Z80_DRIVER_XGM, TRUE);
-
-    Z80_requestBus(TRUE);
-
-    // point to Z80 PCM parameters
-    pb = (u8 *) (Z80_DRV_PARAMS + 0x04 + (channel * 2));
-
-    // set PCM priority and id
-    pb[0x00] = priority & 0xF;
-    pb[0x01] = id;
-
-    // point to Z80 command
-    pb = (u8 *) Z80_DRV_COMMAND;
-    // set play PCM channel command
-    *pb |= (Z80_DRV_COM_PLAY << channel);
-
-    Z80_releaseBus();
-
-    // re-enable ints
-    SYS_enableInts();
+    queuePCM(id, priority & 0xF, channel);
 }
 
 void XGM_stopPlayPCM(const u16 channel)
 {
-    vu8 *pb;
-
-    // disable ints when requesting Z80 BUS
-    SYS_disableInts();
-
-    // load the appropriate driver if not already done
-    Z80_loadDriver(Z80_DRIVER_XGM, TRUE);
-
-    Z80_requestBus(TRUE);
-
-    // point to Z80 PCM parameters
-    pb = (u8 *) (Z80_DRV_PARAMS + 0x04 + (channel * 2));
-
     // use silent PCM (id = 0) with maximum priority
-    pb[0x00] = 0xF;
-    pb[0x01] = 0;
-
-    // point to Z80 command
-    pb = (u8 *) Z80_DRV_COMMAND;
-    // set play PCM channel command
-    *pb |= (Z80_DRV_COM_PLAY << channel);
-
-    Z80_releaseBus();
-
-    // re-enable ints
-    SYS_enableInts();
+    queuePCM(0, 0xF, channel);
 }
 
 void XGM_setLoopNumber(s8 value)
@@ -392,6 +352,10 @@ void XGM_set68KBUSProtection(u8 value)
 
     // release bus
     *pw_bus = 0x0000;
+
+#if (Z80_BUS_STATS != 0)
+    Z80_statsProtect(value);
+#endif
 }
 
 void XGM_nextXFrame(u16 num)
@@ -416,9 +380,17 @@ void XGM_nextXFrame(u16 num)
         // wait for bus taken
         while (*pw_bus & 0x0100);
 
+#if (Z80_BUS_STATS != 0)
+        Z80_statsBusTaken(Z80_BUS_XGM_FRAME);
+#endif
+
         // Z80 not accessing ?
         if (!*pb) break;
 
+#if (Z80_BUS_STATS != 0)
+        Z80_statsBusReleased();
+#endif
+
         // release bus
         *pw_bus = 0x0000;
 
@@ -435,6 +407,13 @@ void XGM_nextXFrame(u16 num)
     // increment frame to process
     *pb += num;
 
+    flushMailbox();
+    updatePCMUnderrun();
+
+#if (Z80_BUS_STATS != 0)
+    Z80_statsBusReleased();
+#endif
+
     // release bus
     *pw_bus = 0x0000;
 }
@@ -580,6 +559,22 @@ u32 XGM_getCPULoad()
     return load | ((xgmWaitMean >> 5) << 16);
 }
 
+u32 XGM_getPCMUnderrun()
+{
+    return xgmUnderrun;
+}
+
+u16 XGM_getFramePCMUnderrun()
+{
+    return xgmUnderrunFrame;
+}
+
+void XGM_resetPCMUnderrun()
+{
+    xgmUnderrun = 0;
+    xgmUnderrunFrame = 0;
+}
+
 void XGM_resetLoadCalculation()
 {
     u16 i;
@@ -598,6 +593,16 @@ void XGM_resetLoadCalculation()
     xgmTabInd = 0;
     xgmIdleMean = 0;
     xgmWaitMean = 0;
+
+    // driver counter is cleared on driver load
+    xgmUnderrunLast = 0;
+    XGM_resetPCMUnderrun();
+}
+
+void XGM_resetMailbox()
+{
+    xgmCmdPCM = 0;
+    xgmStatus = 0;
 }
 
 // VInt processing for XGM driver
@@ -610,6 +615,8 @@ void XGM_doVBlankProcess()
     u16 step = xgmTempoDef;
     u16 num = 0;
 
+    PROF_begin("XGM vblank");
+
     while(cnt <= 0)
     {
         num++;
@@ -635,9 +642,17 @@ void XGM_doVBlankProcess()
         // wait for bus taken
         while (*pw_bus & 0x100);
 
+#if (Z80_BUS_STATS != 0)
+        Z80_statsBusTaken(Z80_BUS_XGM_FRAME);
+#endif
+
         // Z80 not accessing ?
         if (!*pb) break;
 
+#if (Z80_BUS_STATS != 0)
+        Z80_statsBusReleased();
+#endif
+
         // release bus
         *pw_bus = 0x0000;
 
@@ -654,6 +669,103 @@ void XGM_doVBlankProcess()
     // increment frame to process
     *pb += num;
 
+    flushMailbox();
+    updatePCMUnderrun();
+
+#if (Z80_BUS_STATS != 0)
+    Z80_statsBusReleased();
+#endif
+
     // release bus
     *pw_bus = 0x0000;
+
+    PROF_end();
+}
+
+// Z80 BUS should be taken here
+static void updatePCMUnderrun()
+{
+    // point to Z80 PCM underrun counter
+    const u8 cnt = *((vu8 *) (Z80_DRV_PARAMS + 0x8C));
+    const u8 delta = cnt - xgmUnderrunLast;
+
+    xgmUnderrunLast = cnt;
+    xgmUnderrunFrame = delta;
+    xgmUnderrun += delta;
+}
+
+// Z80 BUS should be taken here
+static void flushMailbox()
+{
+    vu8 *pb;
+    const u8 *src;
+    const u16 mask = xgmCmdPCM;
+    u8 status;
+
+    // get driver status
+    status = *((vu8 *) Z80_DRV_STATUS);
+
+    if (mask)
+    {
+        u16 ch;
+
+        // point to Z80 PCM parameters
+        pb = (u8 *) (Z80_DRV_PARAMS + 0x04);
+        src = xgmCmdPCMArg;
+
+        for(ch = 0; ch < 4; ch++)
+        {
+            if (mask & (Z80_DRV_COM_PLAY << ch))
+            {
+                // set PCM priority and id
+                pb[0x00] = src[0];
+                pb[0x01] = src[1];
+
+                // pending command not yet processed by the driver
+                if (src[1]) status |= Z80_DRV_STAT_PLAYING << ch;
+                else status &= ~(Z80_DRV_STAT_PLAYING << ch);
+            }
+
+            pb += 2;
+            src += 2;
+        }
+
+        // set play PCM channel command
+        *((vu8 *) Z80_DRV_COMMAND) |= mask;
+
+        xgmCmdPCM = 0;
+    }
+
+    xgmStatus = status;
+}
+
+static void queuePCM(const u8 id, const u8 priority, const u16 channel)
+{
+    u8 *arg;
+    u16 cmd;
+
+    // disable ints as mailbox is sent from V-Int
+    SYS_disableInts();
+
+    // load the appropriate driver if not already done
+    Z80_loadDriver(Z80_DRIVER_XGM, TRUE);
+
+    arg = &xgmCmdPCMArg[channel * 2];
+    cmd = Z80_DRV_COM_PLAY << channel;
+
+    // command already pending for this channel ? keep the highest priority one (as the driver does)
+    // except for pending stop which is always replaced
+    if (!(xgmCmdPCM & cmd) || (arg[1] == 0) || (priority >= arg[0]))
+    {
+        arg[0] = priority;
+        arg[1] = id;
+        xgmCmdPCM |= cmd;
+
+        // status is refreshed on next XGM frame process
+        if (id) xgmStatus |= Z80_DRV_STAT_PLAYING << channel;
+        else xgmStatus &= ~(Z80_DRV_STAT_PLAYING << channel);
+    }
+
+    // re-enable ints
+    SYS_enableInts();
 }
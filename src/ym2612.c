@@ -14,7 +14,7 @@ void YM2612_reset()
 
     bus_taken = Z80_isBusTaken();
     if (!bus_taken)
-        Z80_requestBus(TRUE);
+        Z80_requestBusEx(TRUE, Z80_BUS_SOUND);
 
     // enable left and right output for all channel
     for(i = 0; i < 3; i++)
@@ -11,6 +11,10 @@
 #include "vdp.h"
 #include "sound.h"
 #include "xgm.h"
+#include "prof.h"
+#include "string.h"
+#include "tools.h"
+#include "kdebug.h"
 
 // Z80 drivers
 #include "z80_drv1.h"
@@ -36,6 +40,49 @@ u16 driverFlags;
 
 // we don't want to share it
 extern void XGM_resetLoadCalculation();
+extern void XGM_resetMailbox();
+
+
+#if (Z80_BUS_STATS != 0)
+
+#define NO_HOLDER       0xFFFF
+
+// BUS statistics for a requester (time in 1/256 scanline, see PROF_getTime())
+typedef struct
+{
+    u32 count;
+    u32 time;
+    u16 frameCount;
+    u32 frameTime;
+    u16 lastCount;
+    u32 lastTime;
+    u16 maxCount;
+    u32 maxTime;
+    u16 countHisto[Z80_BUS_HISTO_SIZE];
+    u16 timeHisto[Z80_BUS_HISTO_SIZE];
+} BusStats;
+
+static BusStats busStats[Z80_BUS_REQUESTER_NUM];
+// current BUS holder and hold start time
+static u16 holder;
+static u32 holdStart;
+// protection start time
+static u16 protecting;
+static u32 protectStart;
+// frame of current statistics
+static u32 statsFrame;
+
+static void commitFrame();
+static void addHold(u16 requester, u32 time);
+static u16 countToHisto(u16 count);
+static u16 timeToHisto(u32 time);
+
+// used by xgm.c (fast BUS request methods) so we don't want to share it
+void Z80_statsBusTaken(u16 requester);
+void Z80_statsBusReleased();
+void Z80_statsProtect(u16 value);
+
+#endif // Z80_BUS_STATS
 
 
 void Z80_init()
@@ -48,6 +95,9 @@ void Z80_init()
     // no loaded driver
     currentDriver = Z80_DRIVER_NULL;
     driverFlags = 0;
+
+    // BUS is kept until a driver is loaded, don't count it
+    Z80_resetBusStats();
 }
 
 
@@ -61,6 +111,11 @@ u16 Z80_isBusTaken()
 }
 
 void Z80_requestBus(u16 wait)
+{
+    Z80_requestBusEx(wait, Z80_BUS_USER);
+}
+
+void Z80_requestBusEx(u16 wait, u16 requester)
 {
     vu16 *pw_bus;
     vu16 *pw_reset;
@@ -78,12 +133,20 @@ void Z80_requestBus(u16 wait)
         // wait for bus taken
         while (*pw_bus & 0x0100);
     }
+
+#if (Z80_BUS_STATS != 0)
+    Z80_statsBusTaken(requester);
+#endif
 }
 
 void Z80_releaseBus()
 {
     vu16 *pw;
 
+#if (Z80_BUS_STATS != 0)
+    Z80_statsBusReleased();
+#endif
+
     pw = (u16 *) Z80_HALT_PORT;
     *pw = 0x0000;
 }
@@ -408,6 +471,8 @@ void Z80_loadDriver(const u16 driver, const u16 waitReady)
             SND_setMusicTempo_XGM(60);
             // reset load calculation
             XGM_resetLoadCalculation();
+            // clear pending commands and cached status
+            XGM_resetMailbox();
             break;
     }
 }
@@ -447,3 +512,273 @@ u16 Z80_isDriverReady()
 
     return ret;
 }
+
+
+#if (Z80_BUS_STATS != 0)
+
+void Z80_getBusStats(u16 requester, Z80BusStats *stats)
+{
+    BusStats *bs;
+    u16 level;
+
+    if (requester >= Z80_BUS_REQUESTER_NUM)
+    {
+        memset(stats, 0, sizeof(Z80BusStats));
+        return;
+    }
+
+    bs = &busStats[requester];
+
+    level = SYS_getAndSetInterruptMaskLevel(7);
+
+    // last frame is complete ?
+    if (statsFrame != vtimer) commitFrame();
+
+    stats->count = bs->count;
+    stats->time = PROF_timeToCycles(bs->time);
+    stats->frameCount = bs->lastCount;
+    stats->frameTime = PROF_timeToCycles(bs->lastTime);
+    stats->maxFrameCount = bs->maxCount;
+    stats->maxFrameTime = PROF_timeToCycles(bs->maxTime);
+    memcpy(stats->countHisto, bs->countHisto, sizeof(bs->countHisto));
+    memcpy(stats->timeHisto, bs->timeHisto, sizeof(bs->timeHisto));
+
+    SYS_setInterruptMaskLevel(level);
+}
+
+void Z80_resetBusStats()
+{
+    u16 level;
+
+    level = SYS_getAndSetInterruptMaskLevel(7);
+
+    memset(busStats, 0, sizeof(busStats));
+    holder = NO_HOLDER;
+    protecting = FALSE;
+    statsFrame = vtimer;
+
+    SYS_setInterruptMaskLevel(level);
+}
+
+void Z80_dumpBusStats()
+{
+    static const char *names[Z80_BUS_REQUESTER_NUM] = { "User", "Sound", "XGM", "XGM frame", "DMA", "Protect" };
+    char str[80];
+    char *dst;
+    Z80BusStats stats;
+    u16 i, j;
+
+    KLog("Z80 BUS stats (count / 68000 cycles) --------");
+
+    for(i = 0; i < Z80_BUS_REQUESTER_NUM; i++)
+    {
+        Z80_getBusStats(i, &stats);
+
+        // never requested
+        if (stats.count == 0) continue;
+
+        strcpy(str, names[i]);
+        KLog(str);
+        KLog_U2("  total count: ", stats.count, "  total time: ", stats.time);
+        KLog_U4("  frame count: ", stats.frameCount, " max: ", stats.maxFrameCount, "  frame time: ", stats.frameTime, " max: ", stats.maxFrameTime);
+
+        dst = str;
+        strcpy(dst, "  count histo:");
+        for(j = 0; j < Z80_BUS_HISTO_SIZE; j++)
+        {
+            dst += strlen(dst);
+            *dst++ = ' ';
+            uintToStr(stats.countHisto[j], dst, 1);
+        }
+        KLog(str);
+
+        dst = str;
+        strcpy(dst, "  time histo: ");
+        for(j = 0; j < Z80_BUS_HISTO_SIZE; j++)
+        {
+            dst += strlen(dst);
+            *dst++ = ' ';
+            uintToStr(stats.timeHisto[j], dst, 1);
+        }
+        KLog(str);
+    }
+
+    if (currentDriver == Z80_DRIVER_XGM)
+        KLog_U2("XGM PCM underrun: ", XGM_getPCMUnderrun(), "  last frame: ", XGM_getFramePCMUnderrun());
+}
+
+
+void Z80_statsBusTaken(u16 requester)
+{
+    BusStats *bs = &busStats[requester];
+    u16 level;
+
+    level = SYS_getAndSetInterruptMaskLevel(7);
+
+    if (statsFrame != vtimer) commitFrame();
+
+    bs->count++;
+    bs->frameCount++;
+
+    // BUS already taken (nested request) --> only count it
+    if (holder == NO_HOLDER)
+    {
+        holder = requester;
+        holdStart = PROF_getTime();
+    }
+
+    SYS_setInterruptMaskLevel(level);
+}
+
+void Z80_statsBusReleased()
+{
+    u16 level;
+
+    // BUS not taken through Z80_requestBus(..)
+    if (holder == NO_HOLDER) return;
+
+    level = SYS_getAndSetInterruptMaskLevel(7);
+
+    if (statsFrame != vtimer) commitFrame();
+
+    addHold(holder, PROF_getTime() - holdStart);
+    holder = NO_HOLDER;
+
+    SYS_setInterruptMaskLevel(level);
+}
+
+void Z80_statsProtect(u16 value)
+{
+    BusStats *bs = &busStats[Z80_BUS_PROTECT];
+    u16 level;
+
+    // no change
+    if ((value?TRUE:FALSE) == protecting) return;
+
+    level = SYS_getAndSetInterruptMaskLevel(7);
+
+    if (statsFrame != vtimer) commitFrame();
+
+    if (value)
+    {
+        bs->count++;
+        bs->frameCount++;
+        protectStart = PROF_getTime();
+        protecting = TRUE;
+    }
+    else
+    {
+        addHold(Z80_BUS_PROTECT, PROF_getTime() - protectStart);
+        protecting = FALSE;
+    }
+
+    SYS_setInterruptMaskLevel(level);
+}
+
+
+static void commitFrame()
+{
+    BusStats *bs;
+    u32 skipped;
+    u16 i;
+
+    // frames without any BUS request since last commit
+    skipped = vtimer - (statsFrame + 1);
+    if (skipped > 0xFFFF) skipped = 0xFFFF;
+
+    bs = busStats;
+    i = Z80_BUS_REQUESTER_NUM;
+    while(i--)
+    {
+        const u16 cnt = bs->frameCount;
+        const u32 t = bs->frameTime;
+        u16 *h;
+        u32 v;
+
+        bs->lastCount = cnt;
+        bs->lastTime = t;
+        if (cnt > bs->maxCount) bs->maxCount = cnt;
+        if (t > bs->maxTime) bs->maxTime = t;
+
+        h = &bs->countHisto[countToHisto(cnt)];
+        if (*h != 0xFFFF) (*h)++;
+        h = &bs->timeHisto[timeToHisto(t)];
+        if (*h != 0xFFFF) (*h)++;
+
+        if (skipped)
+        {
+            v = bs->countHisto[0] + skipped;
+            bs->countHisto[0] = (v > 0xFFFF)?0xFFFF:v;
+            v = bs->timeHisto[0] + skipped;
+            bs->timeHisto[0] = (v > 0xFFFF)?0xFFFF:v;
+            bs->lastCount = 0;
+            bs->lastTime = 0;
+        }
+
+        bs->frameCount = 0;
+        bs->frameTime = 0;
+        bs++;
+    }
+
+    statsFrame = vtimer;
+}
+
+static void addHold(u16 requester, u32 time)
+{
+    BusStats *bs = &busStats[requester];
+
+    bs->time += time;
+    bs->frameTime += time;
+}
+
+static u16 countToHisto(u16 count)
+{
+    u16 res;
+    u16 c;
+
+    if (count == 0) return 0;
+
+    // 1 + log2(count)
+    res = 1;
+    c = count;
+    while((c >>= 1) && (res < (Z80_BUS_HISTO_SIZE - 1))) res++;
+
+    return res;
+}
+
+static u16 timeToHisto(u32 time)
+{
+    u16 res;
+    u32 lines;
+
+    if (time == 0) return 0;
+
+    // less than 1 scanline
+    lines = time >> 8;
+    if (lines == 0) return 1;
+
+    // 2 + log2(lines)
+    res = 2;
+    while((lines >>= 1) && (res < (Z80_BUS_HISTO_SIZE - 1))) res++;
+
+    return res;
+}
+
+#else
+
+void Z80_getBusStats(u16 requester, Z80BusStats *stats)
+{
+    memset(stats, 0, sizeof(Z80BusStats));
+}
+
+void Z80_resetBusStats()
+{
+
+}
+
+void Z80_dumpBusStats()
+{
+
+}
+
+#endif // Z80_BUS_STATS
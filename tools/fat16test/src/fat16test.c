@@ -0,0 +1,358 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "types.h"
+#include "fat16.h"
+
+#include "mmcfile.h"
+
+
+// disk image geometry (fat16.c expects 512 bytes sectors and 512 root entries)
+#define SECTOR_SIZE         512
+#define SECTOR_PER_CLUSTER  4
+#define RESERVED_SECTORS    1
+#define FAT_COPIES          2
+#define ROOT_ENTRIES        512
+#define TOTAL_SECTORS       20000
+#define CLUSTER_NUM         (TOTAL_SECTORS / SECTOR_PER_CLUSTER)
+#define FAT_SECTORS         ((((CLUSTER_NUM + 2) * 2) + (SECTOR_SIZE - 1)) / SECTOR_SIZE)
+#define ROOT_SECTOR         (RESERVED_SECTORS + (FAT_COPIES * FAT_SECTORS))
+#define DATA_SECTOR         (ROOT_SECTOR + ((ROOT_ENTRIES * 32) / SECTOR_SIZE))
+#define CLUSTER_SIZE        (SECTOR_SIZE * SECTOR_PER_CLUSTER)
+
+#define MAX_EXTENT          256
+#define MAX_READ            300
+
+
+typedef struct
+{
+    const char *name;
+    unsigned int size;
+    int fragmented;
+    unsigned int cluster;
+} TestFile;
+
+static TestFile files[] =
+{
+    {"CONTIG  BIN", 10000, 0, 0},
+    {"FRAG    BIN", 1500000, 1, 0},
+    {"PARTIAL BIN", (5 * CLUSTER_SIZE) + 300, 1, 0},
+    {"SMALL   BIN", 100, 0, 0},
+    {"EMPTY   BIN", 0, 0, 0}
+};
+
+#define FILE_NUM    (sizeof(files) / sizeof(TestFile))
+
+
+static unsigned char *image;
+static unsigned short *fat;
+static unsigned char *readBuffer;
+static unsigned int seed = 1;
+
+
+static unsigned int rnd()
+{
+    seed = (seed * 1103515245) + 12345;
+    return (seed >> 16) & 0x7FFF;
+}
+
+// known content of file data
+static unsigned char fileData(unsigned int file, unsigned int offset)
+{
+    unsigned int v = (offset * 2654435761u) ^ ((file + 1) * 40503);
+    return (v >> 13) ^ offset;
+}
+
+static void setWord(unsigned char *dst, unsigned int value)
+{
+    dst[0] = value;
+    dst[1] = value >> 8;
+}
+
+static void setLong(unsigned char *dst, unsigned int value)
+{
+    setWord(dst, value);
+    setWord(dst + 2, value >> 16);
+}
+
+static void addFile(unsigned int index, unsigned int *nextCluster)
+{
+    TestFile *file = &files[index];
+    unsigned char *entry = &image[(ROOT_SECTOR * SECTOR_SIZE) + (index * 32)];
+    unsigned int remain = (file->size + (CLUSTER_SIZE - 1)) / CLUSTER_SIZE;
+    unsigned int prev = 0;
+    unsigned int offset = 0;
+
+    file->cluster = 0;
+
+    while (remain)
+    {
+        // fragmented file: short cluster runs separated by free gaps
+        unsigned int run = file->fragmented ? (1 + (rnd() % 6)) : remain;
+
+        if (run > remain) run = remain;
+        remain -= run;
+
+        while (run--)
+        {
+            unsigned int cluster = (*nextCluster)++;
+            unsigned char *dst = &image[(DATA_SECTOR + ((cluster - 2) * SECTOR_PER_CLUSTER)) * SECTOR_SIZE];
+            unsigned int i;
+
+            if (prev) fat[prev] = cluster;
+            else file->cluster = cluster;
+            prev = cluster;
+
+            for (i = 0; (i < CLUSTER_SIZE) && (offset < file->size); i++)
+                dst[i] = fileData(index, offset++);
+        }
+
+        if (file->fragmented) *nextCluster += rnd() % 3;
+    }
+
+    if (prev) fat[prev] = 0xFFFF;
+
+    memcpy(entry, file->name, 11);
+    // archive
+    entry[0x0B] = 0x20;
+    setWord(&entry[0x1A], file->cluster);
+    setLong(&entry[0x1C], file->size);
+}
+
+static int buildImage(const char *path)
+{
+    unsigned char *pbr;
+    unsigned int nextCluster;
+    unsigned int i;
+    FILE *f;
+
+    image = calloc(TOTAL_SECTORS, SECTOR_SIZE);
+    fat = calloc(FAT_SECTORS * SECTOR_SIZE, 1);
+    if (!image || !fat) return 0;
+
+    // boot sector
+    pbr = image;
+    pbr[0] = 0xEB;
+    pbr[1] = 0x3C;
+    pbr[2] = 0x90;
+    memcpy(&pbr[3], "SGDKTEST", 8);
+    setWord(&pbr[11], SECTOR_SIZE);
+    pbr[13] = SECTOR_PER_CLUSTER;
+    setWord(&pbr[14], RESERVED_SECTORS);
+    pbr[16] = FAT_COPIES;
+    setWord(&pbr[17], ROOT_ENTRIES);
+    setWord(&pbr[19], TOTAL_SECTORS);
+    pbr[21] = 0xF8;
+    setWord(&pbr[22], FAT_SECTORS);
+    pbr[510] = 0x55;
+    pbr[511] = 0xAA;
+
+    fat[0] = 0xFFF8;
+    fat[1] = 0xFFFF;
+    nextCluster = 2;
+    for (i = 0; i < FILE_NUM; i++) addFile(i, &nextCluster);
+
+    // FAT copies (stored little endian)
+    for (i = 0; i < FAT_COPIES; i++)
+    {
+        unsigned char *dst = &image[(RESERVED_SECTORS + (i * FAT_SECTORS)) * SECTOR_SIZE];
+        unsigned int j;
+
+        for (j = 0; j < (FAT_SECTORS * SECTOR_SIZE) / 2; j++)
+            setWord(&dst[j * 2], fat[j]);
+    }
+
+    f = fopen(path, "wb");
+    if (!f)
+    {
+        printf("Couldn't create image file %s\n", path);
+        return 0;
+    }
+    fwrite(image, SECTOR_SIZE, TOTAL_SECTORS, f);
+    fclose(f);
+
+    return 1;
+}
+
+static int checkData(unsigned int index, unsigned int pos, unsigned char *data, unsigned int sectors)
+{
+    unsigned int size = files[index].size;
+    unsigned int end = pos + (sectors * SECTOR_SIZE);
+    unsigned int i;
+
+    if (end > size) end = size;
+
+    for (i = pos; i < end; i++)
+    {
+        if (data[i - pos] != fileData(index, i))
+        {
+            printf("%s: data mismatch at offset %d\n", files[index].name, i);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int testFile(unsigned int index, Fat16Record *rec)
+{
+    static Fat16File file;
+    static Fat16Extent extents[MAX_EXTENT];
+    const unsigned int size = files[index].size;
+    const unsigned int sectors = (size + (SECTOR_SIZE - 1)) / SECTOR_SIZE;
+    unsigned int pos;
+    unsigned int i;
+    int cached;
+    u16 read;
+    u8 res;
+
+    if (rec->size != size)
+    {
+        printf("%s: wrong size %d (expected %d)\n", files[index].name, (int) rec->size, size);
+        return 0;
+    }
+
+    // sector per sector read
+    if (fat16OpenFile(rec, &file)) return 0;
+    pos = 0;
+    while ((res = fat16ReadNextSector(&file)) == 0)
+    {
+        if (!checkData(index, pos, file.sectror_buff, 1)) return 0;
+        pos += SECTOR_SIZE;
+    }
+    if ((res != 1) || (pos < size) || (pos > (sectors * SECTOR_SIZE)))
+    {
+        printf("%s: fat16ReadNextSector failed (%d) at %d\n", files[index].name, res, pos);
+        return 0;
+    }
+
+    for (cached = 0; cached < 2; cached++)
+    {
+        if (fat16OpenFile(rec, &file)) return 0;
+        if (cached && ((res = fat16BuildExtents(&file, extents, MAX_EXTENT)) != 0))
+        {
+            printf("%s: fat16BuildExtents failed (%d)\n", files[index].name, res);
+            return 0;
+        }
+
+        // multi sectors read
+        mmcFileReadCmd = 0;
+        mmcFileReadBlock = 0;
+        pos = 0;
+        while ((res = fat16ReadSectors(&file, readBuffer, 1 + (rnd() % MAX_READ), &read)) == 0)
+        {
+            if (!checkData(index, pos, readBuffer, read)) return 0;
+            pos += read * SECTOR_SIZE;
+            if (pos > size) pos = size;
+            if (file.pos != pos)
+            {
+                printf("%s: wrong position %d (expected %d)\n", files[index].name, (int) file.pos, pos);
+                return 0;
+            }
+        }
+        if ((res != 1) || (pos != size))
+        {
+            printf("%s: fat16ReadSectors failed (%d) at %d\n", files[index].name, res, pos);
+            return 0;
+        }
+        // no FAT table access when extents cache is used
+        if (cached && (mmcFileReadBlock != sectors))
+        {
+            printf("%s: %d sectors read (expected %d)\n", files[index].name, mmcFileReadBlock, sectors);
+            return 0;
+        }
+
+        printf("%s  size=%7d  extents=%3d  blocks=%5d  read commands=%5d\n", files[index].name, size,
+               cached ? file.extent_num : 0, mmcFileReadBlock, mmcFileReadCmd);
+
+        // random seek followed by read / skip
+        for (i = 0; i < 200; i++)
+        {
+            const unsigned int seek = size ? (rnd() * 32768 + rnd()) % (size + 1) : 0;
+            const unsigned int skip = rnd() % 50;
+
+            if (fat16Seek(&file, seek) || (file.pos != (seek & ~(SECTOR_SIZE - 1))))
+            {
+                printf("%s: fat16Seek(%d) failed\n", files[index].name, seek);
+                return 0;
+            }
+            pos = file.pos;
+
+            res = fat16ReadSectors(&file, readBuffer, 1 + (rnd() % 40), &read);
+            if ((res > 1) || (read && !checkData(index, pos, readBuffer, read)))
+            {
+                printf("%s: read after fat16Seek(%d) failed\n", files[index].name, seek);
+                return 0;
+            }
+
+            if (file.pos >= size) continue;
+
+            pos = ((file.pos + (SECTOR_SIZE - 1)) / SECTOR_SIZE) + skip;
+            res = fat16SkipSectors(&file, skip);
+            if (pos > sectors)
+            {
+                if (res != 1)
+                {
+                    printf("%s: fat16SkipSectors past end returned %d\n", files[index].name, res);
+                    return 0;
+                }
+            }
+            else if (res || ((pos < sectors) && (fat16ReadNextSector(&file) || !checkData(index, pos * SECTOR_SIZE, file.sectror_buff, 1))))
+            {
+                printf("%s: fat16SkipSectors(%d) to sector %d failed\n", files[index].name, skip, pos);
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    static Fat16Dir dir;
+    const char *path;
+    unsigned int i;
+    int j;
+    int ok;
+
+    path = (argc > 1) ? argv[1] : "fat16test.img";
+
+    if (!buildImage(path)) return 1;
+    readBuffer = malloc(MAX_READ * SECTOR_SIZE);
+    if (!readBuffer) return 1;
+
+    if (!mmcFileOpen(path)) return 1;
+
+    if (fat16Init())
+    {
+        printf("fat16Init failed\n");
+        return 1;
+    }
+    if (fat16OpenDir(0, &dir))
+    {
+        printf("fat16OpenDir failed\n");
+        return 1;
+    }
+
+    ok = 1;
+    for (i = 0; i < FILE_NUM; i++)
+    {
+        for (j = 0; j < dir.size; j++)
+            if (!memcmp(dir.records[j].name, files[i].name, 11)) break;
+
+        if (j == dir.size)
+        {
+            printf("%s: not found in root directory\n", files[i].name);
+            ok = 0;
+        }
+        else if (!testFile(i, &dir.records[j])) ok = 0;
+    }
+
+    mmcFileClose();
+
+    printf(ok ? "FAT16 test passed\n" : "FAT16 test FAILED\n");
+
+    return ok ? 0 : 1;
+}
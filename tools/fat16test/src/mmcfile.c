@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "types.h"
+#include "everdrive.h"
+
+#include "mmcfile.h"
+
+
+unsigned int mmcFileReadCmd;
+unsigned int mmcFileReadBlock;
+
+static FILE *image = NULL;
+// FAT area, fat16.c reads it as 16 bits words
+static unsigned int fatStart;
+static unsigned int fatEnd;
+
+
+int mmcFileOpen(const char *path)
+{
+    unsigned char pbr[512];
+    unsigned short test = 1;
+
+    image = fopen(path, "rb");
+    if (!image)
+    {
+        printf("Couldn't open image file %s\n", path);
+        return 0;
+    }
+
+    if (fread(pbr, 512, 1, image) != 1)
+    {
+        printf("Couldn't read boot sector of %s\n", path);
+        fclose(image);
+        image = NULL;
+        return 0;
+    }
+
+    // 68000 is big endian so FAT words only need to be swapped on little endian host
+    if (*((unsigned char*) &test) == 1)
+    {
+        unsigned int reserved = pbr[14] | (pbr[15] << 8);
+        unsigned int fatSize = pbr[22] | (pbr[23] << 8);
+
+        fatStart = reserved * 512;
+        fatEnd = fatStart + (fatSize * pbr[16] * 512);
+    }
+    else
+    {
+        fatStart = 0;
+        fatEnd = 0;
+    }
+
+    mmcFileReadCmd = 0;
+    mmcFileReadBlock = 0;
+
+    return 1;
+}
+
+void mmcFileClose()
+{
+    if (image) fclose(image);
+    image = NULL;
+}
+
+
+u8 evd_mmcInit()
+{
+    return image ? 0 : 1;
+}
+
+u8 evd_mmcRdBlocks(u32 mmc_addr, u8 *stor, u16 num)
+{
+    unsigned int addr = mmc_addr;
+    unsigned int i;
+
+    if (!image) return 1;
+    // MMC block access
+    if (addr & 511) return 2;
+
+    // out of image data is read as 0
+    memset(stor, 0, num * 512);
+    if (fseek(image, addr, SEEK_SET) == 0)
+        fread(stor, 512, num, image);
+
+    for (i = 0; i < num * 512; i += 2)
+    {
+        if (((addr + i) >= fatStart) && ((addr + i) < fatEnd))
+        {
+            const u8 t = stor[i];
+            stor[i] = stor[i + 1];
+            stor[i + 1] = t;
+        }
+    }
+
+    mmcFileReadCmd++;
+    mmcFileReadBlock += num;
+
+    return 0;
+}
+
+u8 evd_mmcRdBlock(u32 mmc_addr, u8 *stor)
+{
+    return evd_mmcRdBlocks(mmc_addr, stor, 1);
+}
+
+u8 evd_mmcWrBlock(u32 mmc_addr, u8 *data_ptr)
+{
+    // read only image
+    return 1;
+}
@@ -0,0 +1,14 @@
+#ifndef _MMCFILE_H_
+#define _MMCFILE_H_
+
+#include "types.h"
+
+// host side stand-in for the everdrive MMC layer (evd_mmcXXX methods), blocks are read from a disk image file
+int mmcFileOpen(const char *path);
+void mmcFileClose();
+
+// statistics (reset by mmcFileOpen)
+extern unsigned int mmcFileReadCmd;
+extern unsigned int mmcFileReadBlock;
+
+#endif // _MMCFILE_H_
@@ -4,7 +4,7 @@
 
 extern Plugin bitmap;
 
-void outBitmap(unsigned char* bitmap, int packed, int w, int h, int size, FILE* fs, FILE* fh, char* id, int global);
+void outBitmap(unsigned char* bitmap, int packed, int w, int h, int tiled, int size, FILE* fs, FILE* fh, char* id, int global);
 
 
 #endif // _BITMAP_H_
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "../inc/rescomp.h"
@@ -13,6 +14,7 @@
 // forward
 static int isSupported(char *type);
 static int execute(char *info, FILE *fs, FILE *fh);
+static unsigned char *toTileOrderAndFree(unsigned char* buf8bpp, int w, int h);
 
 // BITMAP resource support
 Plugin bitmap = { isSupported, execute };
@@ -31,24 +33,25 @@ static int execute(char *info, FILE *fs, FILE *fh)
     char id[50];
     char fileIn[MAX_PATH_LEN];
     char packedStr[256];
+    char layoutStr[256];
     int w, h, bpp;
     int isize, psize;
     int packed;
-    int transInd;
+    int tiled;
     int nbElem;
     unsigned char *data;
     unsigned short *palette;
     unsigned char maxIndex;
 
     packed = 0;
-    transInd = 0;
+    strcpy(layoutStr, "LINEAR");
 
-    nbElem = sscanf(info, "%s %s \"%[^\"]\" %s %d", temp, id, temp, packedStr, &transInd);
+    nbElem = sscanf(info, "%s %s \"%[^\"]\" %s %s", temp, id, temp, packedStr, layoutStr);
 
     if (nbElem < 3)
     {
         printf("Wrong BITMAP definition\n");
-        printf("BITMAP name \"file\" [packed]\n");
+        printf("BITMAP name \"file\" [packed [layout]]\n");
         printf("  name      Bitmap variable name\n");
         printf("  file      the image to convert to Bitmap structure (should be a 8bpp .bmp or .png)\n");
         printf("  packed    compression type, accepted values:\n");
@@ -56,6 +59,9 @@ static int execute(char *info, FILE *fs, FILE *fh)
         printf("               0 / NONE        = no compression\n");
         printf("               1 / APLIB       = aplib library (good compression ratio but slow)\n");
         printf("               2 / FAST / LZ4W = custom lz4 compression (average compression ratio but fast)\n");
+        printf("  layout    image data layout, accepted values:\n");
+        printf("               LINEAR = linear pixel rows (default, required for BMP engine)\n");
+        printf("               TILED  = 8x8 tiles order (directly uploaded to VRAM by VDP_drawBitmap(..))\n");
 
         return FALSE;
     }
@@ -64,15 +70,29 @@ static int execute(char *info, FILE *fs, FILE *fh)
     adjustPath(resDir, temp, fileIn);
     // get packed value
     packed = getCompression(packedStr);
+    // get layout
+    tiled = !strcasecmp(layoutStr, "TILED");
 
     // retrieve basic infos about the image
     if (!Img_getInfos(fileIn, &w, &h, &bpp)) return FALSE;
 
-    // adjust bitmap size on pixel pair
-    w = ((w + 1) / 2) * 2;
+    if (tiled)
+    {
+        // adjust bitmap size on tile
+        w = ((w + 7) / 8) * 8;
+        h = ((h + 7) / 8) * 8;
 
-    // get image data (always 8bpp)
-    data = Img_getData(fileIn, &isize, 2, 1);
+        // get image data (always 8bpp)
+        data = Img_getData(fileIn, &isize, 8, 8);
+    }
+    else
+    {
+        // adjust bitmap size on pixel pair
+        w = ((w + 1) / 2) * 2;
+
+        // get image data (always 8bpp)
+        data = Img_getData(fileIn, &isize, 2, 1);
+    }
     if (!data) return FALSE;
 
     // find max color index
@@ -86,6 +106,13 @@ static int execute(char *info, FILE *fs, FILE *fh)
         return FALSE;
     }
 
+    // re-order pixels in 8x8 tiles order
+    if (tiled)
+    {
+        data = toTileOrderAndFree(data, w, h);
+        if (!data) return FALSE;
+    }
+
     // convert to 4BPP
     data = to4bppAndFree(data, isize);
     isize /= 2;
@@ -111,13 +138,45 @@ static int execute(char *info, FILE *fs, FILE *fh)
     outPalette(palette, 0, psize, fs, fh, temp, FALSE);
 
     // EXPORT BITMAP
-    outBitmap(data, packed, w, h, isize, fs, fh, id, TRUE);
+    outBitmap(data, packed, w, h, tiled, isize, fs, fh, id, TRUE);
 
     return TRUE;
 }
 
+static unsigned char *toTileOrderAndFree(unsigned char* buf8bpp, int w, int h)
+{
+    unsigned char *result;
+    unsigned char *dst;
+    int tx, ty, y;
+
+    result = malloc(w * h);
+    if (!result)
+    {
+        printf("Error: cannot allocate memory for tiled bitmap conversion\n");
+        free(buf8bpp);
+        return NULL;
+    }
+
+    dst = result;
+    for(ty = 0; ty < h; ty += 8)
+    {
+        for(tx = 0; tx < w; tx += 8)
+        {
+            for(y = 0; y < 8; y++)
+            {
+                memcpy(dst, &buf8bpp[((ty + y) * w) + tx], 8);
+                dst += 8;
+            }
+        }
+    }
+
+    free(buf8bpp);
+
+    return result;
+}
+
 
-void outBitmap(unsigned char* bitmap, int packed, int w, int h, int size, FILE* fs, FILE* fh, char* id, int global)
+void outBitmap(unsigned char* bitmap, int packed, int w, int h, int tiled, int size, FILE* fs, FILE* fh, char* id, int global)
 {
     char temp[MAX_PATH_LEN];
 
@@ -132,8 +191,8 @@ void outBitmap(unsigned char* bitmap, int packed, int w, int h, int size, FILE*
 
     // output Bitmap structure
     decl(fs, fh, "Bitmap", id, 2, global);
-    // set compression info
-    fprintf(fs, "    dc.w    %d\n", packed);
+    // set compression info (and tiled layout flag, see BITMAP_TILED)
+    fprintf(fs, "    dc.w    %d\n", packed | (tiled?0x8000:0));
     // set size in pixel
     fprintf(fs, "    dc.w    %d, %d\n", w, h);
     // set palette pointer
@@ -0,0 +1,480 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <inttypes.h>
+#include <ctype.h>
+
+// sampling profiler post processing tool
+// maps samples recorded by PROF_startSampling(..) (KDebug log or SRAM dump) against the symbol.txt file
+// produced by the debug build (nm -n) and outputs a flat profile and flame graph compatible folded stacks.
+
+#define MAX_DEPTH           15
+#define SAMPLE_MAGIC        0x50534D50
+#define SAMPLE_HEADER_SIZE  12
+
+
+typedef struct
+{
+    uint32_t addr;
+    char *name;
+    int self;
+    int total;
+    int lastSample;
+} Symbol;
+
+typedef struct
+{
+    char *stack;
+    int count;
+} Stack;
+
+
+static Symbol *symbols = NULL;
+static int numSymbol = 0;
+static Stack *stacks = NULL;
+static int numStack = 0;
+static int maxStack = 0;
+static unsigned char *rom = NULL;
+static long romSize = 0;
+static int numSample = 0;
+static int numRejected = 0;
+
+
+static int compareSymbol(const void *a, const void *b)
+{
+    const Symbol *sa = a;
+    const Symbol *sb = b;
+
+    if (sa->addr < sb->addr) return -1;
+    if (sa->addr > sb->addr) return 1;
+    return 0;
+}
+
+static int compareSelf(const void *a, const void *b)
+{
+    const Symbol *sa = *(const Symbol **) a;
+    const Symbol *sb = *(const Symbol **) b;
+
+    if (sa->self != sb->self) return sb->self - sa->self;
+    return sb->total - sa->total;
+}
+
+static unsigned char *readFile(char *fileName, long *size)
+{
+    FILE *f;
+    unsigned char *result;
+
+    f = fopen(fileName, "rb");
+    if (!f) return NULL;
+
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    result = malloc(*size + 1);
+    if (result)
+    {
+        if (fread(result, 1, *size, f) != (size_t) *size)
+        {
+            free(result);
+            result = NULL;
+        }
+        else result[*size] = 0;
+    }
+
+    fclose(f);
+
+    return result;
+}
+
+static int loadSymbols(char *fileName)
+{
+    FILE *f;
+    char line[1024];
+    int max = 0;
+
+    f = fopen(fileName, "rt");
+    if (!f) return 0;
+
+    while(fgets(line, sizeof(line), f))
+    {
+        unsigned int addr;
+        char type;
+        char name[1024];
+
+        // "00000200 T _start_entry"
+        if (sscanf(line, "%x %c %1023s", &addr, &type, name) != 3) continue;
+        // only keep code symbols
+        if ((type != 'T') && (type != 't') && (type != 'W') && (type != 'w')) continue;
+
+        if (numSymbol >= max)
+        {
+            max = max?max * 2:1024;
+            symbols = realloc(symbols, max * sizeof(Symbol));
+        }
+
+        symbols[numSymbol].addr = addr;
+        symbols[numSymbol].name = strdup(name);
+        symbols[numSymbol].self = 0;
+        symbols[numSymbol].total = 0;
+        symbols[numSymbol].lastSample = -1;
+        numSymbol++;
+    }
+
+    fclose(f);
+
+    qsort(symbols, numSymbol, sizeof(Symbol), compareSymbol);
+
+    return numSymbol;
+}
+
+static Symbol *findSymbol(uint32_t addr)
+{
+    int lo = 0;
+    int hi = numSymbol - 1;
+    Symbol *result = NULL;
+
+    while(lo <= hi)
+    {
+        const int mid = (lo + hi) / 2;
+
+        if (symbols[mid].addr <= addr)
+        {
+            result = &symbols[mid];
+            lo = mid + 1;
+        }
+        else hi = mid - 1;
+    }
+
+    return result;
+}
+
+static int getRomWord(uint32_t addr)
+{
+    if ((addr + 1) >= (uint32_t) romSize) return -1;
+
+    return (rom[addr] << 8) | rom[addr + 1];
+}
+
+// check that instruction before 'addr' is a JSR / BSR (when rom is available)
+static int isReturnAddress(uint32_t addr)
+{
+    int w;
+
+    if (rom == NULL) return 1;
+    if (addr & 1) return 0;
+
+    // bsr.b / jsr (An)
+    w = getRomWord(addr - 2);
+    if ((w != -1) && ((((w & 0xFF00) == 0x6100) && ((w & 0xFF) != 0)) || ((w & 0xFFF8) == 0x4E90))) return 1;
+    // bsr.w / jsr d16(An) / jsr d8(An,Xn) / jsr abs.w / jsr d16(PC) / jsr d8(PC,Xn)
+    w = getRomWord(addr - 4);
+    if ((w != -1) && ((w == 0x6100) || ((w & 0xFFF0) == 0x4EA0) || ((w & 0xFFF8) == 0x4EB0) || (w == 0x4EB8) || (w == 0x4EBA) || (w == 0x4EBB))) return 1;
+    // jsr abs.l
+    w = getRomWord(addr - 6);
+    if ((w != -1) && (w == 0x4EB9)) return 1;
+
+    return 0;
+}
+
+static void addStack(char *stack)
+{
+    int i;
+
+    for(i = 0; i < numStack; i++)
+    {
+        if (!strcmp(stacks[i].stack, stack))
+        {
+            stacks[i].count++;
+            return;
+        }
+    }
+
+    if (numStack >= maxStack)
+    {
+        maxStack = maxStack?maxStack * 2:256;
+        stacks = realloc(stacks, maxStack * sizeof(Stack));
+    }
+
+    stacks[numStack].stack = strdup(stack);
+    stacks[numStack].count = 1;
+    numStack++;
+}
+
+// values[0] = interrupted PC, values[1..] = possible return addresses (innermost first)
+static void addSample(uint32_t *values, int num)
+{
+    Symbol *frames[MAX_DEPTH + 1];
+    char stack[(MAX_DEPTH + 1) * 256];
+    int numFrame;
+    int i;
+
+    numFrame = 0;
+    for(i = 0; i < num; i++)
+    {
+        const uint32_t addr = values[i];
+        Symbol *sym;
+
+        // empty slot
+        if (addr == 0) continue;
+        // stack value which isn't a return address
+        if ((i > 0) && !isReturnAddress(addr))
+        {
+            numRejected++;
+            continue;
+        }
+
+        sym = findSymbol((i > 0)?addr - 2:addr);
+        if (sym) frames[numFrame++] = sym;
+    }
+
+    if (numFrame == 0) return;
+
+    // flat profile
+    frames[0]->self++;
+    for(i = 0; i < numFrame; i++)
+    {
+        // count a function only once per sample (recursion)
+        if (frames[i]->lastSample != numSample)
+        {
+            frames[i]->total++;
+            frames[i]->lastSample = numSample;
+        }
+    }
+
+    // folded stack (outermost first)
+    stack[0] = 0;
+    for(i = numFrame - 1; i >= 0; i--)
+    {
+        strncat(stack, frames[i]->name, 255);
+        if (i) strcat(stack, ";");
+    }
+    addStack(stack);
+
+    numSample++;
+}
+
+static uint32_t getLong(unsigned char *data, int pos, int step)
+{
+    return (data[pos] << 24) | (data[pos + step] << 16) | (data[pos + (2 * step)] << 8) | data[pos + (3 * step)];
+}
+
+static int getWord(unsigned char *data, int pos, int step)
+{
+    return (data[pos] << 8) | data[pos + step];
+}
+
+static int findMagic(unsigned char *data, long size, int step, int start)
+{
+    long i;
+
+    for(i = start; (i + ((SAMPLE_HEADER_SIZE - 1) * step)) < size; i += step)
+    {
+        // magic + version
+        if ((getLong(data, i, step) == SAMPLE_MAGIC) && (getWord(data, i + (4 * step), step) == 1))
+            return i;
+    }
+
+    return -1;
+}
+
+// SRAM dump (emulators store SRAM bytes either contiguous or one byte per word)
+static int loadBinarySamples(unsigned char *data, long size)
+{
+    int pos = -1;
+    int step = 1;
+    int depth, count;
+    int i, j;
+
+    pos = findMagic(data, size, 1, 0);
+    if (pos == -1)
+    {
+        step = 2;
+        pos = findMagic(data, size, 2, 1);
+        if (pos == -1) pos = findMagic(data, size, 2, 0);
+    }
+    if (pos == -1) return 0;
+
+    depth = getWord(data, pos + (6 * step), step);
+    count = getWord(data, pos + (8 * step), step);
+    pos += SAMPLE_HEADER_SIZE * step;
+
+    if (depth > MAX_DEPTH)
+    {
+        printf("Error: invalid sample depth (%d)\n", depth);
+        return 0;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        uint32_t values[MAX_DEPTH + 1];
+
+        if ((pos + ((((depth + 1) * 4) - 1) * step)) >= size)
+        {
+            printf("Warning: sample dump is truncated\n");
+            break;
+        }
+
+        for(j = 0; j <= depth; j++)
+        {
+            values[j] = getLong(data, pos, step);
+            pos += 4 * step;
+        }
+
+        addSample(values, depth + 1);
+    }
+
+    return 1;
+}
+
+// KDebug log ("PS: 0001A2B4 000123F0 ..." lines)
+static int loadTextSamples(char *text)
+{
+    char *line = text;
+    int found = 0;
+
+    while(line && *line)
+    {
+        char *next = strchr(line, '\n');
+        char *s;
+
+        if (next) *next++ = 0;
+
+        s = strstr(line, "PS:");
+        if (s)
+        {
+            uint32_t values[MAX_DEPTH + 1];
+            int num = 0;
+
+            s += 3;
+            while(num <= MAX_DEPTH)
+            {
+                char *end;
+                const unsigned long v = strtoul(s, &end, 16);
+
+                if (end == s) break;
+                values[num++] = v;
+                s = end;
+            }
+
+            if (num)
+            {
+                addSample(values, num);
+                found = 1;
+            }
+        }
+
+        line = next;
+    }
+
+    return found;
+}
+
+
+int main(int argc, char **argv)
+{
+    int ii;
+    char *symbolFileName;
+    char *sampleFileName;
+    char *romFileName;
+    char *foldedFileName;
+    unsigned char *data;
+    long size;
+    Symbol **sorted;
+    int numSorted;
+
+    // default
+    symbolFileName = "";
+    sampleFileName = "";
+    romFileName = "";
+    foldedFileName = "";
+
+    // parse parmeters
+    for (ii=1; ii<argc; ii++)
+    {
+        if (!strcmp(argv[ii], "-rom"))
+        {
+            ii++;
+            if (ii < argc) romFileName = argv[ii];
+        }
+        else if (!strcmp(argv[ii], "-folded"))
+        {
+            ii++;
+            if (ii < argc) foldedFileName = argv[ii];
+        }
+        else if (!symbolFileName[0]) symbolFileName = argv[ii];
+        else if (!sampleFileName[0]) sampleFileName = argv[ii];
+    }
+
+    if (!symbolFileName[0] || !sampleFileName[0])
+    {
+        printf("Sampling profiler tool\n");
+        printf("Usage: sampprof <symbol.txt> <samples> [-rom rom.bin] [-folded out.folded]\n");
+        printf("  symbol.txt  symbol file produced by the debug build (out/symbol.txt)\n");
+        printf("  samples     KDebug log containing PROF_dumpSamples() output or SRAM dump from PROF_saveSamples(..)\n");
+        printf("  -rom        ROM file used to discard stack values which aren't return addresses (recommended)\n");
+        printf("  -folded     write folded stacks for flame graph tools (flamegraph.pl, speedscope...)\n");
+        return 1;
+    }
+
+    if (!loadSymbols(symbolFileName))
+    {
+        printf("Couldn't read symbols from %s\n", symbolFileName);
+        return 1;
+    }
+
+    if (romFileName[0])
+    {
+        rom = readFile(romFileName, &romSize);
+        if (!rom) printf("Warning: couldn't open ROM file %s, return addresses won't be checked\n", romFileName);
+    }
+
+    data = readFile(sampleFileName, &size);
+    if (!data)
+    {
+        printf("Couldn't open sample file %s\n", sampleFileName);
+        return 1;
+    }
+
+    if (!loadBinarySamples(data, size) && !loadTextSamples((char *) data))
+    {
+        printf("No sample found in %s\n", sampleFileName);
+        return 1;
+    }
+
+    // flat profile
+    sorted = malloc(numSymbol * sizeof(Symbol*));
+    numSorted = 0;
+    for(ii = 0; ii < numSymbol; ii++)
+        if (symbols[ii].total) sorted[numSorted++] = &symbols[ii];
+    qsort(sorted, numSorted, sizeof(Symbol*), compareSelf);
+
+    printf("%d samples (%d stack values rejected)\n\n", numSample, numRejected);
+    printf("   self%%    self  total%%   total  function\n");
+    for(ii = 0; ii < numSorted; ii++)
+    {
+        Symbol *sym = sorted[ii];
+
+        printf("%7.2f %7d %7.2f %7d  %s\n", (sym->self * 100.0) / numSample, sym->self, (sym->total * 100.0) / numSample, sym->total, sym->name);
+    }
+
+    // folded stacks
+    if (foldedFileName[0])
+    {
+        FILE *f = fopen(foldedFileName, "wt");
+
+        if (!f)
+        {
+            printf("Couldn't open output file %s\n", foldedFileName);
+            return 1;
+        }
+
+        for(ii = 0; ii < numStack; ii++)
+            fprintf(f, "%s %d\n", stacks[ii].stack, stacks[ii].count);
+
+        fclose(f);
+    }
+
+    return 0;
+}